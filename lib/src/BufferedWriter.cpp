@@ -1,4 +1,7 @@
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
 
 #include "H5Format.hpp"
 #include "BufferedWriter.hpp"
@@ -7,9 +10,11 @@
 using namespace std;
 
 BufferedWriter::BufferedWriter(const std::string& filename, size_t total_frames, unique_ptr<MetadataBuffer>&& metadata_buffer, 
-    hsize_t frames_per_file, hsize_t initial_dataset_size, hsize_t dataset_increase_step) : 
-        H5Writer(filename, frames_per_file, initial_dataset_size, dataset_increase_step), 
-        total_frames(total_frames), metadata_buffer(move(metadata_buffer))
+    hsize_t frames_per_file, hsize_t initial_dataset_size, hsize_t dataset_increase_step, hsize_t frames_per_chunk) : 
+        H5Writer(filename, frames_per_file, initial_dataset_size, dataset_increase_step, frames_per_chunk), 
+        total_frames(total_frames), metadata_buffer(move(metadata_buffer)),
+        metadata_block_n_frames(this->metadata_buffer ? this->metadata_buffer->get_n_images() : 0),
+        header_values_type(this->metadata_buffer ? this->metadata_buffer->get_header_values_type() : nullptr)
 {
     #ifdef DEBUG_OUTPUT
         using namespace date;
@@ -19,41 +24,237 @@ BufferedWriter::BufferedWriter(const std::string& filename, size_t total_frames,
         cout << " and total_frames " << total_frames;
         cout << " and frames_per_file " << frames_per_file;
         cout << " and initial_dataset_size " << initial_dataset_size;
+        cout << " and metadata_block_n_frames " << metadata_block_n_frames;
         cout << endl;
     #endif
+
+    if (this->metadata_buffer && metadata_block_n_frames == 0) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[BufferedWriter::BufferedWriter] The metadata buffer must have space for at least 1 frame." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    // The base class destructor would not write the metadata.
+    close_file();
+}
+
+unique_ptr<H5WriterFile> BufferedWriter::new_writer_file()
+{
+    auto writer_file = unique_ptr<BufferedWriterFile>(new BufferedWriterFile());
+
+    if (metadata_buffer) {
+        writer_file->metadata_buffer = move(metadata_buffer);
+    } else {
+        writer_file->metadata_buffer = unique_ptr<MetadataBuffer>(
+            new MetadataBuffer(metadata_block_n_frames, header_values_type));
+    }
+
+    return move(writer_file);
 }
 
 void BufferedWriter::cache_metadata(string name, uint64_t frame_index, const char* data)
 {
+    LatencyTimer latency_timer(LATENCY_METADATA_CACHE);
+
+    if (!current_file) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[BufferedWriter::cache_metadata] No file is open for frame_index " << frame_index << "." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
     auto relative_frame_index = get_relative_data_index(frame_index);
-    metadata_buffer->add_metadata_to_buffer(name, relative_frame_index, data);
+    auto& writer_file = static_cast<BufferedWriterFile&>(*current_file);
+
+    if (!writer_file.metadata_datasets_created) {
+        create_metadata_datasets(writer_file);
+    }
+
+    // The block of this frame was already written.
+    if (relative_frame_index < writer_file.metadata_block_start) {
+        write_late_metadata(writer_file, name, relative_frame_index, data);
+        return;
+    }
+
+    // First frame of a later block - write the current one and start staging the new one.
+    if (relative_frame_index >= writer_file.metadata_block_start + metadata_block_n_frames) {
+        write_metadata_block(writer_file, writer_file.metadata_block_start + metadata_block_n_frames);
+
+        writer_file.metadata_buffer->clear();
+        writer_file.metadata_block_start = (relative_frame_index / metadata_block_n_frames) * metadata_block_n_frames;
+    }
+
+    writer_file.metadata_buffer->add_metadata_to_buffer(name, relative_frame_index - writer_file.metadata_block_start, data);
 }
 
 void BufferedWriter::write_metadata_to_file()
 {
-    auto header_values_type = metadata_buffer->get_header_values_type();
+    if (current_file) {
+        auto& writer_file = static_cast<BufferedWriterFile&>(*current_file);
+
+        if (!writer_file.metadata_datasets_created) {
+            create_metadata_datasets(writer_file);
+        }
+
+        write_metadata_block(writer_file, writer_file.max_data_index + 1);
+    }
+}
 
+void BufferedWriter::create_metadata_datasets(BufferedWriterFile& writer_file)
+{
     if (header_values_type) {
         for (const auto& header_type : *header_values_type) {
-            auto& dataset_name = header_type.first;
-            auto& header_data_type = header_type.second;
+            vector<size_t> data_shape = {header_type.second.value_shape};
+
+            // One chunk per block of frames.
+            create_dataset(writer_file, header_type.first, data_shape, header_type.second.type, header_type.second.endianness, 
+                true, 0, metadata_block_n_frames);
+        }
+    }
 
-            vector<size_t> data_shape = {header_data_type.value_shape};
+    writer_file.metadata_datasets_created = true;
+}
 
-            create_dataset(dataset_name, data_shape, header_data_type.type, header_data_type.endianness, false, 
-                metadata_buffer->get_n_images());
+void BufferedWriter::expand_metadata_datasets(BufferedWriterFile& writer_file, hsize_t n_frames)
+{
+    if (!header_values_type || n_frames <= writer_file.metadata_datasets_size) {
+        return;
+    }
 
-            H5::AtomType dataset_data_type(H5FormatUtils::get_dataset_data_type(header_data_type.type));
-            dataset_data_type.setOrder(H5T_ORDER_LE);
+    for (const auto& header_type : *header_values_type) {
+        hsize_t dataset_dimension[2] = {n_frames, header_type.second.value_shape};
+        writer_file.datasets.at(header_type.first).extend(dataset_dimension);
+    }
 
-            auto& dataset = datasets.at(dataset_name);
-            dataset.write(metadata_buffer->get_metadata_values(dataset_name).get(), dataset_data_type);
-        }
+    writer_file.metadata_datasets_size = n_frames;
+}
+
+void BufferedWriter::write_metadata_block(BufferedWriterFile& writer_file, hsize_t end_frame)
+{
+    // Only the frames in the metadata buffer.
+    end_frame = min(end_frame, writer_file.metadata_block_start + metadata_block_n_frames);
+
+    if (!header_values_type || end_frame <= writer_file.metadata_block_start) {
+        return;
     }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[BufferedWriter::write_metadata_block] Writing metadata of frames " << writer_file.metadata_block_start;
+        cout << " to " << end_frame << " into " << writer_file.filename << endl;
+    #endif
+
+    expand_metadata_datasets(writer_file, end_frame);
+
+    hsize_t n_frames = end_frame - writer_file.metadata_block_start;
+
+    for (const auto& header_type : *header_values_type) {
+        auto& dataset_name = header_type.first;
+        auto& header_data_type = header_type.second;
+
+        auto& dataset = writer_file.datasets.at(dataset_name);
+
+        hsize_t count[2] = {n_frames, header_data_type.value_shape};
+        hsize_t offset[2] = {writer_file.metadata_block_start, 0};
+
+        auto file_space = dataset.getSpace();
+        file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+        H5::DataSpace memory_space(2, count);
+
+        H5::AtomType dataset_data_type(H5FormatUtils::get_dataset_data_type(header_data_type.type));
+        dataset_data_type.setOrder(H5T_ORDER_LE);
+
+        dataset.write(writer_file.metadata_buffer->get_metadata_values(dataset_name).get(), dataset_data_type, 
+            memory_space, file_space);
+    }
+}
+
+void BufferedWriter::write_late_metadata(BufferedWriterFile& writer_file, const string& name, hsize_t frame_index, 
+    const char* data)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[BufferedWriter::write_late_metadata] Writing late metadata " << name << " of frame " << frame_index << endl;
+    #endif
+
+    auto header_type = header_values_type->find(name);
+
+    if (header_type == header_values_type->end()) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[BufferedWriter::write_late_metadata] Metadata '" << name << "' is not declared." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    expand_metadata_datasets(writer_file, frame_index + 1);
+
+    auto& dataset = writer_file.datasets.at(name);
+
+    hsize_t count[2] = {1, header_type->second.value_shape};
+    hsize_t offset[2] = {frame_index, 0};
+
+    auto file_space = dataset.getSpace();
+    file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+    H5::DataSpace memory_space(2, count);
+
+    H5::AtomType dataset_data_type(H5FormatUtils::get_dataset_data_type(header_type->second.type));
+    dataset_data_type.setOrder(H5T_ORDER_LE);
+
+    dataset.write(data, dataset_data_type, memory_space, file_space);
+}
+
+void BufferedWriter::start_swmr_write(H5WriterFile& writer_file)
+{
+    auto& buffered_writer_file = static_cast<BufferedWriterFile&>(writer_file);
+
+    // No datasets can be created after SWMR write started.
+    if (!buffered_writer_file.metadata_datasets_created) {
+        create_metadata_datasets(buffered_writer_file);
+    }
+
+    H5Writer::start_swmr_write(writer_file);
+}
+
+void BufferedWriter::flush_file(H5WriterFile& writer_file)
+{
+    auto& buffered_writer_file = static_cast<BufferedWriterFile&>(writer_file);
+
+    // The metadata of the frame at max_data_index is cached after the frame is written.
+    write_metadata_block(buffered_writer_file, writer_file.max_data_index);
+
+    H5Writer::flush_file(writer_file);
+}
+
+void BufferedWriter::finalize_file(H5WriterFile& writer_file)
+{
+    auto& buffered_writer_file = static_cast<BufferedWriterFile&>(writer_file);
+
+    if (!buffered_writer_file.metadata_datasets_created) {
+        create_metadata_datasets(buffered_writer_file);
+    }
+
+    write_metadata_block(buffered_writer_file, writer_file.max_data_index + 1);
+    
+    // All frames have metadata rows, also the ones without frames at the end of the file.
+    expand_metadata_datasets(buffered_writer_file, writer_file.max_data_index + 1);
+
+    H5Writer::finalize_file(writer_file);
 }
 
 std::unique_ptr<BufferedWriter> get_buffered_writer(const string& filename, size_t total_frames, 
-    std::unique_ptr<MetadataBuffer> metadata_buffer, hsize_t frames_per_file, hsize_t dataset_increase_step)
+    std::unique_ptr<MetadataBuffer> metadata_buffer, hsize_t frames_per_file, hsize_t dataset_increase_step, hsize_t frames_per_chunk)
 {
     size_t initial_dataset_size = frames_per_file != 0 ? frames_per_file : total_frames;
 
@@ -61,6 +262,6 @@ std::unique_ptr<BufferedWriter> get_buffered_writer(const string& filename, size
         return unique_ptr<BufferedWriter>(new DummyBufferedWriter());
     } else {
         return unique_ptr<BufferedWriter>(new BufferedWriter(filename, total_frames, move(metadata_buffer),
-            frames_per_file, initial_dataset_size, dataset_increase_step));
+            frames_per_file, initial_dataset_size, dataset_increase_step, frames_per_chunk));
     }
 }
\ No newline at end of file
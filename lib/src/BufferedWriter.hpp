@@ -4,14 +4,42 @@
 #include "H5Writer.hpp"
 #include "MetadataBuffer.hpp"
 
+/*
+ * The metadata is staged in a buffer of one block of frames (the metadata buffer size) and written to chunked, 
+ * extendible datasets when the next block starts - the memory use does not depend on the number of frames.
+ */
+struct BufferedWriterFile : public H5WriterFile
+{
+    std::unique_ptr<MetadataBuffer> metadata_buffer;
+    // First frame (relative to the file) in the metadata buffer.
+    hsize_t metadata_block_start = 0;
+    bool metadata_datasets_created = false;
+    hsize_t metadata_datasets_size = 0;
+};
+
 class BufferedWriter : public H5Writer
 {
     size_t total_frames;
+    // Used by the first file - the next files get their own buffer of the same size.
     std::unique_ptr<MetadataBuffer> metadata_buffer;
+    const uint64_t metadata_block_n_frames;
+    const std::shared_ptr<std::unordered_map<std::string, HeaderDataType>> header_values_type;
+
+    void create_metadata_datasets(BufferedWriterFile& writer_file);
+    void expand_metadata_datasets(BufferedWriterFile& writer_file, hsize_t n_frames);
+    void write_metadata_block(BufferedWriterFile& writer_file, hsize_t end_frame);
+    void write_late_metadata(BufferedWriterFile& writer_file, const std::string& name, hsize_t frame_index, const char* data);
+
+    protected:
+        std::unique_ptr<H5WriterFile> new_writer_file() override;
+        void finalize_file(H5WriterFile& writer_file) override;
+        void start_swmr_write(H5WriterFile& writer_file) override;
+        void flush_file(H5WriterFile& writer_file) override;
 
     public:
         BufferedWriter(const std::string& filename, size_t total_frames, std::unique_ptr<MetadataBuffer>&& metadata_buffer, 
-            hsize_t frames_per_file=0, hsize_t initial_dataset_size=1000, hsize_t dataset_increase_step=1000);
+            hsize_t frames_per_file=0, hsize_t initial_dataset_size=1000, hsize_t dataset_increase_step=1000, hsize_t frames_per_chunk=1);
+        virtual ~BufferedWriter();
         virtual void cache_metadata(std::string name, uint64_t frame_index, const char* data);
         virtual void write_metadata_to_file();
 };
@@ -33,10 +61,10 @@ class DummyBufferedWriter : public BufferedWriter, public DummyH5Writer
             { return DummyH5Writer::close_file(); }
 
         void write_data(const std::string& dataset_name, const size_t data_index, const char* data, const std::vector<size_t>& data_shape, 
-            const size_t data_bytes_size, const std::string& data_type, const std::string& endianness) override
+            const size_t data_bytes_size, const std::string& data_type, const std::string& endianness, const uint32_t filter_mask=0) override
         {
             return DummyH5Writer::write_data (
-                dataset_name, data_index, data, data_shape, data_bytes_size, data_type, endianness );
+                dataset_name, data_index, data, data_shape, data_bytes_size, data_type, endianness, filter_mask );
         }
         
         H5::H5File& get_h5_file() override
@@ -47,6 +75,7 @@ class DummyBufferedWriter : public BufferedWriter, public DummyH5Writer
 };
 
 std::unique_ptr<BufferedWriter> get_buffered_writer(const std::string& filename, size_t total_frames, 
-    std::unique_ptr<MetadataBuffer> metadata_buffer, hsize_t frames_per_file=0, hsize_t dataset_increase_step=1000);
+    std::unique_ptr<MetadataBuffer> metadata_buffer, hsize_t frames_per_file=0, hsize_t dataset_increase_step=1000, 
+    hsize_t frames_per_chunk=1);
 
 #endif
\ No newline at end of file
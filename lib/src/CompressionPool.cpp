@@ -0,0 +1,181 @@
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+
+#include "CompressionPool.hpp"
+#include "HeaderDecodePlan.hpp"
+
+using namespace std;
+
+CompressionPool::CompressionPool(RingBuffer& ring_buffer, shared_ptr<const FrameCompressor> frame_compressor, 
+    size_t n_threads, uint32_t read_timeout, FrameReorderWindow* reorder_window) :
+        ring_buffer(ring_buffer), reorder_window(reorder_window), frame_compressor(frame_compressor), read_timeout(read_timeout),
+        frames(n_threads * COMPRESSION_POOL_FRAMES_PER_THREAD)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[CompressionPool::CompressionPool] Starting " << n_threads << " compression threads";
+        cout << " with compression " << frame_compressor->get_name() << endl;
+    #endif
+
+    for (size_t thread_index=0; thread_index<n_threads; thread_index++) {
+        workers.create_thread(boost::bind(&CompressionPool::compress_frames, this));
+    }
+}
+
+CompressionPool::~CompressionPool()
+{
+    {
+        lock_guard<mutex> lock(frames_mutex);
+        stop_flag = true;
+    }
+
+    frame_released.notify_all();
+    workers.join_all();
+}
+
+void CompressionPool::compress_frames()
+{
+    while (true) {
+        size_t sequence;
+        pair<shared_ptr<FrameMetadata>, char*> received_data;
+
+        {
+            lock_guard<mutex> read_lock(ring_buffer_read_mutex);
+
+            // Wait for space in the pool before taking the next frame from the ring buffer.
+            {
+                unique_lock<mutex> lock(frames_mutex);
+
+                frame_released.wait(lock, [this](){
+                    return stop_flag || (next_read_sequence - next_write_sequence) < frames.size();
+                });
+
+                if (stop_flag) {
+                    return;
+                }
+            }
+
+            if (reorder_window) {
+                received_data = reorder_window->read_wait(read_timeout);
+            } else {
+                received_data = ring_buffer.read_wait(read_timeout);
+            }
+
+            if (!received_data.first) {
+                // No more frames will arrive.
+                if (reorder_window ? reorder_window->is_shutdown() : ring_buffer.is_shutdown()) {
+                    return;
+                }
+
+                continue;
+            }
+
+            // The sequence follows the ring buffer order.
+            lock_guard<mutex> lock(frames_mutex);
+            sequence = next_read_sequence++;
+        }
+
+        auto& frame = frames[sequence % frames.size()];
+        const auto& frame_metadata = received_data.first;
+
+        frame.frame_metadata = frame_metadata;
+        frame.frame_data = received_data.second;
+
+        size_t compressed_bytes_size = 0;
+
+        try {
+            size_t element_bytes_size = get_type_byte_size(frame_metadata->type);
+            size_t max_compressed_bytes_size = frame_compressor->get_max_compressed_bytes_size(
+                frame_metadata->frame_bytes_size, element_bytes_size);
+
+            if (frame.buffer.size() < max_compressed_bytes_size) {
+                frame.buffer.resize(max_compressed_bytes_size);
+            }
+
+            compressed_bytes_size = frame_compressor->compress(frame.frame_data, frame_metadata->frame_bytes_size, 
+                element_bytes_size, frame.buffer.data(), frame.buffer.size());
+
+        } catch (const exception& ex) {
+            using namespace date;
+            cout << "[" << std::chrono::system_clock::now() << "]";
+            cout << "[CompressionPool::compress_frames] Cannot compress frame index " << frame_metadata->frame_index;
+            cout << ". Writing it uncompressed. " << ex.what() << endl;
+        }
+
+        if (compressed_bytes_size > 0 && compressed_bytes_size <= frame_metadata->frame_bytes_size) {
+            frame.data = frame.buffer.data();
+            frame.data_bytes_size = compressed_bytes_size;
+            frame.filter_mask = 0;
+
+        } else {
+            // Incompressible - the chunk is stored as it is and the filter skipped when reading.
+            frame.data = frame.frame_data;
+            frame.data_bytes_size = frame_metadata->frame_bytes_size;
+            frame.filter_mask = 1;
+        }
+
+        #ifdef DEBUG_OUTPUT
+            using namespace date;
+            cout << "[" << std::chrono::system_clock::now() << "]";
+            cout << "[CompressionPool::compress_frames] Frame index " << frame_metadata->frame_index;
+            cout << " compressed from " << frame_metadata->frame_bytes_size << " to " << frame.data_bytes_size << " bytes." << endl;
+        #endif
+
+        {
+            lock_guard<mutex> lock(frames_mutex);
+            frame.ready = true;
+        }
+
+        frame_compressed.notify_one();
+    }
+}
+
+const CompressedFrame* CompressionPool::read_wait(uint32_t timeout)
+{
+    unique_lock<mutex> lock(frames_mutex);
+
+    // Frames are returned in order - wait for the oldest one even if newer ones are ready.
+    auto& frame = frames[next_write_sequence % frames.size()];
+
+    frame_compressed.wait_for(lock, chrono::milliseconds(timeout), [&frame](){
+        return frame.ready;
+    });
+
+    if (!frame.ready) {
+        return NULL;
+    }
+
+    return &frame;
+}
+
+void CompressionPool::release()
+{
+    {
+        lock_guard<mutex> lock(frames_mutex);
+
+        auto& frame = frames[next_write_sequence % frames.size()];
+
+        if (!frame.ready) {
+            stringstream error_message;
+            using namespace date;
+            error_message << "[" << std::chrono::system_clock::now() << "]";
+            error_message << "[CompressionPool::release] No compressed frame to release." << endl;
+
+            throw runtime_error(error_message.str());
+        }
+
+        frame.ready = false;
+        frame.frame_metadata.reset();
+        next_write_sequence++;
+    }
+
+    frame_released.notify_all();
+}
+
+bool CompressionPool::is_empty()
+{
+    lock_guard<mutex> lock(frames_mutex);
+    return next_read_sequence == next_write_sequence;
+}
@@ -0,0 +1,76 @@
+#ifndef COMPRESSIONPOOL_H
+#define COMPRESSIONPOOL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <boost/thread.hpp>
+#include <chrono>
+#include "date.h"
+
+#include "RingBuffer.hpp"
+#include "FrameCompressor.hpp"
+#include "FrameReorderWindow.hpp"
+
+// Frames in the pool per worker thread - compressed frames wait for the writer.
+#define COMPRESSION_POOL_FRAMES_PER_THREAD 2
+
+struct CompressedFrame
+{
+    std::shared_ptr<FrameMetadata> frame_metadata;
+    // Frame in the ring buffer slot - release the slot after the frame is written.
+    char* frame_data;
+
+    // What to pass to H5DOwrite_chunk.
+    const char* data;
+    size_t data_bytes_size;
+    // Filter mask 1 skips the compression filter - used for frames that do not compress.
+    uint32_t filter_mask;
+
+    // Compression output, reused for the next frames.
+    std::vector<char> buffer;
+    // Set by the worker when the frame is compressed.
+    bool ready = false;
+};
+
+/*
+ * Compresses the frames from the ring buffer on n_threads worker threads.
+ * The workers take turns reading the ring buffer, the compressed frames are returned by read_wait() in the
+ * ring buffer order. At most n_threads * COMPRESSION_POOL_FRAMES_PER_THREAD frames are in the pool at a time.
+ */
+class CompressionPool
+{
+    RingBuffer& ring_buffer;
+    // Read the frames in frame_index order, if set.
+    FrameReorderWindow* reorder_window;
+    const std::shared_ptr<const FrameCompressor> frame_compressor;
+    const uint32_t read_timeout;
+
+    std::vector<CompressedFrame> frames;
+    // Sequence numbers of the frames - the frame is stored at frames[sequence % frames.size()].
+    size_t next_read_sequence = 0;
+    size_t next_write_sequence = 0;
+
+    std::mutex frames_mutex;
+    std::condition_variable frame_compressed;
+    std::condition_variable frame_released;
+    bool stop_flag = false;
+
+    // Only one worker at a time reads from the ring buffer.
+    std::mutex ring_buffer_read_mutex;
+    boost::thread_group workers;
+
+    void compress_frames();
+
+    public:
+        CompressionPool(RingBuffer& ring_buffer, std::shared_ptr<const FrameCompressor> frame_compressor,
+            size_t n_threads, uint32_t read_timeout, FrameReorderWindow* reorder_window=NULL);
+        virtual ~CompressionPool();
+
+        const CompressedFrame* read_wait(uint32_t timeout);
+        void release();
+        bool is_empty();
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+#include <cstdint>
+
+#include "FrameCompressor.hpp"
+
+#ifdef WITH_BITSHUFFLE
+extern "C"
+{
+    #include "bitshuffle.h"
+}
+#endif
+
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+#ifdef WITH_BITSHUFFLE
+namespace {
+    // The bitshuffle chunk header is stored big endian.
+    void write_big_endian(char* destination, uint64_t value, size_t n_bytes)
+    {
+        for (size_t index=0; index<n_bytes; index++) {
+            destination[n_bytes - index - 1] = static_cast<char>(value & 0xFF);
+            value >>= 8;
+        }
+    }
+}
+
+// Chunk header: uint64 uncompressed size, uint32 block size in bytes.
+#define BITSHUFFLE_CHUNK_HEADER_SIZE 12
+
+string BitshuffleLz4Compressor::get_name() const
+{
+    return "bitshuffle_lz4";
+}
+
+size_t BitshuffleLz4Compressor::get_max_compressed_bytes_size(size_t data_bytes_size, size_t element_bytes_size) const
+{
+    size_t n_elements = data_bytes_size / element_bytes_size;
+
+    return bshuf_compress_lz4_bound(n_elements, element_bytes_size, 0) + BITSHUFFLE_CHUNK_HEADER_SIZE;
+}
+
+size_t BitshuffleLz4Compressor::compress(const char* data, size_t data_bytes_size, size_t element_bytes_size,
+    char* compressed_data, size_t max_compressed_bytes_size) const
+{
+    // Bitshuffle works on whole elements only.
+    if (data_bytes_size % element_bytes_size != 0 ||
+        max_compressed_bytes_size < get_max_compressed_bytes_size(data_bytes_size, element_bytes_size)) {
+        return 0;
+    }
+
+    size_t n_elements = data_bytes_size / element_bytes_size;
+    size_t block_size = bshuf_default_block_size(element_bytes_size);
+
+    // Same header as written by the bitshuffle HDF5 filter.
+    write_big_endian(compressed_data, data_bytes_size, 8);
+    write_big_endian(compressed_data + 8, block_size * element_bytes_size, 4);
+
+    auto compressed_bytes_size = bshuf_compress_lz4(data, compressed_data + BITSHUFFLE_CHUNK_HEADER_SIZE,
+        n_elements, element_bytes_size, block_size);
+
+    if (compressed_bytes_size < 0) {
+        return 0;
+    }
+
+    return compressed_bytes_size + BITSHUFFLE_CHUNK_HEADER_SIZE;
+}
+
+void BitshuffleLz4Compressor::set_dataset_filter(H5::DSetCreatPropList& dataset_properties, size_t element_bytes_size) const
+{
+    // Version, element size, block size (0 = default), compression.
+    const unsigned int cd_values[] = {BSHUF_VERSION_MAJOR, BSHUF_VERSION_MINOR,
+        static_cast<unsigned int>(element_bytes_size), 0, BITSHUFFLE_H5_COMPRESS_LZ4};
+
+    dataset_properties.setFilter(H5_FILTER_BITSHUFFLE, H5Z_FLAG_OPTIONAL, 5, cd_values);
+}
+#endif
+
+#ifdef WITH_ZSTD
+ZstdCompressor::ZstdCompressor(int compression_level) : compression_level(compression_level)
+{
+}
+
+string ZstdCompressor::get_name() const
+{
+    return "zstd";
+}
+
+// Zstd works on bytes - the element size is not needed.
+size_t ZstdCompressor::get_max_compressed_bytes_size(size_t data_bytes_size, size_t) const
+{
+    return ZSTD_compressBound(data_bytes_size);
+}
+
+size_t ZstdCompressor::compress(const char* data, size_t data_bytes_size, size_t,
+    char* compressed_data, size_t max_compressed_bytes_size) const
+{
+    auto compressed_bytes_size = ZSTD_compress(compressed_data, max_compressed_bytes_size,
+        data, data_bytes_size, compression_level);
+
+    if (ZSTD_isError(compressed_bytes_size)) {
+        return 0;
+    }
+
+    return compressed_bytes_size;
+}
+
+void ZstdCompressor::set_dataset_filter(H5::DSetCreatPropList& dataset_properties, size_t) const
+{
+    const unsigned int cd_values[] = {static_cast<unsigned int>(compression_level)};
+
+    dataset_properties.setFilter(H5_FILTER_ZSTD, H5Z_FLAG_OPTIONAL, 1, cd_values);
+}
+#endif
+
+shared_ptr<FrameCompressor> get_frame_compressor(const string& compression_method, int compression_level)
+{
+    if (compression_method == "none") {
+        return NULL;
+    }
+
+    #ifdef WITH_BITSHUFFLE
+        if (compression_method == "bitshuffle_lz4") {
+            return make_shared<BitshuffleLz4Compressor>();
+        }
+    #endif
+
+    #ifdef WITH_ZSTD
+        if (compression_method == "zstd") {
+            return make_shared<ZstdCompressor>(compression_level);
+        }
+    #endif
+
+    stringstream error_message;
+    using namespace date;
+    error_message << "[" << std::chrono::system_clock::now() << "]";
+    error_message << "[get_frame_compressor] Compression method " << compression_method;
+    error_message << " not supported. Check that the library was built with it (WITH_BITSHUFFLE, WITH_ZSTD)." << endl;
+
+    throw runtime_error(error_message.str());
+}
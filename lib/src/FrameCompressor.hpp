@@ -0,0 +1,69 @@
+#ifndef FRAMECOMPRESSOR_H
+#define FRAMECOMPRESSOR_H
+
+#include <string>
+#include <memory>
+#include <H5Cpp.h>
+#include <chrono>
+#include "date.h"
+
+// Registered HDF5 filter ids (https://support.hdfgroup.org/services/filters.html).
+#define H5_FILTER_BITSHUFFLE 32008
+#define H5_FILTER_ZSTD 32015
+
+// Bitshuffle filter compression option for LZ4.
+#define BITSHUFFLE_H5_COMPRESS_LZ4 2
+
+/*
+ * Compresses a frame into the chunk format of an HDF5 filter.
+ * The compressed chunks are written with H5DOwrite_chunk, the dataset needs the matching filter
+ * for the file to be readable by the standard HDF5 filter plugins.
+ * Implementations must be thread safe - compress() is called concurrently by the CompressionPool workers.
+ */
+class FrameCompressor
+{
+    public:
+        virtual ~FrameCompressor(){};
+
+        virtual std::string get_name() const = 0;
+
+        virtual size_t get_max_compressed_bytes_size(size_t data_bytes_size, size_t element_bytes_size) const = 0;
+
+        // Returns the compressed size, 0 if the data could not be compressed.
+        virtual size_t compress(const char* data, size_t data_bytes_size, size_t element_bytes_size,
+            char* compressed_data, size_t max_compressed_bytes_size) const = 0;
+
+        virtual void set_dataset_filter(H5::DSetCreatPropList& dataset_properties, size_t element_bytes_size) const = 0;
+};
+
+#ifdef WITH_BITSHUFFLE
+class BitshuffleLz4Compressor : public FrameCompressor
+{
+    public:
+        std::string get_name() const override;
+        size_t get_max_compressed_bytes_size(size_t data_bytes_size, size_t element_bytes_size) const override;
+        size_t compress(const char* data, size_t data_bytes_size, size_t element_bytes_size,
+            char* compressed_data, size_t max_compressed_bytes_size) const override;
+        void set_dataset_filter(H5::DSetCreatPropList& dataset_properties, size_t element_bytes_size) const override;
+};
+#endif
+
+#ifdef WITH_ZSTD
+class ZstdCompressor : public FrameCompressor
+{
+    const int compression_level;
+
+    public:
+        ZstdCompressor(int compression_level);
+        std::string get_name() const override;
+        size_t get_max_compressed_bytes_size(size_t data_bytes_size, size_t) const override;
+        size_t compress(const char* data, size_t data_bytes_size, size_t,
+            char* compressed_data, size_t max_compressed_bytes_size) const override;
+        void set_dataset_filter(H5::DSetCreatPropList& dataset_properties, size_t) const override;
+};
+#endif
+
+// Returns NULL for compression_method "none".
+std::shared_ptr<FrameCompressor> get_frame_compressor(const std::string& compression_method, int compression_level=0);
+
+#endif
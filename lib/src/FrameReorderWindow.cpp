@@ -0,0 +1,199 @@
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+
+#include "FrameReorderWindow.hpp"
+
+using namespace std;
+
+FrameReorderWindow::FrameReorderWindow(RingBuffer& ring_buffer, size_t window_size, uint32_t lost_frame_timeout, 
+    uint64_t first_frame_index, uint64_t frame_index_stride) :
+        ring_buffer(ring_buffer), window_size(window_size), lost_frame_timeout(lost_frame_timeout), 
+        frame_index_stride(frame_index_stride), next_frame_index(first_frame_index)
+{
+    if (window_size == 0 || frame_index_stride == 0) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[FrameReorderWindow::FrameReorderWindow] Invalid window_size " << window_size;
+        error_message << " or frame_index_stride " << frame_index_stride << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[FrameReorderWindow::FrameReorderWindow] Reorder window with window_size " << window_size;
+        cout << " and lost_frame_timeout " << lost_frame_timeout << " starting at frame_index " << first_frame_index;
+        cout << " with frame_index_stride " << frame_index_stride << endl;
+    #endif
+}
+
+void FrameReorderWindow::set_lost_frames_callback(function<void(uint64_t, uint64_t)> lost_frames_callback)
+{
+    this->lost_frames_callback = lost_frames_callback;
+}
+
+void FrameReorderWindow::set_frames_per_file(uint64_t frames_per_file)
+{
+    this->frames_per_file = frames_per_file;
+}
+
+void FrameReorderWindow::set_dropped_frame_callback(function<void(uint64_t)> dropped_frame_callback)
+{
+    this->dropped_frame_callback = dropped_frame_callback;
+}
+
+uint64_t FrameReorderWindow::get_file_index(uint64_t frame_index) const
+{
+    if (!frames_per_file) {
+        return 0;
+    }
+
+    // The file of the frame in the stripe.
+    return (frame_index / frame_index_stride) / frames_per_file;
+}
+
+void FrameReorderWindow::skip_missing_frames()
+{
+    auto first_held_frame_index = held_frames.begin()->first;
+
+    if (next_frame_index >= first_held_frame_index) {
+        return;
+    }
+
+    // The gap is counted in one step - a large frame_index jump must not loop over every index.
+    uint64_t n_skipped_frames = (first_held_frame_index - next_frame_index + frame_index_stride - 1) / frame_index_stride;
+    uint64_t last_lost_frame_index = next_frame_index + (n_skipped_frames - 1) * frame_index_stride;
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[FrameReorderWindow::skip_missing_frames] Frame index " << next_frame_index << " to ";
+        cout << last_lost_frame_index << " lost." << endl;
+    #endif
+
+    n_lost_frames += n_skipped_frames;
+
+    if (lost_frames_callback) {
+        lost_frames_callback(next_frame_index, last_lost_frame_index);
+    }
+
+    next_frame_index += n_skipped_frames * frame_index_stride;
+}
+
+pair<shared_ptr<FrameMetadata>, char*> FrameReorderWindow::take_next_frame()
+{
+    auto frame = held_frames.begin()->second;
+    file_index = get_file_index(held_frames.begin()->first);
+    held_frames.erase(held_frames.begin());
+
+    next_frame_index += frame_index_stride;
+    wait_start_time = chrono::steady_clock::now();
+
+    return frame;
+}
+
+pair<shared_ptr<FrameMetadata>, char*> FrameReorderWindow::read_wait(uint32_t timeout)
+{
+    auto read_start_time = chrono::steady_clock::now();
+
+    while (true) {
+
+        if (!held_frames.empty()) {
+            if (held_frames.begin()->first == next_frame_index) {
+                return take_next_frame();
+            }
+
+            auto wait_time = chrono::steady_clock::now() - wait_start_time;
+
+            if (held_frames.size() >= window_size || wait_time >= chrono::milliseconds(lost_frame_timeout)) {
+                skip_missing_frames();
+                return take_next_frame();
+            }
+        }
+
+        auto now = chrono::steady_clock::now();
+        auto read_timeout = max<int64_t>(0, timeout - chrono::duration_cast<chrono::milliseconds>(now - read_start_time).count());
+
+        // Do not sleep past the lost frame timeout of the held frames.
+        if (!held_frames.empty()) {
+            auto wait_time = chrono::duration_cast<chrono::milliseconds>(now - wait_start_time).count();
+            read_timeout = min<int64_t>(read_timeout, max<int64_t>(0, lost_frame_timeout - wait_time) + 1);
+        }
+
+        auto received_data = ring_buffer.read_wait(static_cast<uint32_t>(read_timeout));
+
+        if (!received_data.first) {
+            // No more frames will arrive - return the held frames.
+            if (ring_buffer.is_shutdown() && !held_frames.empty()) {
+                skip_missing_frames();
+                return take_next_frame();
+            }
+
+            auto read_time = chrono::steady_clock::now() - read_start_time;
+
+            if (ring_buffer.is_shutdown() || read_time >= chrono::milliseconds(timeout)) {
+                return {NULL, NULL};
+            }
+
+            continue;
+        }
+
+        auto frame_index = received_data.first->frame_index;
+
+        // Its file is already finished - writing it would roll the writer back.
+        if (frame_index < next_frame_index && get_file_index(frame_index) < file_index) {
+
+            #ifdef DEBUG_OUTPUT
+                using namespace date;
+                cout << "[" << std::chrono::system_clock::now() << "]";
+                cout << "[FrameReorderWindow::read_wait] Frame index " << frame_index << " arrived after its file." << endl;
+            #endif
+
+            // Already counted in n_lost_frames when it was declared lost.
+            ring_buffer.release(received_data.first->buffer_slot_index);
+
+            if (dropped_frame_callback) {
+                dropped_frame_callback(frame_index);
+            }
+
+            continue;
+        }
+
+        // Too late (already declared lost) or a duplicate - nothing to wait for.
+        if (frame_index < next_frame_index || held_frames.count(frame_index)) {
+
+            #ifdef DEBUG_OUTPUT
+                using namespace date;
+                cout << "[" << std::chrono::system_clock::now() << "]";
+                cout << "[FrameReorderWindow::read_wait] Frame index " << frame_index << " arrived late." << endl;
+            #endif
+
+            return received_data;
+        }
+
+        if (held_frames.empty()) {
+            wait_start_time = chrono::steady_clock::now();
+        }
+
+        held_frames.emplace(frame_index, received_data);
+    }
+}
+
+bool FrameReorderWindow::is_shutdown() const
+{
+    return held_frames.empty() && ring_buffer.is_shutdown();
+}
+
+size_t FrameReorderWindow::get_n_held_frames() const
+{
+    return held_frames.size();
+}
+
+uint64_t FrameReorderWindow::get_n_lost_frames() const
+{
+    return n_lost_frames;
+}
@@ -0,0 +1,64 @@
+#ifndef FRAMEREORDERWINDOW_H
+#define FRAMEREORDERWINDOW_H
+
+#include <map>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include "date.h"
+
+#include "RingBuffer.hpp"
+
+/*
+ * Returns the frames from the ring buffer in frame_index order.
+ * Frames that arrive early are held (in their ring buffer slot) until the frames before them arrived. A missing frame 
+ * is declared lost when it did not arrive within lost_frame_timeout ms, or when window_size frames are held.
+ * Frames arriving after they were declared lost are returned immediately - unless the writer already moved past their 
+ * file (frames_per_file), then they are released and reported to the dropped frame callback.
+ * Only one thread at a time can read - the frames are released in the ring buffer as before.
+ */
+class FrameReorderWindow
+{
+    RingBuffer& ring_buffer;
+    const size_t window_size;
+    const uint32_t lost_frame_timeout;
+    // Striped writers get every frame_index_stride-th frame.
+    const uint64_t frame_index_stride;
+
+    uint64_t next_frame_index;
+    std::map<uint64_t, std::pair<std::shared_ptr<FrameMetadata>, char*>> held_frames;
+    // Since when the held frames wait for next_frame_index.
+    std::chrono::steady_clock::time_point wait_start_time;
+
+    // First and last lost frame_index - every frame_index_stride-th frame in between is lost.
+    std::function<void(uint64_t, uint64_t)> lost_frames_callback;
+    std::function<void(uint64_t)> dropped_frame_callback;
+    uint64_t n_lost_frames = 0;
+
+    // File of the last frame returned in order - 0 without frames_per_file.
+    uint64_t frames_per_file = 0;
+    uint64_t file_index = 0;
+
+    uint64_t get_file_index(uint64_t frame_index) const;
+
+    // Give up on the frames before the first held frame.
+    void skip_missing_frames();
+    std::pair<std::shared_ptr<FrameMetadata>, char*> take_next_frame();
+
+    public:
+        FrameReorderWindow(RingBuffer& ring_buffer, size_t window_size, uint32_t lost_frame_timeout, 
+            uint64_t first_frame_index=0, uint64_t frame_index_stride=1);
+
+        void set_lost_frames_callback(std::function<void(uint64_t, uint64_t)> lost_frames_callback);
+        // Late frames for files before the one being written are not returned.
+        void set_frames_per_file(uint64_t frames_per_file);
+        void set_dropped_frame_callback(std::function<void(uint64_t)> dropped_frame_callback);
+
+        std::pair<std::shared_ptr<FrameMetadata>, char*> read_wait(uint32_t timeout);
+        // The ring buffer is shut down and no frames are held - check after read_wait returned no frame.
+        bool is_shutdown() const;
+        size_t get_n_held_frames() const;
+        uint64_t get_n_lost_frames() const;
+};
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "config.hpp"
 #include "H5Format.hpp"
+#include "H5FormatPlan.hpp"
 
 using namespace std;
 
@@ -375,17 +376,6 @@ void H5FormatUtils::write_format_data(H5::Group& file_node, const h5_parent& for
 void H5FormatUtils::write_format(H5::H5File& file, const H5Format& format, 
     const std::unordered_map<std::string, h5_value>& input_values)
 {
-    auto format_definition = format.get_format_definition();
-    auto default_values = format.get_default_values();
-
-    auto format_values(default_values);
-    
-    format.add_input_values(format_values, input_values);
-    format.add_calculated_values(format_values);
-    
-    write_format_data(file, format_definition, format_values);
-
-    for (const auto& mapping : format.get_dataset_move_mapping()) {
-        file.move(mapping.first, mapping.second);
-    }
+    // Writers of many files should keep the compiled plan.
+    H5FormatPlan(format).write(file, input_values);
 }
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+
+#include "H5FormatPlan.hpp"
+
+using namespace std;
+
+namespace {
+    // Closes the groups and datasets opened while replaying the plan, also on errors.
+    struct FormatObjects
+    {
+        vector<hid_t> objects;
+        hid_t scalar_space;
+        hid_t string_type;
+
+        FormatObjects(hid_t file_id, size_t n_objects) : objects(n_objects, -1)
+        {
+            objects[0] = file_id;
+
+            scalar_space = H5Screate(H5S_SCALAR);
+            string_type = H5Tcopy(H5T_C_S1);
+            H5Tset_size(string_type, H5T_VARIABLE);
+        }
+
+        ~FormatObjects()
+        {
+            for (size_t object_index=1; object_index<objects.size(); object_index++) {
+                if (objects[object_index] < 0) {
+                    continue;
+                }
+
+                if (H5Iget_type(objects[object_index]) == H5I_GROUP) {
+                    H5Gclose(objects[object_index]);
+                } else {
+                    H5Dclose(objects[object_index]);
+                }
+            }
+
+            H5Tclose(string_type);
+            H5Sclose(scalar_space);
+        }
+    };
+
+    void throw_format_error(const string& message)
+    {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[H5FormatPlan::write] " << message << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    // The value of a string dataset or attribute - string "literals" are stored as const char*.
+    const char* get_string_value(const boost::any& value)
+    {
+        if (auto string_value = boost::any_cast<string>(&value)) {
+            return string_value->c_str();
+        }
+
+        if (auto char_value = boost::any_cast<const char*>(&value)) {
+            return *char_value;
+        }
+
+        return NULL;
+    }
+}
+
+H5FormatPlan::H5FormatPlan(const H5Format& format, bool move_datasets) : format(format)
+{
+    find_calculated_keys();
+    compile_node(format.get_format_definition(), 0);
+
+    // The datasets written by the writer are moved into the format once it is written.
+    if (move_datasets) {
+        for (const auto& mapping : format.get_dataset_move_mapping()) {
+            H5FormatOperation operation;
+            operation.operation_type = FORMAT_MOVE_LINK;
+            operation.name = mapping.first;
+            operation.destination = mapping.second;
+            operation.is_late_bound = true;
+
+            operations.push_back(operation);
+        }
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5FormatPlan::H5FormatPlan] Compiled format into " << operations.size();
+        cout << " operations on " << n_objects << " objects." << endl;
+    #endif
+}
+
+void H5FormatPlan::find_calculated_keys()
+{
+    unordered_map<string, h5_value> calculated_values;
+
+    try {
+        format.add_calculated_values(calculated_values);
+
+    } catch (const exception& ex) {
+        #ifdef DEBUG_OUTPUT
+            using namespace date;
+            cout << "[" << std::chrono::system_clock::now() << "]";
+            cout << "[H5FormatPlan::find_calculated_keys] Calculated values need the input values (" << ex.what();
+            cout << "). All references are late bound." << endl;
+        #endif
+
+        all_references_late_bound = true;
+        return;
+    }
+
+    for (const auto& calculated_value : calculated_values) {
+        calculated_keys.insert(calculated_value.first);
+    }
+}
+
+void H5FormatPlan::compile_node(const h5_parent& format_node, size_t target_index)
+{
+    size_t node_index = target_index;
+
+    if (format_node.node_type == GROUP) {
+        H5FormatOperation operation;
+        operation.operation_type = FORMAT_CREATE_GROUP;
+        operation.target_index = target_index;
+        operation.object_index = n_objects++;
+        operation.name = format_node.name;
+
+        operations.push_back(operation);
+        node_index = operation.object_index;
+    }
+
+    for (const auto& item_ptr : format_node.items) {
+        const h5_base& item = *item_ptr;
+
+        if (item.node_type == GROUP) {
+            compile_node(static_cast<const h5_group&>(item), node_index);
+
+        } else if (item.node_type == ATTRIBUTE) {
+            const auto& attribute = static_cast<const h5_attr&>(item);
+
+            H5FormatOperation operation;
+            operation.operation_type = FORMAT_WRITE_ATTRIBUTE;
+            operation.target_index = node_index;
+            operation.name = attribute.name;
+
+            // Attributes of other types are not written.
+            if (attribute.data_type == NX_CHAR || attribute.data_type == NX_INT) {
+                compile_value(operation, attribute.name, attribute.data_type, attribute.data_location,
+                    attribute.value, true);
+                operations.push_back(operation);
+            }
+
+        } else if (item.node_type == DATASET) {
+            const auto& dataset = static_cast<const h5_dataset&>(item);
+
+            H5FormatOperation operation;
+            operation.operation_type = FORMAT_WRITE_DATASET;
+            operation.target_index = node_index;
+            operation.object_index = n_objects++;
+            operation.name = dataset.name;
+
+            compile_value(operation, dataset.name, dataset.data_type, dataset.data_location, dataset.value, false);
+            operations.push_back(operation);
+            auto dataset_operation_index = operations.size() - 1;
+
+            for (const auto& dataset_attr_ptr : dataset.items) {
+                const h5_base& dataset_attr = *dataset_attr_ptr;
+
+                // You can specify only attributes inside a dataset.
+                if (dataset_attr.node_type != ATTRIBUTE) {
+                    stringstream error_message;
+                    using namespace date;
+                    error_message << "[" << std::chrono::system_clock::now() << "]";
+                    error_message << "Invalid element " << dataset_attr.name << " on dataset " << dataset.name << ". Only attributes allowd.";
+
+                    throw invalid_argument( error_message.str() );
+                }
+
+                const auto& attribute = static_cast<const h5_attr&>(dataset_attr);
+
+                H5FormatOperation attribute_operation;
+                attribute_operation.operation_type = FORMAT_WRITE_ATTRIBUTE;
+                attribute_operation.target_index = operation.object_index;
+                attribute_operation.name = attribute.name;
+
+                if (attribute.data_type == NX_CHAR || attribute.data_type == NX_INT) {
+                    compile_value(attribute_operation, attribute.name, attribute.data_type, attribute.data_location,
+                        attribute.value, true);
+
+                    // The dataset is created with its late bound value.
+                    attribute_operation.is_late_bound |= operation.is_late_bound;
+
+                    if (attribute_operation.is_late_bound && !operation.is_late_bound) {
+                        operations[dataset_operation_index].has_late_attributes = true;
+                    }
+
+                    operations.push_back(attribute_operation);
+                }
+            }
+        }
+    }
+}
+
+void H5FormatPlan::compile_value(H5FormatOperation& operation, const string& node_name, DATA_TYPE data_type,
+    DATA_LOCATION data_location, const boost::any& value, bool is_attribute)
+{
+    const string node_kind = is_attribute ? "attribute " : "dataset ";
+
+    if (data_type == NX_CHAR || data_type == NX_DATE_TIME || data_type == NXnote) {
+        operation.value_type = FORMAT_VALUE_STRING;
+    } else if (data_type == NX_INT) {
+        operation.value_type = FORMAT_VALUE_INT;
+    } else {
+        operation.value_type = FORMAT_VALUE_DOUBLE;
+    }
+
+    // Value in the node is just a string reference into the values map.
+    if (data_location == REFERENCE) {
+        auto reference = get_string_value(value);
+
+        if (!reference) {
+            stringstream error_message;
+            using namespace date;
+            error_message << "[" << std::chrono::system_clock::now() << "]";
+            error_message << "Cannot convert " << node_kind << node_name << " value reference to string." << endl;
+
+            throw runtime_error(error_message.str());
+        }
+
+        operation.is_reference = true;
+        operation.value_reference = reference;
+
+        // Default values overwritten over REST or by the calculated values are late bound as well.
+        const auto& default_values = format.get_default_values();
+        const auto& input_value_type = format.get_input_value_type();
+
+        operation.is_late_bound = all_references_late_bound ||
+            default_values.find(reference) == default_values.end() ||
+            input_value_type.find(reference) != input_value_type.end() ||
+            calculated_keys.find(reference) != calculated_keys.end();
+
+        return;
+    }
+
+    auto string_value = get_string_value(value);
+    auto int_value = boost::any_cast<int>(&value);
+    auto double_value = boost::any_cast<double>(&value);
+
+    if (operation.value_type == FORMAT_VALUE_STRING && string_value) {
+        operation.string_value = string_value;
+    } else if (operation.value_type == FORMAT_VALUE_INT && int_value) {
+        operation.int_value = *int_value;
+    } else if (operation.value_type == FORMAT_VALUE_DOUBLE && double_value) {
+        operation.double_value = *double_value;
+    } else {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "Cannot convert " << node_kind << node_name << " to its data type." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+}
+
+void H5FormatPlan::write_skeleton(H5::H5File& file) const
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5FormatPlan::write_skeleton] Writing format skeleton." << endl;
+    #endif
+
+    replay(file, format.get_default_values(), true, false);
+}
+
+void H5FormatPlan::write(H5::H5File& file, const unordered_map<string, h5_value>& input_values,
+    bool is_skeleton_written) const
+{
+    auto format_values(format.get_default_values());
+
+    format.add_input_values(format_values, input_values);
+    format.add_calculated_values(format_values);
+
+    replay(file, format_values, !is_skeleton_written, true);
+}
+
+void H5FormatPlan::replay(H5::H5File& file, const unordered_map<string, h5_value>& format_values,
+    bool write_skeleton_operations, bool write_late_bound_operations) const
+{
+    FormatObjects format_objects(file.getId(), n_objects);
+    auto& objects = format_objects.objects;
+
+    for (const auto& operation : operations) {
+        hid_t target = objects[operation.target_index];
+
+        if (operation.operation_type == FORMAT_CREATE_GROUP) {
+            // Created already as the parent of a dataset.
+            if (H5Lexists(target, operation.name.c_str(), H5P_DEFAULT) > 0) {
+                objects[operation.object_index] = H5Gopen2(target, operation.name.c_str(), H5P_DEFAULT);
+            } else {
+                objects[operation.object_index] = H5Gcreate2(target, operation.name.c_str(),
+                    H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+            }
+
+            if (objects[operation.object_index] < 0) {
+                throw_format_error("Cannot create group " + operation.name + ".");
+            }
+
+            continue;
+        }
+
+        bool is_written = operation.is_late_bound ? write_late_bound_operations : write_skeleton_operations;
+
+        if (!is_written) {
+            if (operation.operation_type == FORMAT_WRITE_DATASET && operation.has_late_attributes) {
+                objects[operation.object_index] = H5Dopen2(target, operation.name.c_str(), H5P_DEFAULT);
+
+                if (objects[operation.object_index] < 0) {
+                    throw_format_error("Cannot open dataset " + operation.name + ".");
+                }
+            }
+
+            continue;
+        }
+
+        if (operation.operation_type == FORMAT_MOVE_LINK) {
+            if (H5Lmove(target, operation.name.c_str(), target, operation.destination.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0) {
+                throw_format_error("Cannot move " + operation.name + " to " + operation.destination + ".");
+            }
+
+            continue;
+        }
+
+        // Scalar dataset or attribute - resolve the value.
+        const char* string_value = operation.string_value.c_str();
+        const void* value_buffer = NULL;
+        hid_t data_type;
+
+        if (operation.is_reference) {
+            auto value = format_values.find(operation.value_reference);
+
+            if (value == format_values.end()) {
+                throw_format_error("Value reference " + operation.value_reference + " of " + operation.name +
+                    " not present in values map.");
+            }
+
+            if (operation.value_type == FORMAT_VALUE_STRING) {
+                string_value = get_string_value(value->second);
+                value_buffer = string_value ? &string_value : NULL;
+            } else if (operation.value_type == FORMAT_VALUE_INT) {
+                value_buffer = boost::any_cast<int>(&value->second);
+            } else {
+                value_buffer = boost::any_cast<double>(&value->second);
+            }
+
+            if (!value_buffer) {
+                throw_format_error("Cannot convert " + operation.name + " to its data type.");
+            }
+
+        } else if (operation.value_type == FORMAT_VALUE_STRING) {
+            value_buffer = &string_value;
+        } else if (operation.value_type == FORMAT_VALUE_INT) {
+            value_buffer = &operation.int_value;
+        } else {
+            value_buffer = &operation.double_value;
+        }
+
+        if (operation.value_type == FORMAT_VALUE_STRING) {
+            data_type = format_objects.string_type;
+        } else if (operation.value_type == FORMAT_VALUE_INT) {
+            data_type = H5T_NATIVE_INT;
+        } else {
+            data_type = H5T_NATIVE_DOUBLE;
+        }
+
+        if (operation.operation_type == FORMAT_WRITE_DATASET) {
+            hid_t dataset = H5Dcreate2(target, operation.name.c_str(), data_type, format_objects.scalar_space,
+                H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+            if (dataset < 0) {
+                throw_format_error("Cannot create dataset " + operation.name + ".");
+            }
+
+            objects[operation.object_index] = dataset;
+
+            if (H5Dwrite(dataset, data_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, value_buffer) < 0) {
+                throw_format_error("Cannot write dataset " + operation.name + ".");
+            }
+
+        } else {
+            hid_t attribute = H5Acreate2(target, operation.name.c_str(), data_type, format_objects.scalar_space,
+                H5P_DEFAULT, H5P_DEFAULT);
+
+            if (attribute < 0) {
+                throw_format_error("Cannot create attribute " + operation.name + ".");
+            }
+
+            auto write_status = H5Awrite(attribute, data_type, value_buffer);
+            H5Aclose(attribute);
+
+            if (write_status < 0) {
+                throw_format_error("Cannot write attribute " + operation.name + ".");
+            }
+        }
+    }
+}
+
+const vector<H5FormatOperation>& H5FormatPlan::get_operations() const
+{
+    return operations;
+}
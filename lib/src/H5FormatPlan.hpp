@@ -0,0 +1,94 @@
+#ifndef H5FORMATPLAN_H
+#define H5FORMATPLAN_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <H5Cpp.h>
+#include <chrono>
+#include "date.h"
+
+#include "H5Format.hpp"
+
+enum FORMAT_OPERATION_TYPE
+{
+    FORMAT_CREATE_GROUP,
+    FORMAT_WRITE_DATASET,
+    FORMAT_WRITE_ATTRIBUTE,
+    FORMAT_MOVE_LINK
+};
+
+enum FORMAT_VALUE_TYPE
+{
+    FORMAT_VALUE_STRING,
+    FORMAT_VALUE_INT,
+    FORMAT_VALUE_DOUBLE
+};
+
+struct H5FormatOperation
+{
+    FORMAT_OPERATION_TYPE operation_type;
+    // Object the operation works on (group or dataset) - object 0 is the file.
+    size_t target_index = 0;
+    // Object created by FORMAT_CREATE_GROUP and FORMAT_WRITE_DATASET.
+    size_t object_index = 0;
+    // Source path for FORMAT_MOVE_LINK. Groups that already exist are opened.
+    std::string name;
+
+    FORMAT_VALUE_TYPE value_type = FORMAT_VALUE_STRING;
+    // References are looked up in the format values of each file, immediate values are converted once.
+    bool is_reference = false;
+    std::string value_reference;
+    std::string string_value;
+    int int_value = 0;
+    double double_value = 0;
+
+    // Destination path for FORMAT_MOVE_LINK.
+    std::string destination;
+
+    // Needs the values set over REST (or is a move) - not part of the skeleton.
+    bool is_late_bound = false;
+    // Dataset of the skeleton opened again for its late bound attributes.
+    bool has_late_attributes = false;
+};
+
+/*
+ * The H5Format definition compiled into a flat list of operations, replayed on each file.
+ * The format tree is walked only once - writing the format does not copy the definition or the default values tree
+ * and does not throw for value conversions.
+ * The skeleton (groups, immediate and default values) can be written when the file is created, the late bound
+ * values (input and calculated values) when it is closed.
+ */
+class H5FormatPlan
+{
+    const H5Format& format;
+    std::vector<H5FormatOperation> operations;
+    size_t n_objects = 1;
+
+    // Keys set by add_calculated_values - they replace the default values when the file is closed.
+    std::unordered_set<std::string> calculated_keys;
+    // The calculated keys could not be determined without input values - all references are late bound.
+    bool all_references_late_bound = false;
+
+    void find_calculated_keys();
+    void compile_node(const h5_parent& format_node, size_t target_index);
+    void compile_value(H5FormatOperation& operation, const std::string& node_name, DATA_TYPE data_type,
+        DATA_LOCATION data_location, const boost::any& value, bool is_attribute);
+    void replay(H5::H5File& file, const std::unordered_map<std::string, h5_value>& format_values,
+        bool write_skeleton_operations, bool write_late_bound_operations) const;
+
+    public:
+        // Without move_datasets, the writer creates the datasets at their place in the format (H5Writer::set_dataset_path).
+        H5FormatPlan(const H5Format& format, bool move_datasets=true);
+
+        // Only the default values - thread safe, for files created on a helper thread.
+        void write_skeleton(H5::H5File& file) const;
+        // The whole format, or only the late bound values if the skeleton is in the file already.
+        void write(H5::H5File& file, const std::unordered_map<std::string, h5_value>& input_values,
+            bool is_skeleton_written=false) const;
+
+        const std::vector<H5FormatOperation>& get_operations() const;
+};
+
+#endif
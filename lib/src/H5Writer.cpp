@@ -1,6 +1,11 @@
 #include <sstream>
 #include <stdexcept>
 #include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "H5Writer.hpp"
 #include "H5Format.hpp"
@@ -12,11 +17,29 @@ extern "C"
 
 using namespace std;
 
+#ifdef H5_HAVE_DIRECT
+namespace {
+    // Filesystems like tmpfs refuse O_DIRECT. The file created here is truncated by HDF5 afterwards.
+    bool is_direct_io_supported(const string& filename)
+    {
+        int file_descriptor = open(filename.c_str(), O_WRONLY | O_CREAT | O_DIRECT, 0644);
+
+        if (file_descriptor < 0) {
+            return false;
+        }
+
+        close(file_descriptor);
+        return true;
+    }
+}
+#endif
+
 std::unique_ptr<H5Writer> get_h5_writer(
     const string& filename, 
     hsize_t frames_per_file, 
     hsize_t initial_dataset_size, 
-    hsize_t dataset_increase_step)
+    hsize_t dataset_increase_step,
+    hsize_t frames_per_chunk)
 {
     if (filename == "/dev/null") {
         return unique_ptr<H5Writer>(new DummyH5Writer());
@@ -25,7 +48,8 @@ std::unique_ptr<H5Writer> get_h5_writer(
             new H5Writer(filename, 
                          frames_per_file, 
                          initial_dataset_size, 
-                         dataset_increase_step)
+                         dataset_increase_step,
+                         frames_per_chunk)
             );
     }
 }
@@ -34,11 +58,13 @@ H5Writer::H5Writer(
     const std::string& filename, 
     hsize_t frames_per_file, 
     hsize_t initial_dataset_size, 
-    hsize_t dataset_increase_step) :
+    hsize_t dataset_increase_step,
+    hsize_t frames_per_chunk) :
         filename(filename), 
         frames_per_file(frames_per_file), 
         initial_dataset_size(initial_dataset_size),   
-        dataset_increase_step(dataset_increase_step)
+        dataset_increase_step(dataset_increase_step),
+        frames_per_chunk(frames_per_chunk)
 {
     #ifdef DEBUG_OUTPUT
         using namespace date;
@@ -49,8 +75,18 @@ H5Writer::H5Writer(
         cout << " with filename " << filename;
         cout << " and frames_per_file " << frames_per_file;
         cout << " and initial_dataset_size " << initial_dataset_size;
+        cout << " and frames_per_chunk " << frames_per_chunk;
         cout << endl;
     #endif
+
+    if (frames_per_chunk == 0) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[H5Writer::H5Writer] frames_per_chunk must be at least 1." << endl;
+
+        throw runtime_error(error_message.str());
+    }
 }
 
 H5Writer::~H5Writer()
@@ -60,6 +96,9 @@ H5Writer::~H5Writer()
 
 void H5Writer::close_file()
 {
+    // The previous file has to be closed and the prepared one removed before this one.
+    wait_for_file_operations();
+
     if (is_file_open()) {
 
         #ifdef DEBUG_OUTPUT
@@ -69,106 +108,439 @@ void H5Writer::close_file()
             cout << "[H5Writer::close_file] Closing file." << endl;
         #endif
 
-        hsize_t min_frame_in_dataset = 0;
-        if (frames_per_file) {
-            min_frame_in_dataset = (current_frame_chunk - 1) * frames_per_file;
-        }
-
-        // max_data_index is relative to the current file.
-        hsize_t max_frame_in_dataset = max_data_index + min_frame_in_dataset;
-
-        // Frame indexing starts at 1 (for some reason).
-        auto image_nr_low = min_frame_in_dataset + 1;
-        auto image_nr_high = max_frame_in_dataset + 1;
+        finalize_file(*current_file);
 
+    } else {
         #ifdef DEBUG_OUTPUT
             using namespace date;
             using namespace chrono;
 
             cout << "[" << system_clock::now() << "]";
-            cout << "[H5Writer::close_file]";
-            cout << " Setting datasets attribute";
-            cout << " image_nr_low = " << image_nr_low;
-            cout << " and image_nr_high=" << image_nr_high << endl;
+            cout << "[H5Writer::close_file] File already closed." << endl;
         #endif
+    }
+
+    // Cleanup.
+    current_file.reset();
+}
+
+void H5Writer::finalize_file(H5WriterFile& writer_file)
+{
+    hsize_t min_frame_in_dataset = 0;
+    if (frames_per_file) {
+        min_frame_in_dataset = (writer_file.frame_chunk - 1) * frames_per_file;
+    }
+
+    // max_data_index is relative to the file.
+    hsize_t max_frame_in_dataset = writer_file.max_data_index + min_frame_in_dataset;
 
-        for (const auto& dataset_map : datasets) {
-            auto dataset = dataset_map.second;
+    // Frame indexing starts at 1 (for some reason).
+    auto image_nr_low = min_frame_in_dataset + 1;
+    auto image_nr_high = max_frame_in_dataset + 1;
 
-            H5FormatUtils::compact_dataset(dataset, max_data_index);
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        using namespace chrono;
 
-            H5FormatUtils::write_attribute(dataset, 
-                                           "image_nr_low", 
-                                           image_nr_low);
+        cout << "[" << system_clock::now() << "]";
+        cout << "[H5Writer::finalize_file]";
+        cout << " Finalizing file " << writer_file.filename;
+        cout << " with datasets attribute";
+        cout << " image_nr_low = " << image_nr_low;
+        cout << " and image_nr_high=" << image_nr_high << endl;
+    #endif
 
-            H5FormatUtils::write_attribute(dataset, 
-                                           "image_nr_high", 
-                                           image_nr_high);
+    // Write the partially filled chunks - the missing frames stay 0.
+    for (auto& chunk_buffer : writer_file.chunk_buffers) {
+        if (!chunk_buffer.second.written) {
+            flush_chunk_buffer(writer_file, chunk_buffer.first, chunk_buffer.second);
         }
+    }
 
-        file.close();
+    // The file format creates new objects - not possible in SWMR mode.
+    if (writer_file.swmr_write) {
+        end_swmr_write(writer_file);
+    }
 
-    } else {
-        #ifdef DEBUG_OUTPUT
-            using namespace date;
-            using namespace chrono;
+    if (file_finalizer) {
+        file_finalizer(writer_file.file);
+    }
 
-            cout << "[" << system_clock::now() << "]";
-            cout << "[H5Writer::close_file] File already closed." << endl;
-        #endif
+    for (const auto& dataset_map : writer_file.datasets) {
+        auto dataset = dataset_map.second;
+
+        H5FormatUtils::compact_dataset(dataset, writer_file.max_data_index);
+
+        H5FormatUtils::write_attribute(dataset, 
+                                       "image_nr_low", 
+                                       image_nr_low);
+
+        H5FormatUtils::write_attribute(dataset, 
+                                       "image_nr_high", 
+                                       image_nr_high);
     }
 
-    // Cleanup.
-    datasets.clear();
-    datasets_current_size.clear();
+    if (!master_filename.empty()) {
+        for (const auto& dataset_map : writer_file.datasets) {
+            auto& dataset = dataset_map.second;
+            auto& master_file_dataset = master_file_datasets[dataset_map.first];
+            master_file_dataset.data_type = dataset.getDataType();
+
+            auto data_space = dataset.getSpace();
+            int dataset_rank = data_space.getSimpleExtentNdims();
+            hsize_t dataset_dimension[dataset_rank];
+            data_space.getSimpleExtentDims(dataset_dimension);
 
-    current_frame_chunk = 0;
-    max_data_index = 0;
+            master_file_dataset.data_shape.assign(dataset_dimension + 1, dataset_dimension + dataset_rank);
+
+            master_file_dataset.sources.push_back({writer_file.filename, writer_file.max_data_index + 1, 
+                min_frame_in_dataset, 1, dataset.getObjName()});
+        }
+    }
+
+    writer_file.file.close();
+
+    // The files are finalized one at a time - on the helper thread for roll overs.
+    if (!master_filename.empty()) {
+        write_master_file();
+    }
+}
+
+void H5Writer::write_master_file()
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::write_master_file] Writing master file " << master_filename << endl;
+    #endif
+
+    // Readers never see a partially written master file.
+    auto temporary_filename = master_filename + ".tmp";
+
+    {
+        H5::H5File master_file(temporary_filename.c_str(), H5F_ACC_TRUNC);
+
+        if (file_initializer) {
+            file_initializer(master_file);
+        }
+
+        for (const auto& master_file_dataset : master_file_datasets) {
+            VirtualDatasetUtils::create_virtual_dataset(master_file, 
+                                                        get_dataset_path(master_file_dataset.first), 
+                                                        get_dataset_path(master_file_dataset.first), 
+                                                        master_file_dataset.second.data_shape, 
+                                                        master_file_dataset.second.data_type, 
+                                                        master_file_dataset.second.sources);
+        }
+
+        // Same format as the files.
+        if (file_finalizer) {
+            file_finalizer(master_file);
+        }
+    }
+
+    if (rename(temporary_filename.c_str(), master_filename.c_str()) != 0) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[H5Writer::write_master_file] Cannot rename " << temporary_filename;
+        error_message << " to " << master_filename << "." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+}
+
+void H5Writer::start_swmr_write(H5WriterFile& writer_file)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::start_swmr_write] Starting SWMR write on " << writer_file.filename << endl;
+    #endif
+
+    if (H5Fstart_swmr_write(writer_file.file.getId()) < 0) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[H5Writer::start_swmr_write] Cannot start SWMR write on " << writer_file.filename << "." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    writer_file.swmr_write = true;
+    writer_file.last_flush_time = chrono::steady_clock::now();
+}
+
+void H5Writer::flush_file(H5WriterFile& writer_file)
+{
+    // The datasets grow in steps - shrink them to the written frames before the SWMR readers see them.
+    for (auto& dataset_size : writer_file.datasets_current_size) {
+        if (dataset_size.second > writer_file.max_data_index + 1) {
+            auto& dataset = writer_file.datasets.at(dataset_size.first);
+            H5FormatUtils::compact_dataset(dataset, writer_file.max_data_index);
+
+            dataset_size.second = writer_file.max_data_index + 1;
+        }
+    }
+
+    writer_file.file.flush(H5F_SCOPE_LOCAL);
+}
+
+void H5Writer::end_swmr_write(H5WriterFile& writer_file)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::end_swmr_write] Reopening " << writer_file.filename << " without SWMR." << endl;
+    #endif
+
+    // SWMR write cannot be stopped - close the file (with all its datasets) and open it again.
+    vector<string> dataset_names;
+    for (const auto& dataset_map : writer_file.datasets) {
+        dataset_names.push_back(dataset_map.first);
+    }
+
+    writer_file.datasets.clear();
+    writer_file.file.close();
+
+    writer_file.file.openFile(writer_file.filename.c_str(), H5F_ACC_RDWR);
+
+    for (const auto& dataset_name : dataset_names) {
+        writer_file.datasets.insert({dataset_name, writer_file.file.openDataSet(get_dataset_path(dataset_name).c_str())});
+    }
+
+    writer_file.swmr_write = false;
+}
+
+void H5Writer::wait_for_file_operations()
+{
+    // The file prepared for the next frame chunk is not needed anymore.
+    if (next_file.valid()) {
+        try {
+            auto unused_file = next_file.get();
+            unused_file->file.close();
+
+            #ifdef DEBUG_OUTPUT
+                using namespace date;
+                cout << "[" << std::chrono::system_clock::now() << "]";
+                cout << "[H5Writer::wait_for_file_operations] Removing unused file " << unused_file->filename << endl;
+            #endif
+
+            remove(unused_file->filename.c_str());
+
+        } catch (const exception& ex) {
+            using namespace date;
+            cout << "[" << std::chrono::system_clock::now() << "]";
+            cout << "[H5Writer::wait_for_file_operations] Error while preparing the next file: " << ex.what() << endl;
+        }
+    }
+
+    // Errors while closing the previous file are passed on.
+    if (closing_file.valid()) {
+        closing_file.get();
+    }
 }
 
 void H5Writer::write_data(const string& dataset_name, const size_t data_index, const char* data,
-    const std::vector<size_t>& data_shape, const size_t data_bytes_size, const string& data_type, const string& endianness)
+    const std::vector<size_t>& data_shape, const size_t data_bytes_size, const string& data_type, const string& endianness,
+    const uint32_t filter_mask)
 {
     try {
 
         // Define the ofset of the currently received image in the file.
         hsize_t relative_data_index = prepare_storage_for_data(dataset_name, data_index, data_shape, data_type, endianness);
 
-        // Define the offset where to write the data.
-        size_t data_rank = data_shape.size();
-        hsize_t offset[data_rank+1];
+        if (current_file->datasets_frames_per_chunk.at(dataset_name) == 1) {
+            write_chunk(*current_file, dataset_name, relative_data_index, data_shape.size(), data, data_bytes_size, filter_mask);
+        } else {
+            write_to_chunk_buffer(dataset_name, relative_data_index, data_shape.size(), data, data_bytes_size);
+        }
+    } catch (...) {
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::write_data] Error while trying to write data to dataset " << dataset_name << endl; 
         
-        offset[0] = relative_data_index;
-        for (uint index=0; index<data_rank; ++index) {
-            offset[index+1] = 0;
+        throw;
+    }
+}
+
+void H5Writer::write_chunk(H5WriterFile& writer_file, const string& dataset_name, const hsize_t relative_data_index, 
+    const size_t data_rank, const char* data, const size_t data_bytes_size, const uint32_t filter_mask)
+{
+    // Define the offset where to write the data.
+    hsize_t offset[data_rank+1];
+    
+    offset[0] = relative_data_index;
+    for (uint index=0; index<data_rank; ++index) {
+        offset[index+1] = 0;
+    }
+
+    const auto& dataset = writer_file.datasets.at(dataset_name);
+
+    LatencyTimer latency_timer(LATENCY_CHUNK_WRITE);
+
+    // Compressed chunks are passed as they are - filter_mask tells which dataset filters were skipped.
+    if( H5DOwrite_chunk(dataset.getId(), H5P_DEFAULT, filter_mask, offset, data_bytes_size, data) )
+    {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "Error while writing dataset " << dataset_name << " chunk to file at offset ";
+        error_message << relative_data_index << "." << endl;
+
+        throw invalid_argument( error_message.str() );
+    }
+}
+
+void H5Writer::write_to_chunk_buffer(const string& dataset_name, const hsize_t relative_data_index, const size_t data_rank,
+    const char* data, const size_t data_bytes_size)
+{
+    auto& chunk_buffers = current_file->chunk_buffers;
+
+    const hsize_t dataset_frames_per_chunk = current_file->datasets_frames_per_chunk.at(dataset_name);
+    const hsize_t chunk_index = relative_data_index / dataset_frames_per_chunk;
+
+    auto chunk_buffer_iterator = chunk_buffers.find(dataset_name);
+
+    if (chunk_buffer_iterator == chunk_buffers.end()) {
+        ChunkBuffer new_chunk_buffer;
+        new_chunk_buffer.chunk_index = chunk_index;
+        new_chunk_buffer.data_rank = data_rank;
+        new_chunk_buffer.frame_bytes_size = data_bytes_size;
+        new_chunk_buffer.data.resize(dataset_frames_per_chunk * data_bytes_size);
+        new_chunk_buffer.frames_present.resize(dataset_frames_per_chunk, false);
+        new_chunk_buffer.n_frames = 0;
+        new_chunk_buffer.written = false;
+
+        // The fill value in the dataset type, repeated for a whole frame.
+        if (datasets_fill_value.find(dataset_name) != datasets_fill_value.end()) {
+            auto& dataset = current_file->datasets.at(dataset_name);
+            auto dataset_data_type = dataset.getDataType();
+
+            vector<char> fill_value(dataset_data_type.getSize());
+            dataset.getCreatePlist().getFillValue(dataset_data_type, fill_value.data());
+
+            new_chunk_buffer.fill_frame.resize(data_bytes_size);
+            for (size_t index=0; index<data_bytes_size; index++) {
+                new_chunk_buffer.fill_frame[index] = fill_value[index % fill_value.size()];
+            }
         }
 
-        // No compression for now.
-        uint32_t filters = 0;
+        chunk_buffer_iterator = chunk_buffers.insert({dataset_name, move(new_chunk_buffer)}).first;
+    }
+
+    auto& chunk_buffer = chunk_buffer_iterator->second;
+
+    if (data_bytes_size != chunk_buffer.frame_bytes_size) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[H5Writer::write_to_chunk_buffer] Frame size " << data_bytes_size << " of dataset " << dataset_name;
+        error_message << " does not match the previous frames size " << chunk_buffer.frame_bytes_size << "." << endl;
 
-        const auto& dataset = datasets.at(dataset_name);
+        throw runtime_error(error_message.str());
+    }
+
+    // Late frame - its chunk is already in the file.
+    if (chunk_index < chunk_buffer.chunk_index || (chunk_index == chunk_buffer.chunk_index && chunk_buffer.written)) {
+        write_frame(dataset_name, relative_data_index, data);
+        return;
+    }
+
+    // First frame of the next chunk - the current one will not be completed in order.
+    if (chunk_index > chunk_buffer.chunk_index) {
+        if (!chunk_buffer.written) {
+            flush_chunk_buffer(*current_file, dataset_name, chunk_buffer);
+        }
+
+        chunk_buffer.chunk_index = chunk_index;
+        chunk_buffer.n_frames = 0;
+        chunk_buffer.written = false;
         
-        if( H5DOwrite_chunk(dataset.getId(), H5P_DEFAULT, filters, offset, data_bytes_size, data) )
-        {
-            stringstream error_message;
-            using namespace date;
-            error_message << "[" << std::chrono::system_clock::now() << "]";
-            error_message << "Error while writing dataset " << dataset_name << " chunk to file at offset ";
-            error_message << relative_data_index << "." << endl;
+        fill(chunk_buffer.frames_present.begin(), chunk_buffer.frames_present.end(), false);
+    }
+
+    size_t frame_in_chunk = relative_data_index - (chunk_index * dataset_frames_per_chunk);
+
+    memcpy(chunk_buffer.data.data() + (frame_in_chunk * data_bytes_size), data, data_bytes_size);
 
-            throw invalid_argument( error_message.str() );
+    if (!chunk_buffer.frames_present[frame_in_chunk]) {
+        chunk_buffer.frames_present[frame_in_chunk] = true;
+        chunk_buffer.n_frames++;
+    }
+
+    if (chunk_buffer.n_frames == dataset_frames_per_chunk) {
+        flush_chunk_buffer(*current_file, dataset_name, chunk_buffer);
+    }
+}
+
+void H5Writer::flush_chunk_buffer(H5WriterFile& writer_file, const string& dataset_name, ChunkBuffer& chunk_buffer)
+{
+    hsize_t dataset_frames_per_chunk = writer_file.datasets_frames_per_chunk.at(dataset_name);
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::flush_chunk_buffer] Writing chunk " << chunk_buffer.chunk_index << " of dataset " << dataset_name;
+        cout << " with " << chunk_buffer.n_frames << "/" << dataset_frames_per_chunk << " frames." << endl;
+    #endif
+
+    // Missing frames are written as 0 (or the fill value) - they can still arrive later.
+    if (chunk_buffer.n_frames < dataset_frames_per_chunk) {
+        for (size_t frame_in_chunk=0; frame_in_chunk<dataset_frames_per_chunk; frame_in_chunk++) {
+            if (!chunk_buffer.frames_present[frame_in_chunk]) {
+                char* frame_address = chunk_buffer.data.data() + (frame_in_chunk * chunk_buffer.frame_bytes_size);
+
+                if (chunk_buffer.fill_frame.empty()) {
+                    memset(frame_address, 0, chunk_buffer.frame_bytes_size);
+                } else {
+                    memcpy(frame_address, chunk_buffer.fill_frame.data(), chunk_buffer.frame_bytes_size);
+                }
+            }
         }
-    } catch (...) {
+    }
+
+    write_chunk(writer_file, dataset_name, chunk_buffer.chunk_index * dataset_frames_per_chunk, chunk_buffer.data_rank,
+        chunk_buffer.data.data(), chunk_buffer.data.size(), 0);
+
+    chunk_buffer.written = true;
+}
+
+void H5Writer::write_frame(const string& dataset_name, const hsize_t relative_data_index, const char* data)
+{
+    #ifdef DEBUG_OUTPUT
         using namespace date;
         cout << "[" << std::chrono::system_clock::now() << "]";
-        cout << "[H5Writer::write_data] Error while trying to write data to dataset " << dataset_name << endl; 
-        
-        throw;
+        cout << "[H5Writer::write_frame] Writing late frame " << relative_data_index << " of dataset " << dataset_name;
+        cout << " into an already written chunk." << endl;
+    #endif
+
+    auto& dataset = current_file->datasets.at(dataset_name);
+    auto file_space = dataset.getSpace();
+
+    int dataset_rank = file_space.getSimpleExtentNdims();
+    hsize_t count[dataset_rank];
+    hsize_t offset[dataset_rank];
+
+    file_space.getSimpleExtentDims(count);
+    count[0] = 1;
+
+    offset[0] = relative_data_index;
+    for (int index=1; index<dataset_rank; ++index) {
+        offset[index] = 0;
     }
+
+    file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+    H5::DataSpace memory_space(dataset_rank, count);
+
+    LatencyTimer latency_timer(LATENCY_CHUNK_WRITE);
+
+    // The frame is in the file byte order - no conversion.
+    dataset.write(data, dataset.getDataType(), memory_space, file_space);
 }
 
-void H5Writer::create_dataset(const string& dataset_name, const vector<size_t>& data_shape, 
-    const string& data_type, const string& endianness, bool chunked, hsize_t dataset_size)
+void H5Writer::create_dataset(H5WriterFile& writer_file, const string& dataset_name, const vector<size_t>& data_shape, 
+    const string& data_type, const string& endianness, bool chunked, hsize_t dataset_size, hsize_t dataset_frames_per_chunk)
 {
     // Number of dimensions in each data point.
     const size_t data_rank = data_shape.size();
@@ -183,8 +555,15 @@ void H5Writer::create_dataset(const string& dataset_name, const vector<size_t>&
     dataset_dimension[0] = dataset_size;
     // The maximum dataset size is the same as the number of images.
     max_dataset_dimension[0] = dataset_size;
-    // Chunking is always set to a single data point.
-    dataset_chunking[0] = 1;
+    // Compressed frames cannot be aggregated - they are chunks already.
+    if (!dataset_frames_per_chunk) {
+        dataset_frames_per_chunk = frames_per_chunk;
+    }
+    if (datasets_compression.find(dataset_name) != datasets_compression.end()) {
+        dataset_frames_per_chunk = 1;
+    }
+
+    dataset_chunking[0] = dataset_frames_per_chunk;
 
     for (size_t index=0; index<data_rank; ++index) {
         dataset_dimension[index+1] = data_shape[index];
@@ -221,19 +600,38 @@ void H5Writer::create_dataset(const string& dataset_name, const vector<size_t>&
         dataset_data_type.setOrder(H5T_ORDER_LE);
     }
 
-    auto dataset = file.createDataSet(dataset_name.c_str(), dataset_data_type, dataspace, dataset_properties);
+    // Frames that are never written read as the fill value.
+    auto fill_value = datasets_fill_value.find(dataset_name);
+    if (fill_value != datasets_fill_value.end()) {
+        dataset_properties.setFillValue(H5::PredType::NATIVE_DOUBLE, &(fill_value->second));
+    }
+
+    // The chunks are compressed before writing, the filter makes them readable.
+    auto compression = datasets_compression.find(dataset_name);
+    if (chunked && compression != datasets_compression.end()) {
+        compression->second->set_dataset_filter(dataset_properties, dataset_data_type.getSize());
+    }
+
+    // Created where the file format wants it - the groups on the way are created as needed.
+    H5::LinkCreatPropList link_properties;
+    link_properties.setCreateIntermediateGroup(true);
+
+    auto dataset = writer_file.file.createDataSet(get_dataset_path(dataset_name).c_str(), dataset_data_type, dataspace, 
+        dataset_properties, H5::DSetAccPropList::DEFAULT, link_properties);
     
-    datasets.insert({dataset_name, dataset});
-    datasets_current_size.insert({dataset_name, initial_dataset_size});
+    writer_file.datasets.insert({dataset_name, dataset});
+    writer_file.datasets_current_size.insert({dataset_name, dataset_size});
+    writer_file.datasets_frames_per_chunk.insert({dataset_name, chunked ? dataset_frames_per_chunk : 1});
 }
 
-void H5Writer::create_file(hsize_t frame_chunk) 
+unique_ptr<H5WriterFile> H5Writer::new_writer_file()
 {
+    return unique_ptr<H5WriterFile>(new H5WriterFile());
+}
 
-    if (file.getId() != -1) {
-        close_file();
-    }
-
+unique_ptr<H5WriterFile> H5Writer::open_file(const hsize_t frame_chunk, 
+    const unordered_map<string, DatasetDefinition>& datasets_to_create)
+{
     auto target_filename = filename;
 
     // In case frames_per_file is > 0, the filename variable is a template for the filename.
@@ -241,7 +639,7 @@ void H5Writer::create_file(hsize_t frame_chunk)
         #ifdef DEBUG_OUTPUT
             using namespace date;
             cout << "[" << std::chrono::system_clock::now() << "]";
-            cout << "[H5Writer::create_file] Frames per file is defined. Format " << filename << " with frame_chunk " << frame_chunk << endl;
+            cout << "[H5Writer::open_file] Frames per file is defined. Format " << filename << " with frame_chunk " << frame_chunk << endl;
         #endif
 
         // Space for 10 digits should be enough.
@@ -254,12 +652,15 @@ void H5Writer::create_file(hsize_t frame_chunk)
     #ifdef DEBUG_OUTPUT
         using namespace date;
         cout << "[" << std::chrono::system_clock::now() << "]";
-        cout << "[H5Writer::create_file] Creating filename " << target_filename << endl;
+        cout << "[H5Writer::open_file] Creating filename " << target_filename << endl;
     #endif
 
-    file = H5::H5File(target_filename.c_str(), H5F_ACC_TRUNC);
+    auto writer_file = new_writer_file();
 
-    if (file.getId() == -1) {
+    writer_file->file = H5::H5File(target_filename.c_str(), H5F_ACC_TRUNC, 
+        get_file_creation_properties(), get_file_access_properties(target_filename));
+
+    if (writer_file->file.getId() == -1) {
        stringstream error_message;
        using namespace date;
        error_message << "[" << std::chrono::system_clock::now() << "]";
@@ -267,14 +668,111 @@ void H5Writer::create_file(hsize_t frame_chunk)
 
        throw runtime_error(error_message.str());
     }
-    
+
     // New file created - set this files chunk number.
-    current_frame_chunk = frame_chunk;
+    writer_file->filename = target_filename;
+    writer_file->frame_chunk = frame_chunk;
+
+    if (file_initializer) {
+        file_initializer(writer_file->file);
+    }
+
+    for (const auto& dataset_definition : datasets_to_create) {
+        create_dataset(*writer_file,
+                       dataset_definition.first,
+                       dataset_definition.second.data_shape,
+                       dataset_definition.second.data_type,
+                       dataset_definition.second.endianness,
+                       true,
+                       swmr_mode ? 0 : initial_dataset_size);
+    }
+
+    // The datasets are known from the previous file - the readers can follow this file from the start.
+    if (swmr_mode && !datasets_to_create.empty()) {
+        start_swmr_write(*writer_file);
+    }
+
+    return writer_file;
+}
+
+void H5Writer::create_file(hsize_t frame_chunk) 
+{
+    if (is_file_open()) {
+        close_file();
+    }
+
+    current_file = open_file(frame_chunk, {});
+}
+
+void H5Writer::roll_over_file(const hsize_t frame_chunk)
+{
+    LatencyTimer latency_timer(LATENCY_ROLLOVER);
+
+    unique_ptr<H5WriterFile> new_file;
+
+    if (next_file.valid()) {
+        new_file = next_file.get();
+
+        // Frames were skipped - the prepared file is not the one needed.
+        if (new_file->frame_chunk != frame_chunk) {
+            new_file->file.close();
+            remove(new_file->filename.c_str());
+
+            new_file.reset();
+        }
+    }
+
+    // Only one file is finalized at a time.
+    if (closing_file.valid()) {
+        closing_file.get();
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::roll_over_file] Switching to frame_chunk " << frame_chunk;
+        cout << (new_file ? " with prepared file." : " with new file.") << endl;
+    #endif
+
+    if (async_file_rollover && current_file) {
+        // std::async copies the function - the file is shared with the helper thread.
+        shared_ptr<H5WriterFile> finalized_file(current_file.release());
+
+        closing_file = async(launch::async, [this, finalized_file]() {
+            finalize_file(*finalized_file);
+        });
+
+    } else if (current_file) {
+        finalize_file(*current_file);
+        current_file.reset();
+    }
+
+    if (!new_file) {
+        new_file = open_file(frame_chunk, datasets_definition);
+    }
+
+    current_file = move(new_file);
+}
+
+void H5Writer::prepare_next_file()
+{
+    auto next_frame_chunk = current_file->frame_chunk + 1;
+    auto datasets_to_create = datasets_definition;
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::prepare_next_file] Preparing file for frame_chunk " << next_frame_chunk << endl;
+    #endif
+
+    next_file = async(launch::async, [this, next_frame_chunk, datasets_to_create]() {
+        return open_file(next_frame_chunk, datasets_to_create);
+    });
 }
 
 bool H5Writer::is_file_open() const
 {
-    return (file.getId() != -1);
+    return (current_file && current_file->file.getId() != -1);
 }
 
 inline size_t H5Writer::get_relative_data_index(const size_t data_index) 
@@ -296,7 +794,7 @@ inline bool H5Writer::is_data_for_current_file(const size_t data_index)
         hsize_t frame_chunk = (data_index / frames_per_file) + 1;
 
         // This frames does not go into this file.
-        if (frame_chunk != current_frame_chunk) {
+        if (!current_file || frame_chunk != current_file->frame_chunk) {
             return false;
         }
     }
@@ -304,14 +802,36 @@ inline bool H5Writer::is_data_for_current_file(const size_t data_index)
     return true;
 }
 
+bool H5Writer::is_data_for_past_file(const size_t data_index)
+{
+    if (!frames_per_file || !current_file) {
+        return false;
+    }
+
+    hsize_t frame_chunk = (data_index / frames_per_file) + 1;
+
+    return frame_chunk < current_file->frame_chunk;
+}
+
 hsize_t H5Writer::prepare_storage_for_data(const string& dataset_name, const size_t data_index, const std::vector<size_t>& data_shape,
      const string& data_type, const string& endianness) 
 {
+    // Rolling back would truncate the finished file.
+    if (is_data_for_past_file(data_index)) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[H5Writer::prepare_storage_for_data] Cannot write data_index " << data_index;
+        error_message << " - its file was already rolled over to frame_chunk " << current_file->frame_chunk << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
     // Check if we have to create a new file.
     if (!is_data_for_current_file(data_index)) {
         // Calculate to which file (1 based) the data_index belongs.
         hsize_t frame_chunk = (data_index / frames_per_file) + 1;
-        create_file(frame_chunk);
+        roll_over_file(frame_chunk);
     }
 
     // Open the file if needed.
@@ -319,43 +839,337 @@ hsize_t H5Writer::prepare_storage_for_data(const string& dataset_name, const siz
         create_file();
     }
 
+    auto& datasets = current_file->datasets;
+
     // Create the dataset if we don't have it yet.
     if (datasets.find(dataset_name) == datasets.end()) {
-        create_dataset(dataset_name, 
+        if (current_file->swmr_write) {
+            stringstream error_message;
+            using namespace date;
+            error_message << "[" << std::chrono::system_clock::now() << "]";
+            error_message << "[H5Writer::prepare_storage_for_data] Cannot create dataset " << dataset_name;
+            error_message << " in SWMR mode - all datasets have to be written with the first frame." << endl;
+
+            throw runtime_error(error_message.str());
+        }
+
+        create_dataset(*current_file,
+                       dataset_name, 
                        data_shape, 
                        data_type, 
                        endianness, 
                        true, 
-                       initial_dataset_size);
+                       swmr_mode ? 0 : initial_dataset_size);
+
+        // The following files get this dataset when they are created.
+        datasets_definition[dataset_name] = {data_shape, data_type, endianness};
     }
 
-    hsize_t current_dataset_size = datasets_current_size.at(dataset_name);
+    if (swmr_mode && !current_file->swmr_write) {
+        start_swmr_write(*current_file);
+    }
+
+    hsize_t current_dataset_size = current_file->datasets_current_size.at(dataset_name);
 
     hsize_t relative_data_index = get_relative_data_index(data_index);
 
     // Expand the dataset if needed.
-    if (relative_data_index > current_dataset_size) {
+    if (relative_data_index >= current_dataset_size) {
         auto dataset = datasets.at(dataset_name);
 
+        // The SWMR readers get the written size at the next flush_file.
         hsize_t new_dataset_size = H5FormatUtils::expand_dataset(
             dataset, 
             relative_data_index, 
             dataset_increase_step);
 
-        datasets_current_size[dataset_name] = new_dataset_size;
+        current_file->datasets_current_size[dataset_name] = new_dataset_size;
     }
 
     // Max dataset size needed to shring the datasets before closing file.
-    if (relative_data_index > max_data_index) {
-        max_data_index = relative_data_index;
+    if (relative_data_index > current_file->max_data_index) {
+        current_file->max_data_index = relative_data_index;
+    }
+
+    if (current_file->swmr_write) {
+        auto now = chrono::steady_clock::now();
+
+        if (now - current_file->last_flush_time >= chrono::milliseconds(swmr_flush_interval)) {
+            flush_file(*current_file);
+            current_file->last_flush_time = now;
+        }
+    }
+
+    // Create the next file while this one is being written.
+    if (async_file_rollover && frames_per_file && !next_file.valid() && relative_data_index > 0) {
+        prepare_next_file();
     }
 
     return relative_data_index;
 }
 
+void H5Writer::set_dataset_compression(const string& dataset_name, shared_ptr<const FrameCompressor> frame_compressor)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::set_dataset_compression] Dataset " << dataset_name;
+        cout << " compressed with " << frame_compressor->get_name() << endl;
+    #endif
+
+    // Each compressed frame is a chunk on its own - see create_dataset.
+    if (frames_per_chunk > 1) {
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::set_dataset_compression] Dataset " << dataset_name << " is compressed.";
+        cout << " Ignoring frames_per_chunk " << frames_per_chunk << " for it - 1 frame per chunk." << endl;
+    }
+
+    datasets_compression[dataset_name] = frame_compressor;
+}
+
+void H5Writer::set_dataset_fill_value(const string& dataset_name, double fill_value)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::set_dataset_fill_value] Dataset " << dataset_name << " fill value " << fill_value << endl;
+    #endif
+
+    datasets_fill_value[dataset_name] = fill_value;
+}
+
+void H5Writer::set_dataset_path(const string& dataset_name, const string& dataset_path)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::set_dataset_path] Dataset " << dataset_name << " path " << dataset_path << endl;
+    #endif
+
+    datasets_path[dataset_name] = dataset_path;
+}
+
+string H5Writer::get_dataset_path(const string& dataset_name) const
+{
+    auto dataset_path = datasets_path.find(dataset_name);
+
+    if (dataset_path == datasets_path.end()) {
+        return dataset_name;
+    }
+
+    return dataset_path->second;
+}
+
+void H5Writer::set_file_initializer(function<void(H5::H5File&)> file_initializer)
+{
+    this->file_initializer = file_initializer;
+}
+
+void H5Writer::set_file_finalizer(function<void(H5::H5File&)> file_finalizer)
+{
+    this->file_finalizer = file_finalizer;
+}
+
+void H5Writer::set_async_file_rollover(bool async_file_rollover)
+{
+    hbool_t is_threadsafe = false;
+    H5is_library_threadsafe(&is_threadsafe);
+
+    // Without the HDF5 global lock the files cannot be created and closed on the helper thread.
+    if (async_file_rollover && !is_threadsafe) {
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::set_async_file_rollover] HDF5 library is not threadsafe.";
+        cout << " Using synchronous file roll over." << endl;
+
+        async_file_rollover = false;
+    }
+
+    this->async_file_rollover = async_file_rollover;
+}
+
+void H5Writer::set_write_master_file(bool write_master_file)
+{
+    // Only files rolled over have something to put together.
+    if (write_master_file && frames_per_file) {
+        master_filename = VirtualDatasetUtils::get_master_filename(filename);
+    } else {
+        master_filename.clear();
+    }
+}
+
+void H5Writer::set_swmr_mode(bool swmr_mode, uint32_t swmr_flush_interval)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::set_swmr_mode] SWMR mode " << swmr_mode;
+        cout << " with swmr_flush_interval " << swmr_flush_interval << " ms." << endl;
+    #endif
+
+    this->swmr_mode = swmr_mode;
+    this->swmr_flush_interval = swmr_flush_interval;
+}
+
+void H5Writer::set_io_profile(const H5WriterIoProfile& io_profile)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::set_io_profile] alignment " << io_profile.alignment;
+        cout << " alignment_threshold " << io_profile.alignment_threshold;
+        cout << " meta_block_size " << io_profile.meta_block_size;
+        cout << " page_size " << io_profile.page_size;
+        cout << " page_buffer_size " << io_profile.page_buffer_size;
+        cout << " latest_format " << io_profile.latest_format;
+        cout << " metadata_cache_size " << io_profile.metadata_cache_size;
+        cout << " direct_io " << io_profile.direct_io << endl;
+    #endif
+
+    #ifndef H5_HAVE_DIRECT
+        if (io_profile.direct_io) {
+            using namespace date;
+            cout << "[" << std::chrono::system_clock::now() << "]";
+            cout << "[H5Writer::set_io_profile] HDF5 built without the direct VFD. Using sec2." << endl;
+        }
+    #endif
+
+    if (swmr_mode && io_profile.page_buffer_size) {
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[H5Writer::set_io_profile] Page buffer not supported in SWMR mode. Ignoring page_buffer_size." << endl;
+    }
+
+    this->io_profile = io_profile;
+}
+
+H5::FileCreatPropList H5Writer::get_file_creation_properties() const
+{
+    H5::FileCreatPropList file_creation_properties;
+
+    if (io_profile.page_size) {
+        auto properties_id = file_creation_properties.getId();
+
+        if (H5Pset_file_space_strategy(properties_id, H5F_FSPACE_STRATEGY_PAGE, false, 1) < 0 ||
+            H5Pset_file_space_page_size(properties_id, io_profile.page_size) < 0) {
+
+            stringstream error_message;
+            using namespace date;
+            error_message << "[" << std::chrono::system_clock::now() << "]";
+            error_message << "[H5Writer::get_file_creation_properties] Cannot set paged aggregation with page_size ";
+            error_message << io_profile.page_size << "." << endl;
+
+            throw runtime_error(error_message.str());
+        }
+    }
+
+    return file_creation_properties;
+}
+
+H5::FileAccPropList H5Writer::get_file_access_properties(const string& target_filename) const
+{
+    H5::FileAccPropList file_access_properties;
+
+    bool direct_io = false;
+
+    #ifdef H5_HAVE_DIRECT
+        if (io_profile.direct_io) {
+            direct_io = is_direct_io_supported(target_filename);
+
+            if (!direct_io) {
+                using namespace date;
+                cout << "[" << std::chrono::system_clock::now() << "]";
+                cout << "[H5Writer::get_file_access_properties] Cannot open " << target_filename << " with O_DIRECT.";
+                cout << " Using sec2." << endl;
+            }
+        }
+
+        if (direct_io && H5Pset_fapl_direct(file_access_properties.getId(), io_profile.direct_io_alignment, 
+            io_profile.direct_io_alignment, io_profile.direct_io_copy_buffer_size) < 0) {
+
+            stringstream error_message;
+            using namespace date;
+            error_message << "[" << std::chrono::system_clock::now() << "]";
+            error_message << "[H5Writer::get_file_access_properties] Cannot set direct VFD with alignment ";
+            error_message << io_profile.direct_io_alignment << "." << endl;
+
+            throw runtime_error(error_message.str());
+        }
+    #endif
+
+    if (io_profile.alignment) {
+        auto alignment_threshold = io_profile.alignment_threshold ? io_profile.alignment_threshold : io_profile.alignment;
+        file_access_properties.setAlignment(alignment_threshold, io_profile.alignment);
+    } else if (direct_io) {
+        // The chunks are written without the copy buffer.
+        file_access_properties.setAlignment(io_profile.direct_io_alignment, io_profile.direct_io_alignment);
+    }
+
+    if (io_profile.meta_block_size) {
+        auto meta_block_size = io_profile.meta_block_size;
+        file_access_properties.setMetaBlockSize(meta_block_size);
+    }
+
+    // SWMR needs the latest file format.
+    if (io_profile.latest_format || swmr_mode) {
+        file_access_properties.setLibverBounds(H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+    }
+
+    if (io_profile.page_size && io_profile.page_buffer_size && !swmr_mode) {
+        if (H5Pset_page_buffer_size(file_access_properties.getId(), io_profile.page_buffer_size, 0, 0) < 0) {
+            stringstream error_message;
+            using namespace date;
+            error_message << "[" << std::chrono::system_clock::now() << "]";
+            error_message << "[H5Writer::get_file_access_properties] Cannot set page_buffer_size ";
+            error_message << io_profile.page_buffer_size << "." << endl;
+
+            throw runtime_error(error_message.str());
+        }
+    }
+
+    if (io_profile.metadata_cache_size) {
+        H5AC_cache_config_t cache_config;
+        cache_config.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+        H5Pget_mdc_config(file_access_properties.getId(), &cache_config);
+
+        cache_config.set_initial_size = true;
+        cache_config.initial_size = io_profile.metadata_cache_size;
+        cache_config.max_size = io_profile.metadata_cache_size;
+        cache_config.min_size = min(cache_config.min_size, io_profile.metadata_cache_size);
+
+        // Nothing is evicted (written) until the file is closed - the cache grows above max_size if needed.
+        cache_config.evictions_enabled = false;
+        cache_config.incr_mode = H5C_incr__off;
+        cache_config.flash_incr_mode = H5C_flash_incr__off;
+        cache_config.decr_mode = H5C_decr__off;
+
+        if (H5Pset_mdc_config(file_access_properties.getId(), &cache_config) < 0) {
+            stringstream error_message;
+            using namespace date;
+            error_message << "[" << std::chrono::system_clock::now() << "]";
+            error_message << "[H5Writer::get_file_access_properties] Cannot set metadata_cache_size ";
+            error_message << io_profile.metadata_cache_size << "." << endl;
+
+            throw runtime_error(error_message.str());
+        }
+    }
+
+    return file_access_properties;
+}
+
 H5::H5File& H5Writer::get_h5_file() 
 {
-    return file;
+    if (!current_file) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[H5Writer::get_h5_file] No file is open." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    return current_file->file;
 }
 
 H5::H5File& DummyH5Writer::get_h5_file()
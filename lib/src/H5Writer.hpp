@@ -4,10 +4,94 @@
 #include <unordered_map>
 #include <memory>
 #include <vector>
+#include <string>
+#include <functional>
+#include <future>
 #include <H5Cpp.h>
 #include <chrono>
 #include "date.h"
 
+#include "FrameCompressor.hpp"
+#include "VirtualDataset.hpp"
+#include "LatencyMetrics.hpp"
+
+// Chunk of frames being assembled, before it is written as one direct chunk.
+struct ChunkBuffer
+{
+    hsize_t chunk_index;
+    size_t data_rank;
+    size_t frame_bytes_size;
+    std::vector<char> data;
+    std::vector<bool> frames_present;
+    // Written in place of the missing frames - empty to write them as 0.
+    std::vector<char> fill_frame;
+    size_t n_frames;
+    bool written;
+};
+
+// Everything the writer keeps for one open file - switching files is a pointer swap.
+struct H5WriterFile
+{
+    virtual ~H5WriterFile(){};
+
+    H5::H5File file;
+    std::string filename;
+    hsize_t frame_chunk = 0;
+    hsize_t max_data_index = 0;
+
+    // Readers can follow the file while it is written.
+    bool swmr_write = false;
+    std::chrono::steady_clock::time_point last_flush_time;
+
+    std::unordered_map<std::string, H5::DataSet> datasets;
+    std::unordered_map<std::string, hsize_t> datasets_current_size;
+    std::unordered_map<std::string, hsize_t> datasets_frames_per_chunk;
+    std::unordered_map<std::string, ChunkBuffer> chunk_buffers;
+};
+
+// Datasets written with write_data - they are created in advance in the next file.
+struct DatasetDefinition
+{
+    std::vector<size_t> data_shape;
+    std::string data_type;
+    std::string endianness;
+};
+
+// HDF5 file creation and access tuning - 0 (false) keeps the library default.
+struct H5WriterIoProfile
+{
+    // Allocations of at least alignment_threshold bytes (the chunks) start at a multiple of alignment (RAID stripe).
+    // 0 uses the alignment as the threshold.
+    hsize_t alignment = 0;
+    hsize_t alignment_threshold = 0;
+    // Metadata is allocated in blocks of this size, not interleaved with the raw data.
+    hsize_t meta_block_size = 0;
+    // Paged aggregation - the file space is managed in pages, metadata and small raw data in separate pages.
+    // Allocations smaller than a page are not aligned.
+    hsize_t page_size = 0;
+    // Page buffer for paged files (a multiple of page_size) - not used in SWMR mode.
+    size_t page_buffer_size = 0;
+    // Latest file format - always in SWMR mode.
+    bool latest_format = false;
+    // Fixed metadata cache size (at most 128MB), evictions deferred until the file is closed.
+    size_t metadata_cache_size = 0;
+    // O_DIRECT with the HDF5 direct VFD, sec2 if not supported. Without an alignment, the allocations of at least 
+    // direct_io_alignment bytes are aligned to it.
+    bool direct_io = false;
+    size_t direct_io_alignment = 4096;
+    // For the unaligned writes.
+    size_t direct_io_copy_buffer_size = 16 * 1024 * 1024;
+};
+
+// Dataset of the finalized files, mapped into the master file.
+struct MasterFileDataset
+{
+    std::vector<size_t> data_shape;
+    H5::DataType data_type;
+    // The dataset name in each file - the file finalizer can move datasets.
+    std::vector<VirtualDatasetSource> sources;
+};
+
 class H5Writer
 {
     protected:
@@ -16,34 +100,105 @@ class H5Writer
         hsize_t frames_per_file;
         hsize_t initial_dataset_size;
         hsize_t dataset_increase_step = 0;
+        hsize_t frames_per_chunk = 1;
 
         // State variables.
-        hsize_t max_data_index = 0;
-        hsize_t current_frame_chunk = 0;
+        std::unique_ptr<H5WriterFile> current_file;
+
+        // Kept over file roll overs.
+        std::unordered_map<std::string, std::shared_ptr<const FrameCompressor>> datasets_compression;
+        std::unordered_map<std::string, double> datasets_fill_value;
+        std::unordered_map<std::string, std::string> datasets_path;
+        std::unordered_map<std::string, DatasetDefinition> datasets_definition;
+        std::function<void(H5::H5File&)> file_initializer;
+        std::function<void(H5::H5File&)> file_finalizer;
+
+        // File roll over on a helper thread.
+        bool async_file_rollover = false;
+        std::future<std::unique_ptr<H5WriterFile>> next_file;
+        std::future<void> closing_file;
+
+        // Master file with virtual datasets over all finalized files - updated after each file is finalized.
+        std::string master_filename;
+        std::unordered_map<std::string, MasterFileDataset> master_file_datasets;
+
+        void write_master_file();
 
-        H5::H5File file;
-        std::unordered_map<std::string, H5::DataSet> datasets;
-        std::unordered_map<std::string, hsize_t> datasets_current_size;    
+        H5WriterIoProfile io_profile;
+        H5::FileCreatPropList get_file_creation_properties() const;
+        H5::FileAccPropList get_file_access_properties(const std::string& target_filename) const;
+
+        // Single writer multiple readers mode.
+        bool swmr_mode = false;
+        uint32_t swmr_flush_interval = 1000;
+
+        // Called once the datasets of the file exist - no objects can be created afterwards.
+        virtual void start_swmr_write(H5WriterFile& writer_file);
+        // Make what was written so far visible to the readers.
+        virtual void flush_file(H5WriterFile& writer_file);
+        void end_swmr_write(H5WriterFile& writer_file);
         
         hsize_t prepare_storage_for_data(const std::string& dataset_name, const size_t data_index, const std::vector<size_t>& data_shape, 
             const std::string& data_type, const std::string& endianness);
 
-        void create_dataset(const std::string& dataset_name, const std::vector<size_t>& data_shape, 
-            const std::string& data_type, const std::string& endianness, bool chunked, hsize_t dataset_size);
+        void create_dataset(H5WriterFile& writer_file, const std::string& dataset_name, const std::vector<size_t>& data_shape, 
+            const std::string& data_type, const std::string& endianness, bool chunked, hsize_t dataset_size, 
+            hsize_t dataset_frames_per_chunk=0);
         
         size_t get_relative_data_index(const size_t data_index);
 
+        void write_chunk(H5WriterFile& writer_file, const std::string& dataset_name, const hsize_t relative_data_index, 
+            const size_t data_rank, const char* data, const size_t data_bytes_size, const uint32_t filter_mask);
+
+        void write_to_chunk_buffer(const std::string& dataset_name, const hsize_t relative_data_index, const size_t data_rank,
+            const char* data, const size_t data_bytes_size);
+
+        void flush_chunk_buffer(H5WriterFile& writer_file, const std::string& dataset_name, ChunkBuffer& chunk_buffer);
+
+        void write_frame(const std::string& dataset_name, const hsize_t relative_data_index, const char* data);
+
+        // Per file state - extended by derived writers.
+        virtual std::unique_ptr<H5WriterFile> new_writer_file();
+
+        std::unique_ptr<H5WriterFile> open_file(const hsize_t frame_chunk, 
+            const std::unordered_map<std::string, DatasetDefinition>& datasets_to_create);
+
+        // Write everything still missing in the file and close it. Runs on the helper thread for roll overs.
+        virtual void finalize_file(H5WriterFile& writer_file);
+
+        void roll_over_file(const hsize_t frame_chunk);
+
+        void prepare_next_file();
+
+        void wait_for_file_operations();
+
     public:
-        H5Writer(const std::string& filename, hsize_t frames_per_file=0, hsize_t initial_dataset_size=1000, hsize_t dataset_increase_step=1000);
+        H5Writer(const std::string& filename, hsize_t frames_per_file=0, hsize_t initial_dataset_size=1000, hsize_t dataset_increase_step=1000,
+            hsize_t frames_per_chunk=1);
         virtual ~H5Writer();
         virtual bool is_file_open() const;
         virtual void create_file(const hsize_t frame_chunk=1);
         virtual void close_file();
         virtual void write_data(const std::string& dataset_name, const size_t data_index, const char* data, const std::vector<size_t>& data_shape, 
-            const size_t data_bytes_size, const std::string& data_type, const std::string& endianness);
+            const size_t data_bytes_size, const std::string& data_type, const std::string& endianness, const uint32_t filter_mask=0);
         virtual H5::H5File& get_h5_file();
         virtual bool is_data_for_current_file(const size_t data_index);
-        
+        // The frame belongs to a file that was already rolled over - it cannot be written anymore.
+        virtual bool is_data_for_past_file(const size_t data_index);
+        virtual void set_dataset_compression(const std::string& dataset_name, std::shared_ptr<const FrameCompressor> frame_compressor);
+        // Value of the data points that were never written (missing frames). Converted to the dataset type.
+        virtual void set_dataset_fill_value(const std::string& dataset_name, double fill_value);
+        // Where in the file to create the dataset, with the groups on the way - the dataset name by default.
+        virtual void set_dataset_path(const std::string& dataset_name, const std::string& dataset_path);
+        std::string get_dataset_path(const std::string& dataset_name) const;
+        // Called on each new file before the datasets are created - on the helper thread for prepared files.
+        virtual void set_file_initializer(std::function<void(H5::H5File&)> file_initializer);
+        virtual void set_file_finalizer(std::function<void(H5::H5File&)> file_finalizer);
+        virtual void set_async_file_rollover(bool async_file_rollover);
+        virtual void set_write_master_file(bool write_master_file);
+        virtual void set_swmr_mode(bool swmr_mode, uint32_t swmr_flush_interval=1000);
+        // Used for the files created after this call.
+        virtual void set_io_profile(const H5WriterIoProfile& io_profile);
 };
 
 class DummyH5Writer : public H5Writer
@@ -59,7 +214,7 @@ class DummyH5Writer : public H5Writer
         void close_file() override {}
 
         void write_data(const std::string& dataset_name, const size_t data_index, const char* data, const std::vector<size_t>& data_shape, 
-            const size_t data_bytes_size, const std::string& data_type, const std::string& endianness) override {}
+            const size_t data_bytes_size, const std::string& data_type, const std::string& endianness, const uint32_t filter_mask=0) override {}
 
         H5::H5File& get_h5_file() override;
 
@@ -68,6 +223,6 @@ class DummyH5Writer : public H5Writer
 };
 
 std::unique_ptr<H5Writer> get_h5_writer(const std::string& filename, hsize_t frames_per_file=0, 
-    hsize_t initial_dataset_size=1000, hsize_t dataset_increase_step=1000);
+    hsize_t initial_dataset_size=1000, hsize_t dataset_increase_step=1000, hsize_t frames_per_chunk=1);
 
 #endif
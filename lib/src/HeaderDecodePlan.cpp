@@ -0,0 +1,192 @@
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "HeaderDecodePlan.hpp"
+
+using namespace std;
+namespace pt = boost::property_tree;
+
+namespace {
+    template <typename T>
+    void convert_number(char* destination, const char* number, bool is_integer, bool is_negative)
+    {
+        T value;
+
+        if (!is_integer) {
+            value = static_cast<T>(strtod(number, NULL));
+        } else if (is_negative) {
+            value = static_cast<T>(strtoll(number, NULL, 10));
+        } else {
+            value = static_cast<T>(strtoull(number, NULL, 10));
+        }
+
+        memcpy(destination, &value, sizeof(T));
+    }
+
+    template <typename T>
+    void convert_ptree(char* destination, const pt::ptree& json_value)
+    {
+        auto value = json_value.get_value<T>();
+        memcpy(destination, &value, sizeof(T));
+    }
+
+    template <typename T>
+    void set_converters(HeaderValueField& field)
+    {
+        field.convert_number = &convert_number<T>;
+        field.convert_ptree = &convert_ptree<T>;
+    }
+}
+
+HeaderDataType::HeaderDataType(const std::string& type, size_t shape) : 
+    type(type), value_shape(shape), endianness("little"), is_array(true) {
+        value_bytes_size = get_type_byte_size(type);
+}
+
+HeaderDataType::HeaderDataType(const std::string& type) : 
+    type(type), value_shape(1), endianness("little"), is_array(false) {
+        value_bytes_size = get_type_byte_size(type);
+}
+
+size_t get_type_byte_size(const string& type)
+{
+    if (type == "uint8" || type== "int8") {
+        return 1;
+
+    } else if (type == "uint16" || type == "int16") {
+        return 2;
+
+    } else if (type == "uint32" || type == "int32" || type == "float32") {
+        return 4;
+
+    } else if (type == "uint64" || type == "int64" || type == "float64") {
+        return 8;
+
+    } else {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[HeaderDecodePlan::get_type_byte_size] Unsupported data type " << type << endl;
+
+        throw runtime_error(error_message.str());
+    }
+}
+
+HEADER_VALUE_TYPE get_header_value_type(const string& type)
+{
+    if (type == "uint8") {
+        return HEADER_UINT8;
+    } else if (type == "uint16") {
+        return HEADER_UINT16;
+    } else if (type == "uint32") {
+        return HEADER_UINT32;
+    } else if (type == "uint64") {
+        return HEADER_UINT64;
+    } else if (type == "int8") {
+        return HEADER_INT8;
+    } else if (type == "int16") {
+        return HEADER_INT16;
+    } else if (type == "int32") {
+        return HEADER_INT32;
+    } else if (type == "int64") {
+        return HEADER_INT64;
+    } else if (type == "float32") {
+        return HEADER_FLOAT32;
+    } else if (type == "float64") {
+        return HEADER_FLOAT64;
+    } else {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[HeaderDecodePlan::get_header_value_type] Unsupported header data type " << type << endl;
+
+        throw runtime_error(error_message.str());
+    }
+}
+
+HeaderDecodePlan::HeaderDecodePlan(shared_ptr<unordered_map<string, HeaderDataType>> header_values_type)
+{
+    if (!header_values_type) {
+        return;
+    }
+
+    for (const auto& value_mapping : *header_values_type) {
+        const auto& header_data_type = value_mapping.second;
+
+        HeaderValueField field;
+        field.name = value_mapping.first;
+        field.type = get_header_value_type(header_data_type.type);
+        field.value_shape = header_data_type.value_shape;
+        field.value_bytes_size = header_data_type.value_bytes_size;
+        field.is_array = header_data_type.is_array;
+
+        switch (field.type) {
+            case HEADER_UINT8: set_converters<uint8_t>(field); break;
+            case HEADER_UINT16: set_converters<uint16_t>(field); break;
+            case HEADER_UINT32: set_converters<uint32_t>(field); break;
+            case HEADER_UINT64: set_converters<uint64_t>(field); break;
+            case HEADER_INT8: set_converters<int8_t>(field); break;
+            case HEADER_INT16: set_converters<int16_t>(field); break;
+            case HEADER_INT32: set_converters<int32_t>(field); break;
+            case HEADER_INT64: set_converters<int64_t>(field); break;
+            case HEADER_FLOAT32: set_converters<float>(field); break;
+            case HEADER_FLOAT64: set_converters<double>(field); break;
+        }
+
+        fields.push_back(field);
+    }
+
+    // Deterministic record layout, independent of the map iteration order.
+    sort(fields.begin(), fields.end(), [](const HeaderValueField& a, const HeaderValueField& b){
+        return a.name < b.name;
+    });
+
+    for (size_t field_id=0; field_id<fields.size(); field_id++) {
+        auto& field = fields[field_id];
+
+        field.field_id = field_id;
+        field.offset = record_bytes_size;
+
+        record_bytes_size += field.value_bytes_size * field.value_shape;
+    }
+}
+
+const vector<HeaderValueField>& HeaderDecodePlan::get_fields() const
+{
+    return fields;
+}
+
+const HeaderValueField* HeaderDecodePlan::find_field(const char* name, size_t name_length) const
+{
+    for (const auto& field : fields) {
+        if (field.name.length() == name_length && memcmp(field.name.data(), name, name_length) == 0) {
+            return &field;
+        }
+    }
+
+    return NULL;
+}
+
+const HeaderValueField& HeaderDecodePlan::get_field(const string& name) const
+{
+    auto field = find_field(name.data(), name.length());
+
+    if (!field) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[HeaderDecodePlan::get_field] Header value " << name << " is not declared." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    return *field;
+}
+
+size_t HeaderDecodePlan::get_record_bytes_size() const
+{
+    return record_bytes_size;
+}
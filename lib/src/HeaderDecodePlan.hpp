@@ -0,0 +1,80 @@
+#ifndef HEADERDECODEPLAN_H
+#define HEADERDECODEPLAN_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include "date.h"
+
+struct HeaderDataType
+{
+    std::string type;
+    size_t value_shape;
+    std::string endianness;
+    size_t value_bytes_size;
+    bool is_array;
+
+    HeaderDataType(const std::string& type);
+    HeaderDataType(const std::string& type, size_t shape);
+};
+
+size_t get_type_byte_size(const std::string& type);
+
+enum HEADER_VALUE_TYPE
+{
+    HEADER_UINT8,
+    HEADER_UINT16,
+    HEADER_UINT32,
+    HEADER_UINT64,
+    HEADER_INT8,
+    HEADER_INT16,
+    HEADER_INT32,
+    HEADER_INT64,
+    HEADER_FLOAT32,
+    HEADER_FLOAT64
+};
+
+HEADER_VALUE_TYPE get_header_value_type(const std::string& type);
+
+// Convert a null terminated JSON number literal to the field type.
+typedef void (*number_converter)(char* destination, const char* number, bool is_integer, bool is_negative);
+// Convert a property tree value to the field type.
+typedef void (*ptree_converter)(char* destination, const boost::property_tree::ptree& json_value);
+
+struct HeaderValueField
+{
+    std::string name;
+    size_t field_id;
+    HEADER_VALUE_TYPE type;
+    // Location of the value in the per frame header values record.
+    size_t offset;
+    size_t value_shape;
+    size_t value_bytes_size;
+    bool is_array;
+
+    number_converter convert_number;
+    ptree_converter convert_ptree;
+};
+
+/*
+ * Layout and converters of the header values, resolved once from the header values type definition.
+ * The decoded values of a frame are stored in one contiguous record of get_record_bytes_size() bytes.
+ */
+class HeaderDecodePlan
+{
+    std::vector<HeaderValueField> fields;
+    size_t record_bytes_size = 0;
+
+    public:
+        HeaderDecodePlan(std::shared_ptr<std::unordered_map<std::string, HeaderDataType>> header_values_type);
+
+        const std::vector<HeaderValueField>& get_fields() const;
+        const HeaderValueField* find_field(const char* name, size_t name_length) const;
+        const HeaderValueField& get_field(const std::string& name) const;
+        size_t get_record_bytes_size() const;
+};
+
+#endif
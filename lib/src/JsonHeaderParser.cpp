@@ -0,0 +1,392 @@
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+
+#include "JsonHeaderParser.hpp"
+
+using namespace std;
+
+// Maximum length of a number literal in the header.
+#define JSON_HEADER_MAX_NUMBER_LENGTH 64
+// Maximum nesting of values the parser skips.
+#define JSON_HEADER_MAX_DEPTH 64
+
+namespace {
+    bool key_equals(const char* key, size_t key_length, const char* literal)
+    {
+        return strlen(literal) == key_length && memcmp(key, literal, key_length) == 0;
+    }
+
+    bool is_number_char(char c)
+    {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+}
+
+JsonHeaderParser::JsonHeaderParser(shared_ptr<const HeaderDecodePlan> header_decode_plan) :
+    header_decode_plan(header_decode_plan), header_value_parsed(header_decode_plan->get_fields().size(), false)
+{
+    type[0] = '\0';
+    endianness[0] = '\0';
+}
+
+void JsonHeaderParser::parse(const char* header, size_t header_size, char* header_values_record)
+{
+    const auto& header_value_fields = header_decode_plan->get_fields();
+
+    begin = header;
+    position = header;
+    end = header + header_size;
+    this->header_values_record = header_values_record;
+
+    bool frame_parsed = false;
+    bool shape_parsed = false;
+    bool type_parsed = false;
+
+    // Array 1.0 specified little endian as the default encoding.
+    strcpy(endianness, "little");
+
+    header_value_parsed.assign(header_value_fields.size(), false);
+
+    skip_whitespace();
+    expect('{');
+    skip_whitespace();
+
+    if (next_is('}')) {
+        throw_parse_error("Empty header");
+    }
+
+    while (true) {
+        const char* key;
+        size_t key_length;
+
+        read_string(key, key_length);
+        skip_whitespace();
+        expect(':');
+        skip_whitespace();
+
+        const char* value_start = position;
+        auto field = header_decode_plan->find_field(key, key_length);
+
+        if (key_equals(key, key_length, "frame")) {
+            frame_index = read_unsigned_integer();
+            frame_parsed = true;
+
+        } else if (key_equals(key, key_length, "shape")) {
+            read_shape();
+            shape_parsed = true;
+
+        } else if (key_equals(key, key_length, "type")) {
+            read_string_value(type);
+            type_parsed = true;
+
+        } else if (key_equals(key, key_length, "endianness")) {
+            read_string_value(endianness);
+
+        } else if (!field) {
+            skip_value();
+        }
+
+        // Array-1.0 values can also be requested as header values.
+        if (field) {
+            position = value_start;
+            read_header_value(*field);
+            header_value_parsed[field->field_id] = true;
+        }
+
+        skip_whitespace();
+
+        if (next_is(',')) {
+            position++;
+            skip_whitespace();
+            continue;
+        }
+
+        expect('}');
+        break;
+    }
+
+    if (!frame_parsed || !shape_parsed || !type_parsed) {
+        throw_parse_error("Missing one of the mandatory values frame, shape or type");
+    }
+
+    for (size_t field_index=0; field_index<header_value_fields.size(); field_index++) {
+        if (!header_value_parsed[field_index]) {
+            throw_parse_error("Missing header value " + header_value_fields[field_index].name);
+        }
+    }
+}
+
+void JsonHeaderParser::skip_whitespace()
+{
+    while (position < end && (*position == ' ' || *position == '\n' || *position == '\r' || *position == '\t')) {
+        position++;
+    }
+}
+
+bool JsonHeaderParser::next_is(char expected_char)
+{
+    return position < end && *position == expected_char;
+}
+
+void JsonHeaderParser::expect(char expected_char)
+{
+    if (!next_is(expected_char)) {
+        throw_parse_error(string("Expected '") + expected_char + "'");
+    }
+
+    position++;
+}
+
+void JsonHeaderParser::read_string(const char*& string_start, size_t& string_length)
+{
+    expect('"');
+    string_start = position;
+
+    while (position < end && *position != '"') {
+        // Skip the escaped character.
+        if (*position == '\\') {
+            position++;
+        }
+
+        position++;
+    }
+
+    if (position >= end) {
+        throw_parse_error("Unterminated string");
+    }
+
+    string_length = position - string_start;
+    position++;
+}
+
+void JsonHeaderParser::read_string_value(char* destination)
+{
+    const char* value;
+    size_t value_length;
+
+    read_string(value, value_length);
+
+    if (value_length > JSON_HEADER_MAX_STRING_LENGTH) {
+        throw_parse_error("String value too long");
+    }
+
+    memcpy(destination, value, value_length);
+    destination[value_length] = '\0';
+}
+
+void JsonHeaderParser::read_number(char* destination, number_converter convert)
+{
+    // strtod and friends need a null terminated string.
+    char number[JSON_HEADER_MAX_NUMBER_LENGTH + 1];
+    size_t number_length = 0;
+
+    bool is_integer = true;
+    bool is_negative = next_is('-');
+
+    while (position < end && is_number_char(*position)) {
+        if (number_length == JSON_HEADER_MAX_NUMBER_LENGTH) {
+            throw_parse_error("Number too long");
+        }
+
+        if (*position == '.' || *position == 'e' || *position == 'E') {
+            is_integer = false;
+        }
+
+        number[number_length++] = *position++;
+    }
+
+    if (number_length == 0) {
+        throw_parse_error("Expected a number");
+    }
+
+    number[number_length] = '\0';
+
+    convert(destination, number, is_integer, is_negative);
+}
+
+uint64_t JsonHeaderParser::read_unsigned_integer()
+{
+    // Only digits are allowed.
+    const char* number_start = position;
+    uint64_t value = 0;
+
+    while (position < end && *position >= '0' && *position <= '9') {
+        value = (value * 10) + (*position - '0');
+        position++;
+    }
+
+    if (position == number_start) {
+        throw_parse_error("Expected an unsigned integer");
+    }
+
+    return value;
+}
+
+void JsonHeaderParser::read_shape()
+{
+    frame_rank = 0;
+
+    expect('[');
+    skip_whitespace();
+
+    if (next_is(']')) {
+        position++;
+        return;
+    }
+
+    while (true) {
+        if (frame_rank == JSON_HEADER_MAX_SHAPE_RANK) {
+            throw_parse_error("Frame shape has too many dimensions");
+        }
+
+        frame_shape[frame_rank++] = read_unsigned_integer();
+        skip_whitespace();
+
+        if (next_is(',')) {
+            position++;
+            skip_whitespace();
+            continue;
+        }
+
+        expect(']');
+        break;
+    }
+}
+
+void JsonHeaderParser::read_header_value(const HeaderValueField& field)
+{
+    char* destination = header_values_record + field.offset;
+
+    // Missing array values are left zero.
+    memset(destination, 0, field.value_bytes_size * field.value_shape);
+
+    if (!field.is_array) {
+        read_number(destination, field.convert_number);
+        return;
+    }
+
+    expect('[');
+    skip_whitespace();
+
+    if (next_is(']')) {
+        position++;
+        return;
+    }
+
+    size_t value_index = 0;
+
+    while (true) {
+        if (value_index == field.value_shape) {
+            throw_parse_error("Too many values for header value " + field.name);
+        }
+
+        read_number(destination + (value_index * field.value_bytes_size), field.convert_number);
+        value_index++;
+        skip_whitespace();
+
+        if (next_is(',')) {
+            position++;
+            skip_whitespace();
+            continue;
+        }
+
+        expect(']');
+        break;
+    }
+}
+
+void JsonHeaderParser::skip_value(int depth)
+{
+    if (depth > JSON_HEADER_MAX_DEPTH) {
+        throw_parse_error("Header nested too deep");
+    }
+
+    skip_whitespace();
+
+    if (next_is('"')) {
+        const char* value;
+        size_t value_length;
+        read_string(value, value_length);
+
+    } else if (next_is('{') || next_is('[')) {
+        bool is_object = next_is('{');
+        char closing_char = is_object ? '}' : ']';
+
+        position++;
+        skip_whitespace();
+
+        if (next_is(closing_char)) {
+            position++;
+            return;
+        }
+
+        while (true) {
+            if (is_object) {
+                const char* key;
+                size_t key_length;
+                read_string(key, key_length);
+                skip_whitespace();
+                expect(':');
+            }
+
+            skip_value(depth + 1);
+            skip_whitespace();
+
+            if (next_is(',')) {
+                position++;
+                skip_whitespace();
+                continue;
+            }
+
+            expect(closing_char);
+            break;
+        }
+
+    } else {
+        // Numbers, true, false, null.
+        const char* value_start = position;
+
+        while (position < end && *position != ',' && *position != '}' && *position != ']' && 
+               *position != ' ' && *position != '\n' && *position != '\r' && *position != '\t') {
+            position++;
+        }
+
+        if (position == value_start) {
+            throw_parse_error("Expected a value");
+        }
+    }
+}
+
+void JsonHeaderParser::throw_parse_error(const string& message)
+{
+    stringstream error_message;
+    using namespace date;
+    error_message << "[" << std::chrono::system_clock::now() << "]";
+    error_message << "[JsonHeaderParser::parse] " << message << " at header offset " << (position - begin) << "." << endl;
+
+    throw runtime_error(error_message.str());
+}
+
+uint64_t JsonHeaderParser::get_frame_index() const
+{
+    return frame_index;
+}
+
+vector<size_t> JsonHeaderParser::get_frame_shape() const
+{
+    return vector<size_t>(frame_shape, frame_shape + frame_rank);
+}
+
+string JsonHeaderParser::get_type() const
+{
+    return string(type);
+}
+
+string JsonHeaderParser::get_endianness() const
+{
+    return string(endianness);
+}
@@ -0,0 +1,64 @@
+#ifndef JSONHEADERPARSER_H
+#define JSONHEADERPARSER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <chrono>
+#include "date.h"
+
+#include "HeaderDecodePlan.hpp"
+
+// Maximum number of dimensions of a frame.
+#define JSON_HEADER_MAX_SHAPE_RANK 8
+// Maximum length of the type and endianness strings.
+#define JSON_HEADER_MAX_STRING_LENGTH 32
+
+/*
+ * Single pass parser for the Array-1.0 JSON header.
+ * Header values are decoded into the record passed to parse(), as laid out by the HeaderDecodePlan.
+ * Parsing does not allocate.
+ */
+class JsonHeaderParser
+{
+    const std::shared_ptr<const HeaderDecodePlan> header_decode_plan;
+    std::vector<bool> header_value_parsed;
+
+    // Parser state.
+    const char* begin = NULL;
+    const char* position = NULL;
+    const char* end = NULL;
+    char* header_values_record = NULL;
+
+    // Array-1.0 values.
+    uint64_t frame_index = 0;
+    size_t frame_shape[JSON_HEADER_MAX_SHAPE_RANK];
+    size_t frame_rank = 0;
+    char type[JSON_HEADER_MAX_STRING_LENGTH + 1];
+    char endianness[JSON_HEADER_MAX_STRING_LENGTH + 1];
+
+    void skip_whitespace();
+    void expect(char expected_char);
+    bool next_is(char expected_char);
+    void read_string(const char*& string_start, size_t& string_length);
+    void read_string_value(char* destination);
+    void read_number(char* destination, number_converter convert);
+    uint64_t read_unsigned_integer();
+    void read_shape();
+    void read_header_value(const HeaderValueField& field);
+    void skip_value(int depth=0);
+    [[noreturn]] void throw_parse_error(const std::string& message);
+
+    public:
+        JsonHeaderParser(std::shared_ptr<const HeaderDecodePlan> header_decode_plan);
+
+        void parse(const char* header, size_t header_size, char* header_values_record);
+
+        uint64_t get_frame_index() const;
+        std::vector<size_t> get_frame_shape() const;
+        std::string get_type() const;
+        std::string get_endianness() const;
+};
+
+#endif
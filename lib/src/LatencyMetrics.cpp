@@ -0,0 +1,172 @@
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "LatencyMetrics.hpp"
+
+using namespace std;
+
+namespace {
+    LatencyHistogram stage_histograms[LATENCY_N_STAGES];
+
+    atomic<size_t> next_shard_index(0);
+
+    size_t get_thread_shard_index()
+    {
+        thread_local size_t shard_index = next_shard_index++ % LATENCY_HISTOGRAM_N_SHARDS;
+        return shard_index;
+    }
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+size_t LatencyHistogram::get_bucket_index(uint64_t value)
+{
+    const uint64_t n_sub_buckets = 1 << LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+
+    if (value < n_sub_buckets) {
+        return value;
+    }
+
+    size_t magnitude = 63 - __builtin_clzll(value);
+    if (magnitude >= LATENCY_HISTOGRAM_MAX_MAGNITUDE) {
+        return LATENCY_HISTOGRAM_N_BUCKETS - 1;
+    }
+
+    // The top LATENCY_HISTOGRAM_SUB_BUCKET_BITS bits below the leading one.
+    size_t sub_bucket = (value >> (magnitude - LATENCY_HISTOGRAM_SUB_BUCKET_BITS)) & (n_sub_buckets - 1);
+
+    return ((magnitude - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) << LATENCY_HISTOGRAM_SUB_BUCKET_BITS) + sub_bucket;
+}
+
+uint64_t LatencyHistogram::get_bucket_value(size_t bucket_index)
+{
+    const uint64_t n_sub_buckets = 1 << LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+
+    if (bucket_index < n_sub_buckets) {
+        return bucket_index;
+    }
+
+    size_t magnitude = (bucket_index >> LATENCY_HISTOGRAM_SUB_BUCKET_BITS) + LATENCY_HISTOGRAM_SUB_BUCKET_BITS - 1;
+    uint64_t sub_bucket = bucket_index & (n_sub_buckets - 1);
+    size_t shift = magnitude - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+
+    // Highest value in the bucket.
+    return ((n_sub_buckets + sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    auto& shard = shards[get_thread_shard_index()];
+
+    shard.buckets[get_bucket_index(value)].fetch_add(1, memory_order_relaxed);
+    shard.sum.fetch_add(value, memory_order_relaxed);
+
+    // Usually a single thread per shard - the loop is not contended.
+    uint64_t current_max = shard.max.load(memory_order_relaxed);
+    while (value > current_max && !shard.max.compare_exchange_weak(current_max, value, memory_order_relaxed)) {}
+}
+
+LatencySummary LatencyHistogram::get_summary() const
+{
+    array<uint64_t, LATENCY_HISTOGRAM_N_BUCKETS> buckets;
+    buckets.fill(0);
+
+    LatencySummary summary;
+
+    for (const auto& shard : shards) {
+        for (size_t bucket_index=0; bucket_index<LATENCY_HISTOGRAM_N_BUCKETS; bucket_index++) {
+            auto bucket_count = shard.buckets[bucket_index].load(memory_order_relaxed);
+
+            buckets[bucket_index] += bucket_count;
+            summary.count += bucket_count;
+        }
+
+        summary.max = max(summary.max, shard.max.load(memory_order_relaxed));
+        summary.sum += shard.sum.load(memory_order_relaxed);
+    }
+
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    // Smallest bucket value with at least the percentile of the values at or below it.
+    auto get_percentile = [&](double percentile) {
+        uint64_t n_values = static_cast<uint64_t>(ceil(percentile * summary.count));
+        n_values = max<uint64_t>(n_values, 1);
+
+        uint64_t n_values_below = 0;
+
+        for (size_t bucket_index=0; bucket_index<LATENCY_HISTOGRAM_N_BUCKETS; bucket_index++) {
+            n_values_below += buckets[bucket_index];
+
+            if (n_values_below >= n_values) {
+                return min(get_bucket_value(bucket_index), summary.max);
+            }
+        }
+
+        return summary.max;
+    };
+
+    summary.p50 = get_percentile(0.5);
+    summary.p99 = get_percentile(0.99);
+    summary.p999 = get_percentile(0.999);
+
+    return summary;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& shard : shards) {
+        for (auto& bucket : shard.buckets) {
+            bucket.store(0, memory_order_relaxed);
+        }
+
+        shard.max.store(0, memory_order_relaxed);
+        shard.sum.store(0, memory_order_relaxed);
+    }
+}
+
+void LatencyMetrics::record(LatencyStage stage, chrono::steady_clock::duration latency)
+{
+    auto latency_ns = chrono::duration_cast<chrono::nanoseconds>(latency).count();
+
+    stage_histograms[stage].record(latency_ns > 0 ? latency_ns : 0);
+}
+
+LatencySummary LatencyMetrics::get_summary(LatencyStage stage)
+{
+    return stage_histograms[stage].get_summary();
+}
+
+string LatencyMetrics::get_stage_name(LatencyStage stage)
+{
+    switch (stage) {
+        case LATENCY_RECEIVE: return "receive";
+        case LATENCY_JSON_PARSE: return "json_parse";
+        case LATENCY_RING_BUFFER_WAIT: return "ring_buffer_wait";
+        case LATENCY_CHUNK_WRITE: return "chunk_write";
+        case LATENCY_METADATA_CACHE: return "metadata_cache";
+        case LATENCY_ROLLOVER: return "rollover";
+        case LATENCY_FORMAT_WRITE: return "format_write";
+        default: break;
+    }
+
+    stringstream error_message;
+    using namespace date;
+    error_message << "[" << std::chrono::system_clock::now() << "]";
+    error_message << "[LatencyMetrics::get_stage_name] Unknown latency stage " << stage << endl;
+
+    throw runtime_error(error_message.str());
+}
+
+void LatencyMetrics::reset()
+{
+    for (auto& histogram : stage_histograms) {
+        histogram.reset();
+    }
+}
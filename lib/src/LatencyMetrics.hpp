@@ -0,0 +1,97 @@
+#ifndef LATENCYMETRICS_H
+#define LATENCYMETRICS_H
+
+#include <atomic>
+#include <array>
+#include <string>
+#include <chrono>
+#include "date.h"
+
+// Linear sub buckets per power of 2 - the recorded values are within 1/16 (6%) of the real ones.
+#define LATENCY_HISTOGRAM_SUB_BUCKET_BITS 4
+// Values up to 2^40 ns (~18 minutes), larger ones go to the last bucket.
+#define LATENCY_HISTOGRAM_MAX_MAGNITUDE 40
+#define LATENCY_HISTOGRAM_N_BUCKETS \
+    ((LATENCY_HISTOGRAM_MAX_MAGNITUDE - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) << LATENCY_HISTOGRAM_SUB_BUCKET_BITS)
+// Threads record into different shards, so they do not share cache lines.
+#define LATENCY_HISTOGRAM_N_SHARDS 8
+
+enum LatencyStage 
+{
+    // ZMQ header and data part of a frame received and decoded.
+    LATENCY_RECEIVE,
+    LATENCY_JSON_PARSE,
+    // Frame committed in the ring buffer until read by the writer.
+    LATENCY_RING_BUFFER_WAIT,
+    // H5DOwrite_chunk (and the writes of late frames).
+    LATENCY_CHUNK_WRITE,
+    LATENCY_METADATA_CACHE,
+    // What the writer thread waits for while rolling over the file.
+    LATENCY_ROLLOVER,
+    LATENCY_FORMAT_WRITE,
+    LATENCY_N_STAGES
+};
+
+struct LatencySummary
+{
+    uint64_t count = 0;
+    // In ns.
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+    // Total time spent in the stage.
+    uint64_t sum = 0;
+};
+
+/*
+ * HDR style histogram of latencies in ns, with log-linear buckets.
+ * Recording is lock-free (relaxed atomic increments), reading can happen at any time from another thread.
+ */
+class LatencyHistogram
+{
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<uint64_t>, LATENCY_HISTOGRAM_N_BUCKETS> buckets;
+        std::atomic<uint64_t> max;
+        std::atomic<uint64_t> sum;
+    };
+
+    std::array<Shard, LATENCY_HISTOGRAM_N_SHARDS> shards;
+
+    static size_t get_bucket_index(uint64_t value);
+    static uint64_t get_bucket_value(size_t bucket_index);
+
+    public:
+        LatencyHistogram();
+
+        void record(uint64_t value);
+        LatencySummary get_summary() const;
+        void reset();
+};
+
+namespace LatencyMetrics
+{
+    void record(LatencyStage stage, std::chrono::steady_clock::duration latency);
+
+    LatencySummary get_summary(LatencyStage stage);
+
+    std::string get_stage_name(LatencyStage stage);
+
+    void reset();
+};
+
+// Records the time from construction to destruction.
+class LatencyTimer
+{
+    const LatencyStage stage;
+    const std::chrono::steady_clock::time_point start_time;
+
+    public:
+        LatencyTimer(LatencyStage stage) : stage(stage), start_time(std::chrono::steady_clock::now()) {}
+
+        ~LatencyTimer()
+            { LatencyMetrics::record(stage, std::chrono::steady_clock::now() - start_time); }
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <stdexcept>
+#include <cstring>
 
 #include "date.h"
 #include "MetadataBuffer.hpp"
@@ -73,6 +74,13 @@ shared_ptr<char> MetadataBuffer::get_metadata_values(string name)
     return metadata->second;
 }
 
+void MetadataBuffer::clear()
+{
+    for (auto& metadata : metadata_buffer) {
+        memset(metadata.second.get(), 0, n_images * metadata_length_bytes.at(metadata.first));
+    }
+}
+
 shared_ptr<unordered_map<string, HeaderDataType>> MetadataBuffer::get_header_values_type()
 {
     return header_values_type;
@@ -0,0 +1,135 @@
+#include <stdexcept>
+#include <sstream>
+#include <iostream>
+
+#include "MpscRingBuffer.hpp"
+
+using namespace std;
+
+MpscRingBuffer::MpscRingBuffer(size_t n_slots, const RingBufferMemoryOptions& memory_options) : 
+    RingBuffer(n_slots, memory_options), frame_metadata_slots(n_slots), slots_sequence(new atomic<size_t>[n_slots]), 
+    slots_committed(new atomic<bool>[n_slots]), slots_occupied(new atomic<bool>[n_slots]), 
+    reserve_position(0), read_position(0), n_used_slots(0)
+{
+    for (size_t slot_index=0; slot_index<n_slots; slot_index++) {
+        slots_sequence[slot_index].store(slot_index);
+        slots_committed[slot_index].store(false);
+        slots_occupied[slot_index].store(false);
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[MpscRingBuffer::MpscRingBuffer] Creating lock-free multi producer ring buffer with n_slots " << n_slots << endl;
+    #endif
+}
+
+bool MpscRingBuffer::reserve_slot(const shared_ptr<FrameMetadata>& frame_metadata)
+{
+    size_t position = reserve_position.load(memory_order_relaxed);
+    size_t slot_index;
+
+    while (true) {
+        slot_index = position % n_slots;
+
+        // Acquire: the consumer must be done with the slot before we overwrite it.
+        size_t slot_sequence = slots_sequence[slot_index].load(memory_order_acquire);
+
+        if (slot_sequence == position) {
+            // On failure position is updated to the current reserve position.
+            if (reserve_position.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+                break;
+            }
+
+        } else if (slot_sequence < position) {
+            // Full - the slot of this position is not released yet.
+            return false;
+
+        } else {
+            // Another producer took this position.
+            position = reserve_position.load(memory_order_relaxed);
+        }
+    }
+
+    slots_occupied[slot_index].store(true, memory_order_relaxed);
+    update_max_used_slots(n_used_slots.fetch_add(1, memory_order_relaxed) + 1);
+
+    frame_metadata->buffer_slot_index = slot_index;
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[MpscRingBuffer::reserve_slot] Ring buffer slot " << slot_index << " reserved for frame_index ";
+        cout << frame_metadata->frame_index << endl;
+    #endif
+
+    return true;
+}
+
+void MpscRingBuffer::commit_slot(const shared_ptr<FrameMetadata>& frame_metadata)
+{
+    frame_metadata_slots[frame_metadata->buffer_slot_index] = frame_metadata;
+
+    // Release: publish the frame data and metadata to the consumer.
+    slots_committed[frame_metadata->buffer_slot_index].store(true, memory_order_release);
+}
+
+shared_ptr<FrameMetadata> MpscRingBuffer::take_committed_slot()
+{
+    // Only the consumer modifies the read position.
+    size_t current_read_position = read_position.load(memory_order_relaxed);
+    size_t slot_index = current_read_position % n_slots;
+
+    if (!slots_committed[slot_index].load(memory_order_acquire)) {
+        return NULL;
+    }
+
+    auto frame_metadata = move(frame_metadata_slots[slot_index]);
+
+    slots_committed[slot_index].store(false, memory_order_relaxed);
+    read_position.store(current_read_position + 1, memory_order_relaxed);
+
+    return frame_metadata;
+}
+
+void MpscRingBuffer::free_slot(size_t buffer_slot_index)
+{
+    if (!slots_occupied[buffer_slot_index].load(memory_order_relaxed)) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[MpscRingBuffer::free_slot] Cannot release empty ring buffer slot " << buffer_slot_index << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    slots_occupied[buffer_slot_index].store(false, memory_order_relaxed);
+    n_used_slots.fetch_sub(1, memory_order_relaxed);
+
+    // Release: hand the slot memory to the producer of the next lap.
+    slots_sequence[buffer_slot_index].fetch_add(n_slots, memory_order_release);
+}
+
+bool MpscRingBuffer::has_committed_slots()
+{
+    return slots_committed[read_position.load(memory_order_relaxed) % n_slots].load(memory_order_acquire);
+}
+
+bool MpscRingBuffer::are_slots_empty()
+{
+    return n_used_slots.load(memory_order_acquire) == 0;
+}
+
+size_t MpscRingBuffer::get_n_used_slots()
+{
+    return n_used_slots.load(memory_order_relaxed);
+}
+
+unique_ptr<RingBuffer> get_ring_buffer(size_t n_slots, size_t n_producers, const RingBufferMemoryOptions& memory_options)
+{
+    if (n_producers > 1) {
+        return unique_ptr<RingBuffer>(new MpscRingBuffer(n_slots, memory_options));
+    }
+
+    return unique_ptr<RingBuffer>(new SpscRingBuffer(n_slots, memory_options));
+}
@@ -0,0 +1,54 @@
+#ifndef MPSCRINGBUFFER_H
+#define MPSCRINGBUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "RingBuffer.hpp"
+#include "SpscRingBuffer.hpp"
+
+/*
+ * Lock-free ring buffer for any number of producer threads (write) and one consumer (read, release).
+ * The producers claim the slots in order with a compare and swap on reserve_position. Each slot has a sequence number 
+ * telling which position can use it next, so a producer never takes a slot that was not released yet.
+ * The frames are read in the reserve order - a frame committed early waits for the frames reserved before it.
+ * Reads must not be concurrent - release can be called from another thread than read.
+ */
+class MpscRingBuffer : public RingBuffer
+{
+    std::vector<std::shared_ptr<FrameMetadata>> frame_metadata_slots;
+    // Position that can reserve the slot next - the previous position plus n_slots once the slot is released.
+    std::unique_ptr<std::atomic<size_t>[]> slots_sequence;
+    std::unique_ptr<std::atomic<bool>[]> slots_committed;
+    std::unique_ptr<std::atomic<bool>[]> slots_occupied;
+
+    char padding_reserve_position[SPSC_CACHE_LINE_SIZE];
+    // Number of slots reserved so far - shared by the producers.
+    std::atomic<size_t> reserve_position;
+
+    char padding_read_position[SPSC_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    // Number of frames read so far - modified only by the consumer.
+    std::atomic<size_t> read_position;
+
+    char padding_used_slots[SPSC_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> n_used_slots;
+
+    protected:
+        bool reserve_slot(const std::shared_ptr<FrameMetadata>& frame_metadata) override;
+        void commit_slot(const std::shared_ptr<FrameMetadata>& frame_metadata) override;
+        std::shared_ptr<FrameMetadata> take_committed_slot() override;
+        void free_slot(size_t buffer_slot_index) override;
+        bool has_committed_slots() override;
+        bool are_slots_empty() override;
+
+    public:
+        MpscRingBuffer(size_t n_slots, const RingBufferMemoryOptions& memory_options=RingBufferMemoryOptions());
+        size_t get_n_used_slots() override;
+};
+
+// Lock-free ring buffer for n_producers producing threads.
+std::unique_ptr<RingBuffer> get_ring_buffer(size_t n_slots, size_t n_producers=1, 
+    const RingBufferMemoryOptions& memory_options=RingBufferMemoryOptions());
+
+#endif
@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 #include <chrono>
 #include <unistd.h>
 #include <stdexcept>
@@ -6,19 +7,127 @@
 #include <memory>
 #include <boost/thread.hpp>
 #include <future>
+#include <algorithm>
+#include <sstream>
+#include <tuple>
 
 #include "RestApi.hpp"
 #include "ProcessManager.hpp"
 #include "config.hpp"
 #include "BufferedWriter.hpp"
+#include "CompressionPool.hpp"
+#include "MpscRingBuffer.hpp"
+#include "VirtualDataset.hpp"
+#include "FrameReorderWindow.hpp"
 
 using namespace std;
 
 ProcessManager::ProcessManager(WriterManager& writer_manager, ZmqReceiver& receiver, RingBuffer& ring_buffer, 
     const H5Format& format, uint16_t rest_port, const string& bsread_rest_address, hsize_t frames_per_file) :
-        writer_manager(writer_manager), receiver(receiver), ring_buffer(ring_buffer), format(format), rest_port(rest_port), 
-        bsread_rest_address(bsread_rest_address), frames_per_file(frames_per_file)
+        writer_manager(writer_manager), receiver(receiver), ring_buffer(ring_buffer), format(format), format_plan(format, false), rest_port(rest_port), 
+        bsread_rest_address(bsread_rest_address), frames_per_file(frames_per_file), first_pulse_id_sent(false), 
+        n_running_receivers(0)
 {
+    // Checked before any thread is started - the writer thread cannot report errors.
+    if (config::n_writers > 1 && frames_per_file) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[ProcessManager::ProcessManager] Striped writers (config::n_writers) and frames_per_file";
+        error_message << " cannot be used together." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    // Multiple receivers deliver the frames out of order - without the reorder window they would cross file boundaries.
+    if (config::zmq_n_receivers > 1 && frames_per_file && !config::reorder_window_size) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[ProcessManager::ProcessManager] Multiple receivers (config::zmq_n_receivers) and frames_per_file";
+        error_message << " need config::reorder_window_size." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    // The direct VFD does not support SWMR.
+    if (config::swmr_mode && config::h5_direct_io) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[ProcessManager::ProcessManager] config::swmr_mode and config::h5_direct_io";
+        error_message << " cannot be used together." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    stripe_ring_buffers.push_back(&ring_buffer);
+
+    // The other striped writers get their own ring buffer of the same size.
+    auto memory_options = RingBufferMemory::get_config_options();
+
+    for (size_t stripe_index=1; stripe_index<config::n_writers; stripe_index++) {
+        owned_ring_buffers.push_back(get_ring_buffer(config::ring_buffer_n_slots, config::zmq_n_receivers, 
+            memory_options));
+        stripe_ring_buffers.push_back(owned_ring_buffers.back().get());
+    }
+
+    writer_manager.set_ring_buffers(stripe_ring_buffers);
+
+    auto overflow_policy = get_ring_buffer_overflow_policy(config::ring_buffer_overflow_policy);
+
+    for (auto stripe_ring_buffer : stripe_ring_buffers) {
+        stripe_ring_buffer->set_overflow_policy(overflow_policy);
+        stripe_ring_buffer->set_dropped_frame_callback([this](uint64_t frame_index){ 
+            this->writer_manager.dropped_frame(frame_index); 
+        });
+    }
+
+    if (!config::spill_file.empty()) {
+        auto spill_threshold = max(static_cast<size_t>(config::spill_threshold * config::ring_buffer_n_slots), size_t(1));
+
+        for (size_t stripe_index=0; stripe_index<stripe_ring_buffers.size(); stripe_index++) {
+            auto spill_file = config::spill_file;
+            if (stripe_ring_buffers.size() > 1) {
+                spill_file += "_" + to_string(stripe_index);
+            }
+
+            stripe_ring_buffers[stripe_index]->set_spill_buffer(unique_ptr<SpillBuffer>(
+                new SpillBuffer(spill_file, config::spill_file_size, config::spill_n_read_slots)), spill_threshold);
+        }
+    }
+
+    if (config::zmq_n_receivers <= 1) {
+        receivers.push_back(&receiver);
+        return;
+    }
+
+    // Receiver i connects to the addresses i, i + n_receivers... or all to the same one.
+    vector<string> connect_addresses;
+    stringstream addresses(receiver.get_connect_address());
+    string address;
+
+    while (getline(addresses, address, ',')) {
+        if (!address.empty()) {
+            connect_addresses.push_back(address);
+        }
+    }
+
+    for (size_t receiver_index=0; receiver_index<config::zmq_n_receivers; receiver_index++) {
+        string receiver_addresses;
+
+        for (size_t address_index=receiver_index; address_index<connect_addresses.size(); 
+            address_index+=config::zmq_n_receivers) {
+            receiver_addresses += (receiver_addresses.empty() ? "" : ",") + connect_addresses[address_index];
+        }
+
+        if (receiver_addresses.empty()) {
+            receiver_addresses = connect_addresses[receiver_index % connect_addresses.size()];
+        }
+
+        owned_receivers.push_back(receiver.get_receiver(receiver_addresses));
+        receivers.push_back(owned_receivers.back().get());
+    }
 }
 
 void ProcessManager::notify_first_pulse_id(uint64_t pulse_id) 
@@ -82,7 +191,13 @@ void ProcessManager::run_writer()
         cout << endl;
     #endif
 
-    boost::thread receiver_thread(&ProcessManager::receive_zmq, this);
+    boost::thread_group receiver_threads;
+    n_running_receivers = receivers.size();
+
+    for (size_t receiver_index=0; receiver_index<receivers.size(); receiver_index++) {
+        receiver_threads.create_thread(boost::bind(&ProcessManager::receive_zmq, this, receiver_index));
+    }
+
     boost::thread writer_thread(&ProcessManager::write_h5, this);
 
     RestApi::start_rest_api(writer_manager, rest_port);
@@ -96,7 +211,7 @@ void ProcessManager::run_writer()
     // In case SIGINT stopped the rest_api.
     writer_manager.stop();
 
-    receiver_thread.join();
+    receiver_threads.join_all();
     writer_thread.join();
 
     #ifdef DEBUG_OUTPUT
@@ -106,26 +221,45 @@ void ProcessManager::run_writer()
     #endif
 }
 
-void ProcessManager::receive_zmq()
+RingBuffer& ProcessManager::get_frame_ring_buffer(uint64_t frame_index)
+{
+    return *stripe_ring_buffers[frame_index % stripe_ring_buffers.size()];
+}
+
+void ProcessManager::receive_zmq(size_t receiver_index)
 {
-    receiver.connect();
+    ZmqReceiver& stream_receiver = *receivers[receiver_index];
+    stream_receiver.connect();
 
     while (writer_manager.is_running()) {
-        
-        auto frame = receiver.receive();
-        
+
+        shared_ptr<FrameMetadata> frame_metadata;
+        // Received into the receiver buffer, copied into a ring buffer slot.
+        const char* frame_data = NULL;
+        // Received message passed to the ring buffer slot, which takes ownership of it.
+        shared_ptr<char> frame_message;
+
+        if (config::zmq_zero_copy_receive) {
+            tie(frame_metadata, frame_message) = stream_receiver.receive_zero_copy();
+        } else {
+            tie(frame_metadata, frame_data) = stream_receiver.receive();
+        }
+
         // In case no message is available before the timeout, both pointers are NULL.
-        if (!frame.first){
+        if (!frame_metadata) {
             continue;
         }
 
-        auto frame_metadata = frame.first;
-        auto frame_data = frame.second;
+        auto& frame_ring_buffer = get_frame_ring_buffer(frame_metadata->frame_index);
+
+        // False if the ring buffer was full and dropped the frame.
+        bool frame_written = frame_message ? 
+            frame_ring_buffer.write(frame_metadata, frame_message) : frame_ring_buffer.write(frame_metadata, frame_data);
 
         #ifdef DEBUG_OUTPUT
             using namespace date;
             cout << "[" << std::chrono::system_clock::now() << "]";
-            cout << "[ProcessManager::receive_zmq] Processing FrameMetadata"; 
+            cout << "[ProcessManager::receive_zmq] Processed FrameMetadata"; 
             cout << " with frame_index " << frame_metadata->frame_index;
             cout << " and frame_shape [" << frame_metadata->frame_shape[0] << ", " << frame_metadata->frame_shape[1] << "]";
             cout << " and endianness " << frame_metadata->endianness;
@@ -134,75 +268,273 @@ void ProcessManager::receive_zmq()
             cout << "." << endl;
         #endif
 
-        // Commit the frame to the buffer.
-        ring_buffer.write(frame_metadata, frame_data);
-
         writer_manager.received_frame(frame_metadata->frame_index);
+
+        if (!frame_written) {
+            writer_manager.dropped_frame(frame_metadata->frame_index);
+        }
    }
 
     #ifdef DEBUG_OUTPUT
         using namespace date;
         cout << "[" << std::chrono::system_clock::now() << "]";
-        cout << "[ProcessManager::receive_zmq] Receiver thread stopped." << endl;
+        cout << "[ProcessManager::receive_zmq] Receiver thread " << receiver_index << " stopped." << endl;
     #endif
+
+    // No more frames will arrive - do not let the writers wait for them.
+    if (--n_running_receivers == 0) {
+        for (auto stripe_ring_buffer : stripe_ring_buffers) {
+            stripe_ring_buffer->shutdown();
+        }
+    }
 }
 
 void ProcessManager::write_h5()
 {
-    size_t metadata_buffer_size = frames_per_file != 0 ? frames_per_file : writer_manager.get_n_frames();
-    auto metadata_buffer = unique_ptr<MetadataBuffer>(new MetadataBuffer(metadata_buffer_size, receiver.get_header_values_type()));
+    const size_t n_writers = stripe_ring_buffers.size();
+    const auto& output_file = writer_manager.get_output_file();
+
+    // Each writer gets every n_writers-th frame.
+    size_t n_frames_per_writer = (writer_manager.get_n_frames() + n_writers - 1) / n_writers;
+    // The metadata is staged for one block of frames at a time.
+    size_t metadata_buffer_size = config::metadata_block_n_frames;
+    if (frames_per_file != 0) {
+        metadata_buffer_size = min(metadata_buffer_size, static_cast<size_t>(frames_per_file));
+    }
 
-    auto writer = get_buffered_writer(writer_manager.get_output_file(), writer_manager.get_n_frames(), move(metadata_buffer), 
-        frames_per_file, config::dataset_increase_step);
+    vector<unique_ptr<BufferedWriter>> writers;
+
+    H5WriterIoProfile io_profile;
+    io_profile.alignment = config::h5_alignment;
+    io_profile.alignment_threshold = config::h5_alignment_threshold;
+    io_profile.meta_block_size = config::h5_meta_block_size;
+    io_profile.page_size = config::h5_page_size;
+    io_profile.page_buffer_size = config::h5_page_buffer_size;
+    io_profile.latest_format = config::h5_latest_format;
+    io_profile.metadata_cache_size = config::h5_metadata_cache_size;
+    io_profile.direct_io = config::h5_direct_io;
+    io_profile.direct_io_alignment = config::h5_direct_io_alignment;
+    io_profile.direct_io_copy_buffer_size = config::h5_direct_io_copy_buffer_size;
+
+    for (size_t stripe_index=0; stripe_index<n_writers; stripe_index++) {
+        auto metadata_buffer = unique_ptr<MetadataBuffer>(new MetadataBuffer(metadata_buffer_size, receiver.get_header_values_type()));
+
+        // The output file is a template for the stripe files.
+        auto writer_filename = n_writers > 1 ? VirtualDatasetUtils::get_filename(output_file, stripe_index + 1) : output_file;
+
+        auto writer = get_buffered_writer(writer_filename, n_frames_per_writer, move(metadata_buffer), 
+            frames_per_file, config::dataset_increase_step, config::frames_per_chunk);
+
+        // The format skeleton is written when a file is created, the metadata and the REST values when it is 
+        // finalized - on roll over on a helper thread.
+        writer->set_file_initializer([this](H5::H5File& file){ write_h5_skeleton(file); });
+        writer->set_file_finalizer([this](H5::H5File& file){ write_h5_format(file); });
+        writer->set_async_file_rollover(config::async_file_rollover);
+        writer->set_write_master_file(config::write_master_file);
+        writer->set_swmr_mode(config::swmr_mode, config::swmr_flush_interval);
+        writer->set_io_profile(io_profile);
+        // Missing frames stay in the dataset with this value, their is_good_frame metadata is 0.
+        writer->set_dataset_fill_value(config::raw_image_dataset_name, config::missing_frame_fill_value);
+        // Datasets are created at their place in the file format - nothing is moved when the file is finalized.
+        for (const auto& mapping : format.get_dataset_move_mapping()) {
+            writer->set_dataset_path(mapping.first, mapping.second);
+        }
+
+        writer->create_file();
+
+        writers.push_back(move(writer));
+    }
+
+    // With frames_per_file the index follows the frames written.
+    writer_manager.set_file_index(1);
+
+    vector<StripeStatus> stripes_status(n_writers);
+
+    if (n_writers == 1) {
+        write_stripe(0, *writers[0], stripes_status[0]);
+    } else {
+        boost::thread_group stripe_threads;
+
+        for (size_t stripe_index=0; stripe_index<n_writers; stripe_index++) {
+            stripe_threads.create_thread(boost::bind(&ProcessManager::write_stripe, this, 
+                stripe_index, boost::ref(*writers[stripe_index]), boost::ref(stripes_status[stripe_index])));
+        }
+
+        stripe_threads.join_all();
+    }
+
+    // The last pulse_id is the one of the last frame, in whichever stripe it was.
+    auto last_stripe = max_element(stripes_status.begin(), stripes_status.end(), 
+        [](const StripeStatus& first, const StripeStatus& second) { return first.last_frame_index < second.last_frame_index; });
+
+    // Send the last_pulse_id only if it was set.
+    if (last_stripe->last_pulse_id) {
+        notify_last_pulse_id(last_stripe->last_pulse_id);
+    }
+
+    if (writers[0]->is_file_open()) {
+        #ifdef DEBUG_OUTPUT
+            using namespace date;
+            cout << "[" << std::chrono::system_clock::now() << "]";
+            cout << "[ProcessManager::write] Waiting for parameters to write the file format values." << endl;
+        #endif
+
+        // Wait until all parameters are set or writer is killed.
+        while (!writer_manager.are_all_parameters_set() && !writer_manager.is_killed()) {
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(config::parameters_read_retry_interval));
+        }
+    }
+    
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[ProcessManager::write] Closing file " << output_file << endl;
+    #endif
+
+    bool is_file_written = writers[0]->is_file_open();
+
+    for (auto& writer : writers) {
+        writer->close_file();
+    }
+
+    if (n_writers > 1 && is_file_written) {
+        write_stripes_master_file(stripes_status);
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[ProcessManager::write] Writer thread stopped." << endl;
+    #endif
+
+    // Exit when writer thread has closed the file.
+    exit(0);
+}
+
+void ProcessManager::write_stripe(size_t stripe_index, BufferedWriter& writer, StripeStatus& stripe_status)
+{
+    const size_t n_writers = stripe_ring_buffers.size();
+    RingBuffer& stripe_ring_buffer = *stripe_ring_buffers[stripe_index];
 
-    writer->create_file();
-        
     auto raw_frames_dataset_name = config::raw_image_dataset_name;
 
-    uint64_t last_pulse_id = 0;
+    // Header value offsets are resolved once, not per frame.
+    auto header_decode_plan = receiver.get_header_decode_plan();
+    auto pulse_id_field = header_decode_plan->find_field("pulse_id", 8);
+    
+    // Write the frames in frame_index order - this stripe gets every n_writers-th frame.
+    unique_ptr<FrameReorderWindow> reorder_window;
+
+    if (config::reorder_window_size) {
+        reorder_window = unique_ptr<FrameReorderWindow>(new FrameReorderWindow(stripe_ring_buffer, config::reorder_window_size, 
+            config::reorder_lost_frame_timeout, stripe_index, n_writers));
+
+        reorder_window->set_lost_frames_callback([this](uint64_t first_frame_index, uint64_t last_frame_index){ 
+            writer_manager.lost_frames(first_frame_index, last_frame_index); 
+        });
+
+        // The late frames were received - counted like the frames dropped by the ring buffer.
+        reorder_window->set_frames_per_file(frames_per_file);
+        reorder_window->set_dropped_frame_callback([this](uint64_t frame_index){ writer_manager.dropped_frame(frame_index); });
+    }
+
+    // Compress the frames on a pool of threads between the ring buffer and the writer.
+    auto frame_compressor = get_frame_compressor(config::compression_method, config::compression_level);
+    unique_ptr<CompressionPool> compression_pool;
+
+    if (frame_compressor) {
+        writer.set_dataset_compression(raw_frames_dataset_name, frame_compressor);
+
+        compression_pool = unique_ptr<CompressionPool>(new CompressionPool(stripe_ring_buffer, frame_compressor, 
+            config::compression_n_threads, config::ring_buffer_read_timeout, reorder_window.get()));
+    }
     
     // Run until the running flag is set or the ring_buffer is empty.  
-    while(writer_manager.is_running() || !ring_buffer.is_empty()) {
+    while(writer_manager.is_running() || !stripe_ring_buffer.is_empty()) {
         
-        if (ring_buffer.is_empty()) {
-            boost::this_thread::sleep_for(boost::chrono::milliseconds(config::ring_buffer_read_retry_interval));
-            continue;
-        }
+        pair< shared_ptr<FrameMetadata>, char* > received_data;
+        const CompressedFrame* compressed_frame = NULL;
+
+        if (compression_pool) {
+            // Frames come out of the pool in the ring buffer order.
+            compressed_frame = compression_pool->read_wait(config::ring_buffer_read_timeout);
 
-        const pair< shared_ptr<FrameMetadata>, char* > received_data = ring_buffer.read();
+            if (compressed_frame) {
+                received_data = {compressed_frame->frame_metadata, compressed_frame->frame_data};
+            }
+
+        } else if (reorder_window) {
+            received_data = reorder_window->read_wait(config::ring_buffer_read_timeout);
+
+        } else {
+            // Block until data is available, the timeout expires, or the receiver shuts down.
+            received_data = stripe_ring_buffer.read_wait(config::ring_buffer_read_timeout);
+        }
         
-        // NULL pointer means that the ringbuffer->read() timeouted. Faster than rising an exception.
+        // NULL pointer means that the ringbuffer->read_wait() timeouted. Faster than rising an exception.
         if(!received_data.first) {
             continue;
         }
 
-        // When using file roll over, write the file format before switching to the next file.
-        if (!writer->is_data_for_current_file(received_data.first->frame_index)) {
+        // Frame shape and type for the master file.
+        if (!stripe_status.first_frame_metadata) {
+            stripe_status.first_frame_metadata = received_data.first;
+        }
+
+        #ifdef PERF_OUTPUT
+            using namespace date;
+            auto start_time_frame = std::chrono::system_clock::now();
+        #endif
+
+        // Frame index in the file of this stripe.
+        auto data_index = received_data.first->frame_index / n_writers;
+
+        // A late frame for a finished file - counted like a frame dropped by the ring buffer.
+        if (writer.is_data_for_past_file(data_index)) {
+
             #ifdef DEBUG_OUTPUT
                 using namespace date;
                 cout << "[" << std::chrono::system_clock::now() << "]";
-                cout << "[ProcessManager::write_h5] Frame index " << received_data.first->frame_index;
-                cout << " does not belong to current file. Write format before the file will be closed." << endl;
+                cout << "[ProcessManager::write_stripe] Frame index " << received_data.first->frame_index;
+                cout << " is for a file already rolled over." << endl;
             #endif
 
-            writer->write_metadata_to_file();
+            stripe_ring_buffer.release(received_data.first->buffer_slot_index);
 
-            write_h5_format(writer->get_h5_file());
-        }
+            if (compression_pool) {
+                compression_pool->release();
+            }
 
-        #ifdef PERF_OUTPUT
-            using namespace date;
-            auto start_time_frame = std::chrono::system_clock::now();
-        #endif
+            writer_manager.dropped_frame(received_data.first->frame_index);
+            continue;
+        }
 
         // Write image data.
-        writer->write_data(raw_frames_dataset_name,
-                           received_data.first->frame_index, 
-                           received_data.second,
-                           received_data.first->frame_shape,
-                           received_data.first->frame_bytes_size, 
-                           received_data.first->type,
-                           received_data.first->endianness);
+        if (compressed_frame) {
+            writer.write_data(raw_frames_dataset_name,
+                              data_index, 
+                              compressed_frame->data,
+                              received_data.first->frame_shape,
+                              compressed_frame->data_bytes_size, 
+                              received_data.first->type,
+                              received_data.first->endianness,
+                              compressed_frame->filter_mask);
+        } else {
+            writer.write_data(raw_frames_dataset_name,
+                              data_index, 
+                              received_data.second,
+                              received_data.first->frame_shape,
+                              received_data.first->frame_bytes_size, 
+                              received_data.first->type,
+                              received_data.first->endianness);
+        }
+
+        auto written_bytes_size = compressed_frame ? 
+            compressed_frame->data_bytes_size : received_data.first->frame_bytes_size;
+
+        if (frames_per_file) {
+            writer_manager.set_file_index((data_index / frames_per_file) + 1);
+        }
 
         #ifdef PERF_OUTPUT
             using namespace date;
@@ -216,7 +548,11 @@ void ProcessManager::write_h5()
             cout << received_data.first->frame_index << " written in " << frame_diff_ms << " ms." << endl;
         #endif
 
-        ring_buffer.release(received_data.first->buffer_slot_index);
+        stripe_ring_buffer.release(received_data.first->buffer_slot_index);
+
+        if (compression_pool) {
+            compression_pool->release();
+        }
 
         #ifdef PERF_OUTPUT
             using namespace date;
@@ -224,26 +560,24 @@ void ProcessManager::write_h5()
         #endif
 
         // Write image metadata if mapping specified.
-        auto header_values_type = receiver.get_header_values_type();
-        if (header_values_type) {
-
-            for (const auto& header_type : *header_values_type) {
+        const char* header_values_record = received_data.first->header_values.data();
 
-                auto& name = header_type.first;
-                auto value = received_data.first->header_values.at(name);
+        for (const auto& field : header_decode_plan->get_fields()) {
+            writer.cache_metadata(field.name, data_index, header_values_record + field.offset);
+        }
 
-                // TODO: Ugly hack until we get the start sequence in the bsread stream itself.
-                if (name == "pulse_id") {
-                    if (!last_pulse_id) {
-                        last_pulse_id = *(reinterpret_cast<uint64_t*>(value.get()));
-                        notify_first_pulse_id(last_pulse_id);
-                    } else {
-                        last_pulse_id = *(reinterpret_cast<uint64_t*>(value.get()));
-                    }
-                }
+        // TODO: Ugly hack until we get the start sequence in the bsread stream itself.
+        if (pulse_id_field) {
+            // The fields are packed without padding - the value is not aligned.
+            uint64_t pulse_id;
+            memcpy(&pulse_id, header_values_record + pulse_id_field->offset, sizeof(pulse_id));
 
-                writer->cache_metadata(name, received_data.first->frame_index, value.get());
+            if (!first_pulse_id_sent.exchange(true)) {
+                notify_first_pulse_id(pulse_id);
             }
+
+            stripe_status.last_pulse_id = pulse_id;
+            stripe_status.last_frame_index = received_data.first->frame_index;
         }
 
         #ifdef PERF_OUTPUT
@@ -258,47 +592,91 @@ void ProcessManager::write_h5()
             cout << received_data.first->frame_index << " written in " << metadata_diff_ms << " ms." << endl;
         #endif
         
-        writer_manager.written_frame(received_data.first->frame_index);
-    }
+        stripe_status.n_frames = max(stripe_status.n_frames, data_index + 1);
 
-    // Send the last_pulse_id only if it was set.
-    if (last_pulse_id) {
-        notify_last_pulse_id(last_pulse_id);
+        writer_manager.written_frame(received_data.first->frame_index, written_bytes_size);
     }
 
-    if (writer->is_file_open()) {
-        #ifdef DEBUG_OUTPUT
-            using namespace date;
-            cout << "[" << std::chrono::system_clock::now() << "]";
-            cout << "[ProcessManager::write] Writing file format." << endl;
-        #endif
-
-        // Wait until all parameters are set or writer is killed.
-        while (!writer_manager.are_all_parameters_set() && !writer_manager.is_killed()) {
-            boost::this_thread::sleep_for(boost::chrono::milliseconds(config::parameters_read_retry_interval));
-        }
-
-        writer->write_metadata_to_file();
-        
-        write_h5_format(writer->get_h5_file());
-    }
-    
     #ifdef DEBUG_OUTPUT
         using namespace date;
         cout << "[" << std::chrono::system_clock::now() << "]";
-        cout << "[ProcessManager::write] Closing file " << writer_manager.get_output_file() << endl;
+        cout << "[ProcessManager::write_stripe] Stripe " << stripe_index << " wrote " << stripe_status.n_frames << " frames." << endl;
     #endif
-    
-    writer->close_file();
+}
+
+void ProcessManager::write_stripes_master_file(const vector<StripeStatus>& stripes_status)
+{
+    const size_t n_writers = stripe_ring_buffers.size();
+    const auto& output_file = writer_manager.get_output_file();
+    auto master_filename = VirtualDatasetUtils::get_master_filename(output_file);
 
     #ifdef DEBUG_OUTPUT
         using namespace date;
         cout << "[" << std::chrono::system_clock::now() << "]";
-        cout << "[ProcessManager::write] Writer thread stopped." << endl;
+        cout << "[ProcessManager::write_stripes_master_file] Writing master file " << master_filename << endl;
     #endif
 
-    // Exit when writer thread has closed the file.
-    exit(0);
+    vector<VirtualDatasetSource> sources;
+    for (size_t stripe_index=0; stripe_index<n_writers; stripe_index++) {
+        sources.push_back({VirtualDatasetUtils::get_filename(output_file, stripe_index + 1), 
+            stripes_status[stripe_index].n_frames, stripe_index, n_writers});
+    }
+
+    // The stripe files have their datasets at the place in the file format - same in the master file.
+    const auto& dataset_move_mapping = format.get_dataset_move_mapping();
+
+    auto get_dataset_path = [&](const string& dataset_name) {
+        auto mapping = dataset_move_mapping.find(dataset_name);
+        return mapping != dataset_move_mapping.end() ? mapping->second : dataset_name;
+    };
+
+    vector<VirtualDatasetDefinition> definitions;
+
+    auto first_stripe = find_if(stripes_status.begin(), stripes_status.end(), 
+        [](const StripeStatus& stripe_status) { return stripe_status.first_frame_metadata != nullptr; });
+
+    if (first_stripe != stripes_status.end()) {
+        const auto& first_frame_metadata = first_stripe->first_frame_metadata;
+
+        definitions.push_back({get_dataset_path(config::raw_image_dataset_name), get_dataset_path(config::raw_image_dataset_name), 
+            first_frame_metadata->frame_shape, first_frame_metadata->type, first_frame_metadata->endianness});
+    }
+
+    auto header_values_type = receiver.get_header_values_type();
+    if (header_values_type) {
+        for (const auto& header_type : *header_values_type) {
+            definitions.push_back({get_dataset_path(header_type.first), get_dataset_path(header_type.first), 
+                {header_type.second.value_shape}, header_type.second.type, header_type.second.endianness});
+        }
+    }
+
+    try {
+        H5::H5File master_file(master_filename.c_str(), H5F_ACC_TRUNC);
+
+        write_h5_skeleton(master_file);
+
+        for (const auto& definition : definitions) {
+            VirtualDatasetUtils::create_virtual_dataset(master_file, definition, sources);
+        }
+
+        write_h5_format(master_file);
+
+    } catch (const exception& ex) {
+        using namespace date;
+        std::cout << "[" << std::chrono::system_clock::now() << "]";
+        std::cout << "[ProcessManager::write_stripes_master_file] Error while writing master file: "<< ex.what() << endl;
+    }
+}
+
+void ProcessManager::write_h5_skeleton(H5::H5File& file) {
+
+    try {
+        format_plan.write_skeleton(file);
+    } catch (const runtime_error& ex) {
+        using namespace date;
+        std::cout << "[" << std::chrono::system_clock::now() << "]";
+        std::cout << "[ProcessManager::write_h5_skeleton] Error while trying to write file format skeleton: "<< ex.what() << endl;
+    }
 }
 
 void ProcessManager::write_h5_format(H5::H5File& file) {
@@ -311,10 +689,13 @@ void ProcessManager::write_h5_format(H5::H5File& file) {
         return;
     }
 
+    LatencyTimer latency_timer(LATENCY_FORMAT_WRITE);
+
     const auto parameters = writer_manager.get_parameters();
     
     try {
-        H5FormatUtils::write_format(file, format, parameters);
+        // The skeleton was written when the file was created.
+        format_plan.write(file, parameters, true);
     } catch (const runtime_error& ex) {
         using namespace date;
         std::cout << "[" << std::chrono::system_clock::now() << "]";
@@ -3,22 +3,53 @@
 
 #include "WriterManager.hpp"
 #include "H5Format.hpp"
+#include "H5FormatPlan.hpp"
 #include "RingBuffer.hpp"
 #include "ZmqReceiver.hpp"
+#include "BufferedWriter.hpp"
+#include <vector>
+#include <memory>
+#include <atomic>
 #include <chrono>
 #include "date.h"
 
+// What a striped writer has written - used for the master file and the last pulse_id.
+struct StripeStatus
+{
+    uint64_t n_frames = 0;
+    uint64_t last_frame_index = 0;
+    uint64_t last_pulse_id = 0;
+    std::shared_ptr<FrameMetadata> first_frame_metadata;
+};
+
 class ProcessManager 
 {
     WriterManager& writer_manager;
     ZmqReceiver& receiver;
     RingBuffer& ring_buffer;
     const H5Format& format;
+    // Compiled once, written on each file.
+    const H5FormatPlan format_plan;
 
     uint16_t rest_port;
     const std::string& bsread_rest_address;
     hsize_t frames_per_file;
 
+    // Frame i goes to the writer (i % n_writers) - the first ring buffer is the one passed in the constructor.
+    std::vector<RingBuffer*> stripe_ring_buffers;
+    std::vector<std::unique_ptr<RingBuffer>> owned_ring_buffers;
+    std::atomic_bool first_pulse_id_sent;
+
+    // Parallel receivers, each with its own socket - the receiver passed in the constructor if there is only one.
+    std::vector<ZmqReceiver*> receivers;
+    std::vector<std::unique_ptr<ZmqReceiver>> owned_receivers;
+    // The last receiver to stop shuts down the ring buffers.
+    std::atomic<size_t> n_running_receivers;
+
+    RingBuffer& get_frame_ring_buffer(uint64_t frame_index);
+    void write_stripe(size_t stripe_index, BufferedWriter& writer, StripeStatus& stripe_status);
+    void write_stripes_master_file(const std::vector<StripeStatus>& stripes_status);
+
     void notify_first_pulse_id(uint64_t pulse_id);
     void notify_last_pulse_id(uint64_t pulse_id);
 
@@ -28,10 +59,11 @@ class ProcessManager
 
         void run_writer();
 
-        void receive_zmq();
+        void receive_zmq(size_t receiver_index=0);
 
         void write_h5();
 
+        void write_h5_skeleton(H5::H5File& file);
         void write_h5_format(H5::H5File& file);
 };
 
@@ -3,9 +3,105 @@
 
 #include "crow_all.h"
 #include "RestApi.hpp"
+#include "LatencyMetrics.hpp"
 
 using namespace std;
 
+namespace {
+    void add_metric(stringstream& output, bool openmetrics, const string& name, const string& type, 
+        const string& help, double value)
+    {
+        // OpenMetrics counter families are named without the _total suffix of their sample.
+        string family_name = name;
+        if (openmetrics && type == "counter") {
+            family_name = name.substr(0, name.rfind("_total"));
+        }
+
+        output << "# HELP " << family_name << " " << help << "\n";
+        output << "# TYPE " << family_name << " " << type << "\n";
+        output << name << " " << value << "\n";
+    }
+}
+
+string RestApi::get_metrics_text(WriterManager& writer_manager, bool openmetrics)
+{
+    auto metrics = writer_manager.get_metrics();
+
+    stringstream output;
+    output.precision(15);
+
+    add_metric(output, openmetrics, "h5_writer_received_frames_total", "counter", 
+        "Frames received from the stream.", metrics["n_received_frames"]);
+    add_metric(output, openmetrics, "h5_writer_written_frames_total", "counter", 
+        "Frames written to the file.", metrics["n_written_frames"]);
+    add_metric(output, openmetrics, "h5_writer_written_bytes_total", "counter", 
+        "Frame bytes written to the file, after compression.", metrics["n_written_bytes"]);
+    // Lost frames can arrive late - not a counter.
+    add_metric(output, openmetrics, "h5_writer_lost_frames", "gauge", 
+        "Frames missing from the stream.", metrics["n_lost_frames"]);
+    add_metric(output, openmetrics, "h5_writer_expected_frames", "gauge", 
+        "Frames to write, 0 if not limited.", metrics["total_expected_frames"]);
+
+    add_metric(output, openmetrics, "h5_writer_average_frame_rate", "gauge", 
+        "Frames written per second since the first received frame.", metrics["average_frame_rate"]);
+    add_metric(output, openmetrics, "h5_writer_average_throughput_megabytes_per_second", "gauge", 
+        "MB written per second since the first received frame.", metrics["average_byte_rate"] / 1e6);
+
+    add_metric(output, openmetrics, "h5_writer_ring_buffer_used_slots", "gauge", 
+        "Ring buffer slots holding frames.", metrics["ring_buffer_used_slots"]);
+    add_metric(output, openmetrics, "h5_writer_ring_buffer_slots", "gauge", 
+        "Ring buffer slots in total.", metrics["ring_buffer_slots"]);
+    add_metric(output, openmetrics, "h5_writer_ring_buffer_max_used_slots", "gauge", 
+        "Ring buffer slots holding frames at most (high-water mark).", metrics["ring_buffer_max_used_slots"]);
+
+    add_metric(output, openmetrics, "h5_writer_spill_used_slots", "gauge", 
+        "Frames in the spill file.", metrics["spill_used_slots"]);
+    add_metric(output, openmetrics, "h5_writer_spill_slots", "gauge", 
+        "Frames fitting in the spill file, 0 before the first frame is spilled.", metrics["spill_slots"]);
+    add_metric(output, openmetrics, "h5_writer_spill_max_used_slots", "gauge", 
+        "Frames in the spill file at most (high-water mark).", metrics["spill_max_used_slots"]);
+    add_metric(output, openmetrics, "h5_writer_spilled_frames_total", "counter", 
+        "Frames written to the spill file.", metrics["n_spilled_frames"]);
+
+    add_metric(output, openmetrics, "h5_writer_ring_buffer_blocked_writes_total", "counter", 
+        "Frames that waited for a free ring buffer slot.", metrics["n_overflow_blocked_writes"]);
+    add_metric(output, openmetrics, "h5_writer_ring_buffer_blocked_seconds_total", "counter", 
+        "Time the receivers waited for a free ring buffer slot.", metrics["overflow_blocked_time_ms"] / 1000);
+    add_metric(output, openmetrics, "h5_writer_ring_buffer_dropped_newest_frames_total", "counter", 
+        "Frames discarded on write because the ring buffer was full.", metrics["n_overflow_dropped_newest_frames"]);
+    add_metric(output, openmetrics, "h5_writer_ring_buffer_dropped_oldest_frames_total", "counter", 
+        "Unread frames discarded to make room for new ones.", metrics["n_overflow_dropped_oldest_frames"]);
+
+    add_metric(output, openmetrics, "h5_writer_file_index", "gauge", 
+        "Index of the file being written, starting at 1 - 0 before the first file.", metrics["file_index"]);
+
+    add_metric(output, openmetrics, "h5_writer_chunk_write_seconds_total", "counter", 
+        "Time spent writing chunks with H5DOwrite_chunk.", 
+        LatencyMetrics::get_summary(LATENCY_CHUNK_WRITE).sum / 1e9);
+
+    output << "# HELP h5_writer_latency_seconds Latency of each writer stage.\n";
+    output << "# TYPE h5_writer_latency_seconds summary\n";
+
+    for (int stage=0; stage<LATENCY_N_STAGES; stage++) {
+        auto stage_name = LatencyMetrics::get_stage_name(static_cast<LatencyStage>(stage));
+        auto summary = LatencyMetrics::get_summary(static_cast<LatencyStage>(stage));
+
+        string labels = "stage=\"" + stage_name + "\"";
+
+        output << "h5_writer_latency_seconds{" << labels << ",quantile=\"0.5\"} " << summary.p50 / 1e9 << "\n";
+        output << "h5_writer_latency_seconds{" << labels << ",quantile=\"0.99\"} " << summary.p99 / 1e9 << "\n";
+        output << "h5_writer_latency_seconds{" << labels << ",quantile=\"0.999\"} " << summary.p999 / 1e9 << "\n";
+        output << "h5_writer_latency_seconds_sum{" << labels << "} " << summary.sum / 1e9 << "\n";
+        output << "h5_writer_latency_seconds_count{" << labels << "} " << summary.count << "\n";
+    }
+
+    if (openmetrics) {
+        output << "# EOF\n";
+    }
+
+    return output.str();
+}
+
 void RestApi::start_rest_api(WriterManager& writer_manager, uint16_t port)
 {
 
@@ -52,11 +148,57 @@ void RestApi::start_rest_api(WriterManager& writer_manager, uint16_t port)
             result[item.first] = item.second;
         }
 
+        // [first, last] frame index ranges.
+        auto missing_frames = writer_manager.get_missing_frames();
+        result["missing_frames"] = vector<crow::json::wvalue>();
+
+        for (size_t index=0; index<missing_frames.size(); index++) {
+            result["missing_frames"][static_cast<unsigned>(index)][0] = missing_frames[index].first;
+            result["missing_frames"][static_cast<unsigned>(index)][1] = missing_frames[index].second;
+        }
+
         result["status"] = writer_manager.get_status();
 
         return result;
     });
 
+    CROW_ROUTE (app, "/metrics") ([&](const crow::request& req){
+        auto accept = req.get_header_value("Accept");
+
+        // Prometheus text format, OpenMetrics if the scraper asks for it.
+        if (accept.find("application/openmetrics-text") != string::npos) {
+            crow::response response(get_metrics_text(writer_manager, true));
+            response.set_header("Content-Type", "application/openmetrics-text; version=1.0.0; charset=utf-8");
+            return response;
+        }
+
+        crow::response response(get_metrics_text(writer_manager));
+        response.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        return response;
+    });
+
+    CROW_ROUTE (app, "/metrics/latency") ([&](){
+        crow::json::wvalue result;
+
+        // Latencies in us.
+        for (int stage=0; stage<LATENCY_N_STAGES; stage++) {
+            auto stage_name = LatencyMetrics::get_stage_name(static_cast<LatencyStage>(stage));
+            auto summary = LatencyMetrics::get_summary(static_cast<LatencyStage>(stage));
+
+            result[stage_name]["count"] = summary.count;
+            result[stage_name]["p50"] = summary.p50 / 1000.0;
+            result[stage_name]["p99"] = summary.p99 / 1000.0;
+            result[stage_name]["p999"] = summary.p999 / 1000.0;
+            result[stage_name]["max"] = summary.max / 1000.0;
+        }
+
+        for (const auto& metric : writer_manager.get_metrics()) {
+            result["writer"][metric.first] = metric.second;
+        }
+
+        return crow::response(result);
+    });
+
     CROW_ROUTE (app, "/parameters").methods("GET"_method, "POST"_method) ([&](const crow::request& req){
         crow::json::wvalue result;
         auto parameters_type = writer_manager.get_parameters_type();
@@ -8,6 +8,9 @@
 namespace RestApi
 {
     void start_rest_api(WriterManager& writer_manager, uint16_t port);
+
+    // Metrics in the Prometheus text exposition format, or OpenMetrics if openmetrics is set.
+    std::string get_metrics_text(WriterManager& writer_manager, bool openmetrics=false);
 }
 
 #endif
\ No newline at end of file
@@ -8,7 +8,11 @@
 
 using namespace std;
 
-RingBuffer::RingBuffer(size_t n_slots) : n_slots(n_slots), ringbuffer_slots(n_slots, 0)
+RingBuffer::RingBuffer(size_t n_slots, const RingBufferMemoryOptions& memory_options) : 
+    ringbuffer_slots(n_slots, 0), memory_options(memory_options), reader_waiting(false), shutdown_flag(false), 
+    n_released_slots(0), n_blocked_writes(0), blocked_time(0), n_dropped_newest_frames(0), 
+    n_dropped_oldest_frames(0), n_writers_waiting(0), n_slots(n_slots), ringbuffer_slots_owned_data(n_slots), 
+    ring_buffer_initialized(false), max_used_slots(0)
 {
     #ifdef DEBUG_OUTPUT
         using namespace date;
@@ -21,7 +25,7 @@ RingBuffer::~RingBuffer()
 {
     // If the frame buffer is allocated, free it.
     if (frame_data_buffer != NULL) {
-        free(frame_data_buffer);
+        RingBufferMemory::release(frame_data_buffer, buffer_size);
         frame_data_buffer = NULL;
     }
 }
@@ -44,10 +48,16 @@ void RingBuffer::initialize(size_t slot_size)
         cout << "[RingBuffer::initialize] Initializing ring buffer with slot_size " << slot_size << endl;
     #endif
     
+    if (memory_options.slot_alignment) {
+        slot_size = ((slot_size + memory_options.slot_alignment - 1) / memory_options.slot_alignment) * 
+            memory_options.slot_alignment;
+    }
+
     this->write_index = 0;
     this->slot_size = slot_size;
+    // Rounded up to the page size.
     this->buffer_size = slot_size * n_slots;
-    this->frame_data_buffer = new char[buffer_size];
+    this->frame_data_buffer = RingBufferMemory::allocate(buffer_size, memory_options);
     this->buffer_used_slots = 0;
     this->ring_buffer_initialized = true;
 
@@ -58,58 +68,254 @@ void RingBuffer::initialize(size_t slot_size)
     #endif
 }
 
-void RingBuffer::write(shared_ptr<FrameMetadata> frame_metadata, const char* data)
+RingBufferOverflowPolicy get_ring_buffer_overflow_policy(const string& policy_name)
 {
-    // Initialize the buffer on the first write.
-    if (!ring_buffer_initialized) {
-        initialize(frame_metadata->frame_bytes_size);
+    if (policy_name == "error") {
+        return RING_BUFFER_OVERFLOW_ERROR;
+    } else if (policy_name == "block") {
+        return RING_BUFFER_OVERFLOW_BLOCK;
+    } else if (policy_name == "drop_newest") {
+        return RING_BUFFER_OVERFLOW_DROP_NEWEST;
+    } else if (policy_name == "drop_oldest") {
+        return RING_BUFFER_OVERFLOW_DROP_OLDEST;
     }
 
-    // All images must fit in the ring buffer.
-    if (frame_metadata->frame_bytes_size > slot_size) {
+    stringstream error_message;
+    using namespace date;
+    error_message << "[" << std::chrono::system_clock::now() << "]";
+    error_message << "[get_ring_buffer_overflow_policy] Unknown ring buffer overflow policy " << policy_name;
+    error_message << ". Available: error, block, drop_newest, drop_oldest." << endl;
+
+    throw runtime_error(error_message.str());
+}
+
+void RingBuffer::set_overflow_policy(RingBufferOverflowPolicy overflow_policy)
+{
+    this->overflow_policy = overflow_policy;
+}
+
+void RingBuffer::set_dropped_frame_callback(function<void(uint64_t)> dropped_frame_callback)
+{
+    this->dropped_frame_callback = dropped_frame_callback;
+}
+
+RingBufferOverflowStatistics RingBuffer::get_overflow_statistics() const
+{
+    RingBufferOverflowStatistics statistics;
+
+    statistics.n_blocked_writes = n_blocked_writes.load(memory_order_relaxed);
+    statistics.blocked_time = blocked_time.load(memory_order_relaxed);
+    statistics.n_dropped_newest_frames = n_dropped_newest_frames.load(memory_order_relaxed);
+    statistics.n_dropped_oldest_frames = n_dropped_oldest_frames.load(memory_order_relaxed);
+
+    return statistics;
+}
+
+void RingBuffer::set_spill_buffer(unique_ptr<SpillBuffer> spill_buffer, size_t spill_threshold)
+{
+    this->spill_buffer = move(spill_buffer);
+    this->spill_threshold = spill_threshold;
+}
+
+SpillBufferStatistics RingBuffer::get_spill_statistics() const
+{
+    if (!spill_buffer) {
+        return SpillBufferStatistics();
+    }
+
+    return spill_buffer->get_statistics();
+}
+
+bool RingBuffer::spill_frame(const shared_ptr<FrameMetadata>& frame_metadata, const char* data)
+{
+    if (!spill_buffer) {
+        return false;
+    }
+
+    // Once frames are spilled, the next ones follow them until the reader has read them all.
+    if (!spill_buffer->has_frames() && get_n_used_slots() < spill_threshold) {
+        return false;
+    }
+
+    // The spill buffer is full - the slots are used (out of order) if there is still space.
+    frame_metadata->commit_time = std::chrono::steady_clock::now();
+    if (!spill_buffer->append(frame_metadata, data)) {
+        return false;
+    }
+
+    notify_reader();
+
+    return true;
+}
+
+pair<shared_ptr<FrameMetadata>, char*> RingBuffer::read_spilled_frame()
+{
+    if (!spill_buffer) {
+        return {NULL, NULL};
+    }
+
+    size_t read_slot_index;
+    auto received_data = spill_buffer->read(read_slot_index);
+
+    if (received_data.first) {
+        received_data.first->buffer_slot_index = n_slots + read_slot_index;
+    }
+
+    return received_data;
+}
+
+bool RingBuffer::reserve_slot_or_overflow(const shared_ptr<FrameMetadata>& frame_metadata)
+{
+    if (reserve_slot(frame_metadata)) {
+        return true;
+    }
+
+    if (overflow_policy == RING_BUFFER_OVERFLOW_DROP_NEWEST) {
+        n_dropped_newest_frames++;
+
+        #ifdef DEBUG_OUTPUT
+            using namespace date;
+            cout << "[" << std::chrono::system_clock::now() << "]";
+            cout << "[RingBuffer::reserve_slot_or_overflow] Ring buffer is full, dropping frame_index ";
+            cout << frame_metadata->frame_index << endl;
+        #endif
+
+        return false;
+
+    } else if (overflow_policy == RING_BUFFER_OVERFLOW_ERROR) {
         stringstream error_message;
         using namespace date;
         error_message << "[" << std::chrono::system_clock::now() << "]";
-        error_message << "[RingBuffer::write] Received frame index "<< frame_metadata->frame_index;
-        error_message << " that is too large for ring buffer slot. ";
-        error_message << "Slot size " << slot_size << ", but frame bytes size " << frame_metadata->frame_bytes_size << endl;
+        error_message << "[RingBuffer::reserve_slot_or_overflow] Ring buffer is full. Cannot write frame_index ";
+        error_message << frame_metadata->frame_index << endl;
 
         throw runtime_error(error_message.str());
     }
 
-    // Check and reserve slot in the buffer.
+    // At most one frame per write - if the reader holds the slot we need, dropping more does not help.
+    if (overflow_policy == RING_BUFFER_OVERFLOW_DROP_OLDEST && drop_oldest_frame() && reserve_slot(frame_metadata)) {
+        return true;
+    }
+
+    wait_for_free_slot(frame_metadata);
+
+    return true;
+}
+
+bool RingBuffer::drop_oldest_frame()
+{
+    shared_ptr<FrameMetadata> frame_metadata;
     {
-        lock_guard<mutex> lock(ringbuffer_slots_mutex);
+        lock_guard<mutex> lock(drop_oldest_mutex);
 
-        if (!ringbuffer_slots[write_index]) {
-            ringbuffer_slots[write_index] = 1;
-            
-            // Set the write index in the FrameMetadata object.
-            frame_metadata->buffer_slot_index = write_index;
+        frame_metadata = take_committed_slot();
+    }
 
-            #ifdef DEBUG_OUTPUT
-                using namespace date;
-                cout << "[" << std::chrono::system_clock::now() << "]";
-                cout << "[RingBuffer::write] Ring buffer slot " << frame_metadata->buffer_slot_index << " reserved for frame_index ";
-                cout << frame_metadata->frame_index << endl;
-            #endif
+    // Nothing committed yet - the slots are reserved by other producers or held by the reader.
+    if (!frame_metadata) {
+        return false;
+    }
 
-            // Increase and wrap the write index around if needed.
-            write_index = (write_index + 1) % n_slots;
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[RingBuffer::drop_oldest_frame] Ring buffer is full, dropping frame_index " << frame_metadata->frame_index << endl;
+    #endif
 
-            // Keep track of the number of used slots.
-            buffer_used_slots++;
+    release(frame_metadata->buffer_slot_index);
+    n_dropped_oldest_frames++;
 
-        } else {
-            stringstream error_message;
-            using namespace date;
-            error_message << "[" << std::chrono::system_clock::now() << "]";
-            error_message << "[RingBuffer::write] Ring buffer is full. Collision at write_index = " << write_index << endl;
+    if (dropped_frame_callback) {
+        dropped_frame_callback(frame_metadata->frame_index);
+    }
 
-            throw runtime_error(error_message.str());
+    return true;
+}
+
+void RingBuffer::wait_for_free_slot(const shared_ptr<FrameMetadata>& frame_metadata)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[RingBuffer::wait_for_free_slot] Ring buffer is full, waiting to write frame_index ";
+        cout << frame_metadata->frame_index << endl;
+    #endif
+
+    auto start_time = std::chrono::steady_clock::now();
+    n_blocked_writes++;
+
+    while (true) {
+        uint64_t released_slots = n_released_slots.load();
+
+        if (reserve_slot(frame_metadata)) {
+            break;
+        }
+
+        unique_lock<mutex> lock(writer_wakeup_mutex);
+
+        n_writers_waiting++;
+        // Pairs with the fence in notify_writers(): either we see the released slot or the reader sees us waiting.
+        atomic_thread_fence(memory_order_seq_cst);
+
+        // The timeout only guards against a reader that stopped releasing.
+        writer_wakeup.wait_for(lock, chrono::milliseconds(100), [&](){
+            return n_released_slots.load() != released_slots;
+        });
+
+        n_writers_waiting--;
+    }
+
+    blocked_time += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+}
+
+void RingBuffer::notify_writers()
+{
+    // Only these policies wait for a free slot.
+    if (overflow_policy != RING_BUFFER_OVERFLOW_BLOCK && overflow_policy != RING_BUFFER_OVERFLOW_DROP_OLDEST) {
+        return;
+    }
+
+    atomic_thread_fence(memory_order_seq_cst);
+
+    // Skip the syscall if nobody is waiting.
+    if (n_writers_waiting.load(memory_order_relaxed)) {
+        lock_guard<mutex> lock(writer_wakeup_mutex);
+        writer_wakeup.notify_all();
+    }
+}
+
+bool RingBuffer::write(shared_ptr<FrameMetadata> frame_metadata, const char* data)
+{
+    // Initialize the buffer on the first write - with multiple producers only one of them does it.
+    if (!ring_buffer_initialized.load(memory_order_acquire)) {
+        lock_guard<mutex> lock(initialize_mutex);
+
+        if (!ring_buffer_initialized.load(memory_order_relaxed)) {
+            initialize(frame_metadata->frame_bytes_size);
         }
     }
 
+    // All images must fit in the ring buffer.
+    if (frame_metadata->frame_bytes_size > slot_size) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[RingBuffer::write] Received frame index "<< frame_metadata->frame_index;
+        error_message << " that is too large for ring buffer slot. ";
+        error_message << "Slot size " << slot_size << ", but frame bytes size " << frame_metadata->frame_bytes_size << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    if (spill_frame(frame_metadata, data)) {
+        return true;
+    }
+
+    if (!reserve_slot_or_overflow(frame_metadata)) {
+        return false;
+    }
+
     // The slot is already reserved, no need for synchronization.
     char* slot_memory_address = get_buffer_slot_address(frame_metadata->buffer_slot_index);
     memcpy(slot_memory_address, data, frame_metadata->frame_bytes_size);
@@ -121,6 +327,76 @@ void RingBuffer::write(shared_ptr<FrameMetadata> frame_metadata, const char* dat
         cout << frame_metadata->buffer_slot_index << endl;
     #endif
 
+    frame_metadata->commit_time = std::chrono::steady_clock::now();
+    commit_slot(frame_metadata);
+
+    notify_reader();
+
+    return true;
+}
+
+bool RingBuffer::write(shared_ptr<FrameMetadata> frame_metadata, shared_ptr<char> data)
+{
+    // The spill buffer copies the data, the received message is freed right away.
+    if (spill_frame(frame_metadata, data.get())) {
+        return true;
+    }
+
+    if (!reserve_slot_or_overflow(frame_metadata)) {
+        return false;
+    }
+
+    // The slot is already reserved, no need for synchronization. The slot holds the data until released.
+    ringbuffer_slots_owned_data[frame_metadata->buffer_slot_index] = data;
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[RingBuffer::write] Took ownership of " << frame_metadata->frame_bytes_size << " frame bytes in buffer_slot_index ";
+        cout << frame_metadata->buffer_slot_index << endl;
+    #endif
+
+    frame_metadata->commit_time = std::chrono::steady_clock::now();
+    commit_slot(frame_metadata);
+
+    notify_reader();
+
+    return true;
+}
+
+bool RingBuffer::reserve_slot(const shared_ptr<FrameMetadata>& frame_metadata)
+{
+    lock_guard<mutex> lock(ringbuffer_slots_mutex);
+
+    if (!ringbuffer_slots[write_index]) {
+        ringbuffer_slots[write_index] = 1;
+        
+        // Set the write index in the FrameMetadata object.
+        frame_metadata->buffer_slot_index = write_index;
+
+        #ifdef DEBUG_OUTPUT
+            using namespace date;
+            cout << "[" << std::chrono::system_clock::now() << "]";
+            cout << "[RingBuffer::reserve_slot] Ring buffer slot " << frame_metadata->buffer_slot_index << " reserved for frame_index ";
+            cout << frame_metadata->frame_index << endl;
+        #endif
+
+        // Increase and wrap the write index around if needed.
+        write_index = (write_index + 1) % n_slots;
+
+        // Keep track of the number of used slots.
+        buffer_used_slots++;
+        update_max_used_slots(buffer_used_slots);
+
+        return true;
+    }
+
+    // Full - the slot at write_index is not released yet.
+    return false;
+}
+
+void RingBuffer::commit_slot(const shared_ptr<FrameMetadata>& frame_metadata)
+{
     // Add metadata header to the inter-thread communication queue.
     {
         lock_guard<mutex> lock(frame_metadata_queue_mutex);
@@ -131,7 +407,7 @@ void RingBuffer::write(shared_ptr<FrameMetadata> frame_metadata, const char* dat
     #ifdef DEBUG_OUTPUT
         using namespace date;
         cout << "[" << std::chrono::system_clock::now() << "]";
-        cout << "[RingBuffer::write] Metadata for frame_index " << frame_metadata->frame_index << " added to metadata queue." << endl;
+        cout << "[RingBuffer::commit_slot] Metadata for frame_index " << frame_metadata->frame_index << " added to metadata queue." << endl;
     #endif
 }
 
@@ -153,7 +429,7 @@ char* RingBuffer::get_buffer_slot_address(size_t buffer_slot_index)
     return slot_memory_address;
 }
 
-pair<shared_ptr<FrameMetadata>, char*> RingBuffer::read()
+shared_ptr<FrameMetadata> RingBuffer::take_committed_slot()
 {
     shared_ptr<FrameMetadata> frame_metadata;
 
@@ -161,21 +437,14 @@ pair<shared_ptr<FrameMetadata>, char*> RingBuffer::read()
     {
         lock_guard<mutex> lock(frame_metadata_queue_mutex);
 
-        // A NULL char* indicates that there are no available data in the ring buffer.
         if (frame_metadata_queue.empty()) {
-            return {NULL, NULL};
+            return NULL;
         }
 
         frame_metadata = frame_metadata_queue.front();
         frame_metadata_queue.pop_front();
     }
 
-    #ifdef DEBUG_OUTPUT
-        using namespace date;
-        cout << "[" << std::chrono::system_clock::now() << "]";
-        cout << "[RingBuffer::read] Received metadata for frame_index " << frame_metadata->frame_index << endl;
-    #endif
-
     // Check if the references ring buffer slot is valid.
     {
         lock_guard<mutex> lock(ringbuffer_slots_mutex);
@@ -184,20 +453,125 @@ pair<shared_ptr<FrameMetadata>, char*> RingBuffer::read()
             stringstream error_message;
             using namespace date;
             error_message << "[" << std::chrono::system_clock::now() << "]";
-            error_message << "[RingBuffer::read] Ring buffer slot referenced in message header ";
+            error_message << "[RingBuffer::take_committed_slot] Ring buffer slot referenced in message header ";
             error_message << frame_metadata->buffer_slot_index << " is empty." << endl;
 
             throw runtime_error(error_message.str());
         }
     }
 
+    return frame_metadata;
+}
+
+pair<shared_ptr<FrameMetadata>, char*> RingBuffer::read()
+{
+    shared_ptr<FrameMetadata> frame_metadata;
+
+    if (overflow_policy == RING_BUFFER_OVERFLOW_DROP_OLDEST) {
+        lock_guard<mutex> lock(drop_oldest_mutex);
+
+        frame_metadata = take_committed_slot();
+    } else {
+        frame_metadata = take_committed_slot();
+    }
+
+    // The frames in the slots are older than the spilled ones.
+    if (!frame_metadata) {
+        auto received_data = read_spilled_frame();
+
+        if (received_data.first) {
+            LatencyMetrics::record(LATENCY_RING_BUFFER_WAIT, std::chrono::steady_clock::now() - received_data.first->commit_time);
+        }
+
+        // A NULL char* indicates that there are no available data in the ring buffer.
+        return received_data;
+    }
+
+    LatencyMetrics::record(LATENCY_RING_BUFFER_WAIT, std::chrono::steady_clock::now() - frame_metadata->commit_time);
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[RingBuffer::read] Received metadata for frame_index " << frame_metadata->frame_index << endl;
+    #endif
+
+    // Frames written without copy live outside the ring buffer memory.
+    const auto& owned_data = ringbuffer_slots_owned_data[frame_metadata->buffer_slot_index];
+    if (owned_data) {
+        return {frame_metadata, owned_data.get()};
+    }
+
     char* slot_memory_address = get_buffer_slot_address(frame_metadata->buffer_slot_index);
             
     return {frame_metadata, slot_memory_address};
 }
 
+pair<shared_ptr<FrameMetadata>, char*> RingBuffer::read_wait(uint32_t timeout)
+{
+    auto received_data = read();
+
+    if (received_data.first || shutdown_flag.load()) {
+        return received_data;
+    }
+
+    {
+        unique_lock<mutex> lock(reader_wakeup_mutex);
+
+        reader_waiting.store(true, memory_order_relaxed);
+        // Pairs with the fence in notify_reader(): either we see the committed frame or the writer sees us waiting.
+        atomic_thread_fence(memory_order_seq_cst);
+
+        reader_wakeup.wait_for(lock, chrono::milliseconds(timeout), [this](){
+            return shutdown_flag.load() || has_committed_slots() || (spill_buffer && spill_buffer->can_read());
+        });
+
+        reader_waiting.store(false, memory_order_relaxed);
+    }
+
+    return read();
+}
+
+void RingBuffer::notify_reader()
+{
+    atomic_thread_fence(memory_order_seq_cst);
+
+    // Skip the syscall if nobody is waiting.
+    if (reader_waiting.load(memory_order_relaxed)) {
+        lock_guard<mutex> lock(reader_wakeup_mutex);
+        reader_wakeup.notify_one();
+    }
+}
+
+void RingBuffer::shutdown()
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[RingBuffer::shutdown] Waking up the reader - no more frames will be written." << endl;
+    #endif
+
+    shutdown_flag = true;
+
+    lock_guard<mutex> lock(reader_wakeup_mutex);
+    reader_wakeup.notify_all();
+}
+
+bool RingBuffer::is_shutdown() const
+{
+    return shutdown_flag.load();
+}
+
 void RingBuffer::release(size_t buffer_slot_index)
 {
+    // Read from the spill buffer.
+    if (spill_buffer && buffer_slot_index >= n_slots && buffer_slot_index < n_slots + spill_buffer->get_n_read_slots()) {
+        spill_buffer->release(buffer_slot_index - n_slots);
+
+        // The reader might wait for a free read slot.
+        notify_reader();
+        return;
+    }
+
     // Cannot release a slot index that is out of range.
     if (buffer_slot_index >= n_slots) {
         stringstream error_message;
@@ -209,30 +583,76 @@ void RingBuffer::release(size_t buffer_slot_index)
         throw runtime_error(error_message.str());
     }
 
-    // Release the buffer slot.
-    {
-        lock_guard<mutex> lock(ringbuffer_slots_mutex);
+    // Free the received data (if the slot owns it) outside of the lock - deallocation might be slow.
+    ringbuffer_slots_owned_data[buffer_slot_index].reset();
 
-        if (ringbuffer_slots[buffer_slot_index]) {
-            ringbuffer_slots[buffer_slot_index] = 0;
+    free_slot(buffer_slot_index);
 
-            // Keep track of the number of used slots.
-            buffer_used_slots--;
+    n_released_slots++;
+    notify_writers();
+}
 
-        } else {
-            stringstream error_message;
-            using namespace date;
-            error_message << "[" << std::chrono::system_clock::now() << "]";
-            error_message << "[RingBuffer::release] Cannot release empty ring buffer slot " << buffer_slot_index << endl;
+void RingBuffer::free_slot(size_t buffer_slot_index)
+{
+    lock_guard<mutex> lock(ringbuffer_slots_mutex);
 
-            throw runtime_error(error_message.str());
-        }
+    if (ringbuffer_slots[buffer_slot_index]) {
+        ringbuffer_slots[buffer_slot_index] = 0;
+
+        // Keep track of the number of used slots.
+        buffer_used_slots--;
+
+    } else {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[RingBuffer::free_slot] Cannot release empty ring buffer slot " << buffer_slot_index << endl;
+
+        throw runtime_error(error_message.str());
     }
 }
 
-bool RingBuffer::is_empty()
+bool RingBuffer::has_committed_slots()
+{
+    lock_guard<mutex> lock(frame_metadata_queue_mutex);
+
+    return !frame_metadata_queue.empty();
+}
+
+bool RingBuffer::are_slots_empty()
 {
     lock_guard<mutex> lock(ringbuffer_slots_mutex);
     
     return buffer_used_slots == 0;
 }
+
+bool RingBuffer::is_empty()
+{
+    return are_slots_empty() && (!spill_buffer || spill_buffer->is_empty());
+}
+
+size_t RingBuffer::get_n_used_slots()
+{
+    lock_guard<mutex> lock(ringbuffer_slots_mutex);
+
+    return buffer_used_slots;
+}
+
+void RingBuffer::update_max_used_slots(size_t n_used_slots)
+{
+    // Only grows - a relaxed load is enough to skip the common case.
+    if (n_used_slots > max_used_slots.load(memory_order_relaxed)) {
+        size_t current_max = max_used_slots.load(memory_order_relaxed);
+        while (n_used_slots > current_max && !max_used_slots.compare_exchange_weak(current_max, n_used_slots)) {}
+    }
+}
+
+size_t RingBuffer::get_max_used_slots() const
+{
+    return max_used_slots.load(memory_order_relaxed);
+}
+
+size_t RingBuffer::get_n_slots() const
+{
+    return n_slots;
+}
@@ -3,14 +3,20 @@
 
 #include <list>
 #include <vector>
-#include <map>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <functional>
 #include <boost/any.hpp>
 #include <chrono>
 #include "date.h"
 
+#include "RingBufferMemory.hpp"
+#include "SpillBuffer.hpp"
+#include "LatencyMetrics.hpp"
+
 struct FrameMetadata
 {
     // Ring buffer needed data.
@@ -23,42 +29,153 @@ struct FrameMetadata
     std::string type;
     std::vector<size_t> frame_shape;
 
-    // Pass additional header values.
-    std::map<std::string, std::shared_ptr<char>> header_values;
+    // Pass additional header values - one record, laid out by the HeaderDecodePlan.
+    std::vector<char> header_values;
+
+    // When the frame was committed to the ring buffer.
+    std::chrono::steady_clock::time_point commit_time;
+};
+
+// What write() does when the ring buffer is full.
+enum RingBufferOverflowPolicy
+{
+    // Throw - the receiver stops.
+    RING_BUFFER_OVERFLOW_ERROR,
+    // Wait for a free slot. The receiver stops reading, so ZMQ queues up to its receive high water mark 
+    // and then pushes back to the sender.
+    RING_BUFFER_OVERFLOW_BLOCK,
+    // Discard the frame being written.
+    RING_BUFFER_OVERFLOW_DROP_NEWEST,
+    // The writer evicts the oldest unread frame to free its slot (at most one per write). It waits only while the 
+    // reader still holds the slot it needs.
+    RING_BUFFER_OVERFLOW_DROP_OLDEST
+};
+
+RingBufferOverflowPolicy get_ring_buffer_overflow_policy(const std::string& policy_name);
+
+struct RingBufferOverflowStatistics
+{
+    // Writes that had to wait for a free slot, and how long they waited in total (ns).
+    uint64_t n_blocked_writes = 0;
+    uint64_t blocked_time = 0;
+    uint64_t n_dropped_newest_frames = 0;
+    uint64_t n_dropped_oldest_frames = 0;
 };
 
 class RingBuffer
 {
     // Initialized in constructor.
-    size_t n_slots = 0;
     std::vector<bool> ringbuffer_slots;    
+    const RingBufferMemoryOptions memory_options;
 
     // Set in initialize().
-    size_t slot_size = 0;
     size_t buffer_size = 0;
     char* frame_data_buffer = NULL;
     size_t write_index = 0;
     size_t buffer_used_slots = 0;
-    bool ring_buffer_initialized = false;
 
     std::list< std::shared_ptr<FrameMetadata> > frame_metadata_queue;
     std::mutex frame_metadata_queue_mutex;
     std::mutex ringbuffer_slots_mutex;
 
-    char* get_buffer_slot_address(size_t buffer_slot_index);
+    // Wakeup for the consumer waiting in read_wait().
+    std::mutex reader_wakeup_mutex;
+    std::condition_variable reader_wakeup;
+    std::atomic_bool reader_waiting;
+    std::atomic_bool shutdown_flag;
+
+    void notify_reader();
+
+    // Overflow handling.
+    RingBufferOverflowPolicy overflow_policy = RING_BUFFER_OVERFLOW_ERROR;
+    std::function<void(uint64_t)> dropped_frame_callback;
+    // The producers take the oldest frame out of the queue as well - only locked with RING_BUFFER_OVERFLOW_DROP_OLDEST.
+    std::mutex drop_oldest_mutex;
+    std::atomic<uint64_t> n_released_slots;
+
+    std::atomic<uint64_t> n_blocked_writes;
+    std::atomic<uint64_t> blocked_time;
+    std::atomic<uint64_t> n_dropped_newest_frames;
+    std::atomic<uint64_t> n_dropped_oldest_frames;
+
+    // Wakeup for the producers waiting for a free slot.
+    std::mutex writer_wakeup_mutex;
+    std::condition_variable writer_wakeup;
+    std::atomic<size_t> n_writers_waiting;
+
+    // Second tier, used once spill_threshold slots are taken.
+    std::unique_ptr<SpillBuffer> spill_buffer;
+    size_t spill_threshold = 0;
+
+    bool spill_frame(const std::shared_ptr<FrameMetadata>& frame_metadata, const char* data);
+    std::pair<std::shared_ptr<FrameMetadata>, char*> read_spilled_frame();
+
+    bool reserve_slot_or_overflow(const std::shared_ptr<FrameMetadata>& frame_metadata);
+    bool drop_oldest_frame();
+    void wait_for_free_slot(const std::shared_ptr<FrameMetadata>& frame_metadata);
+    void notify_writers();
+
+    protected:
+        // Initialized in constructor.
+        size_t n_slots = 0;
+        // Frames written without copy - the slot keeps the received data alive until released.
+        std::vector<std::shared_ptr<char>> ringbuffer_slots_owned_data;
+
+        // Set in initialize().
+        size_t slot_size = 0;
+        std::atomic_bool ring_buffer_initialized;
+        std::mutex initialize_mutex;
+
+        // High-water mark of the used slots.
+        std::atomic<size_t> max_used_slots;
+        void update_max_used_slots(size_t n_used_slots);
+
+        char* get_buffer_slot_address(size_t buffer_slot_index);
+
+        // Synchronization between the producer and the consumer. reserve_slot returns false if the buffer is full.
+        virtual bool reserve_slot(const std::shared_ptr<FrameMetadata>& frame_metadata);
+        virtual void commit_slot(const std::shared_ptr<FrameMetadata>& frame_metadata);
+        virtual std::shared_ptr<FrameMetadata> take_committed_slot();
+        virtual void free_slot(size_t buffer_slot_index);
+        virtual bool has_committed_slots();
+        virtual bool are_slots_empty();
 
     public:
-        RingBuffer(size_t n_slots);
+        RingBuffer(size_t n_slots, const RingBufferMemoryOptions& memory_options=RingBufferMemoryOptions());
         virtual ~RingBuffer();
         void initialize(size_t slot_size);
+
+        // The callback gets the frame_index of each frame discarded by RING_BUFFER_OVERFLOW_DROP_OLDEST - 
+        // it is called by the producer. Set both before the first write.
+        void set_overflow_policy(RingBufferOverflowPolicy overflow_policy);
+        void set_dropped_frame_callback(std::function<void(uint64_t)> dropped_frame_callback);
+        RingBufferOverflowStatistics get_overflow_statistics() const;
+
+        // Once spill_threshold slots are used, frames go to the spill buffer - and keep going there until the reader 
+        // has read all of them, so the frame order is kept. Read frames get the buffer_slot_index n_slots + read slot.
+        // Set before the first write.
+        void set_spill_buffer(std::unique_ptr<SpillBuffer> spill_buffer, size_t spill_threshold);
+        SpillBufferStatistics get_spill_statistics() const;
         
-        void write(
+        // Return false if the frame was discarded by RING_BUFFER_OVERFLOW_DROP_NEWEST.
+        bool write(
             const std::shared_ptr<FrameMetadata> metadata,
             const char* data
         );
+        bool write(
+            const std::shared_ptr<FrameMetadata> metadata,
+            std::shared_ptr<char> data
+        );
         std::pair<std::shared_ptr<FrameMetadata>, char*> read();
+        std::pair<std::shared_ptr<FrameMetadata>, char*> read_wait(uint32_t timeout);
+        void shutdown();
+        bool is_shutdown() const;
         void release(size_t buffer_slot_index);
+        // No frames in the slots or the spill buffer.
         bool is_empty();
+        virtual size_t get_n_used_slots();
+        size_t get_max_used_slots() const;
+        size_t get_n_slots() const;
 };
 
 #endif
@@ -0,0 +1,202 @@
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "RingBufferMemory.hpp"
+#include "config.hpp"
+
+using namespace std;
+
+#ifdef __linux__
+namespace {
+    // From linux/mempolicy.h - no libnuma needed for mbind.
+    const int MEMORY_POLICY_PREFERRED = 1;
+
+    int get_hugepage_flags(size_t hugepage_size)
+    {
+        // Hugepage size as log2 in the mmap flags.
+        int hugepage_size_log2 = 0;
+        while ((1UL << hugepage_size_log2) < hugepage_size) {
+            hugepage_size_log2++;
+        }
+
+        return MAP_HUGETLB | (hugepage_size_log2 << MAP_HUGE_SHIFT);
+    }
+
+    size_t round_up(size_t size, size_t page_size)
+    {
+        return ((size + page_size - 1) / page_size) * page_size;
+    }
+}
+#endif
+
+char* RingBufferMemory::allocate(size_t& buffer_size, const RingBufferMemoryOptions& options)
+{
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    void* buffer = MAP_FAILED;
+
+    #ifdef __linux__
+        if (options.hugepage_size) {
+            size_t hugepage_buffer_size = round_up(buffer_size, options.hugepage_size);
+
+            buffer = mmap(NULL, hugepage_buffer_size, PROT_READ | PROT_WRITE, 
+                MAP_PRIVATE | MAP_ANONYMOUS | get_hugepage_flags(options.hugepage_size), -1, 0);
+
+            if (buffer != MAP_FAILED) {
+                buffer_size = hugepage_buffer_size;
+            } else {
+                using namespace date;
+                cout << "[" << std::chrono::system_clock::now() << "]";
+                cout << "[RingBufferMemory::allocate] Cannot allocate " << hugepage_buffer_size << " bytes of hugepages of size ";
+                cout << options.hugepage_size << " (" << strerror(errno) << "). Using transparent hugepages." << endl;
+            }
+        }
+
+        page_size = buffer != MAP_FAILED ? options.hugepage_size : page_size;
+    #endif
+
+    if (buffer == MAP_FAILED) {
+        buffer_size = ((buffer_size + page_size - 1) / page_size) * page_size;
+        buffer = mmap(NULL, buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (buffer == MAP_FAILED) {
+            stringstream error_message;
+            using namespace date;
+            error_message << "[" << std::chrono::system_clock::now() << "]";
+            error_message << "[RingBufferMemory::allocate] Cannot allocate " << buffer_size << " bytes: " << strerror(errno) << endl;
+
+            throw runtime_error(error_message.str());
+        }
+
+        #ifdef __linux__
+            if (options.hugepage_size) {
+                madvise(buffer, buffer_size, MADV_HUGEPAGE);
+            }
+        #endif
+    }
+
+    #ifdef __linux__
+        // Before the first touch - the pages are placed when they are faulted in.
+        int numa_node = options.numa_node == RING_BUFFER_NUMA_NODE_LOCAL ? get_current_numa_node() : options.numa_node;
+
+        if (numa_node >= 0) {
+            const size_t bits_per_word = sizeof(unsigned long) * 8;
+
+            vector<unsigned long> node_mask(numa_node / bits_per_word + 1, 0);
+            node_mask[numa_node / bits_per_word] = 1UL << (numa_node % bits_per_word);
+
+            if (syscall(SYS_mbind, buffer, buffer_size, MEMORY_POLICY_PREFERRED, 
+                    node_mask.data(), node_mask.size() * bits_per_word, 0) != 0) {
+                using namespace date;
+                cout << "[" << std::chrono::system_clock::now() << "]";
+                cout << "[RingBufferMemory::allocate] Cannot bind ring buffer to NUMA node " << numa_node;
+                cout << " (" << strerror(errno) << ")." << endl;
+            }
+        }
+    #endif
+
+    if (options.prefault) {
+        char* buffer_bytes = static_cast<char*>(buffer);
+
+        for (size_t offset=0; offset<buffer_size; offset+=page_size) {
+            buffer_bytes[offset] = 0;
+        }
+    }
+
+    // Locking faults in the pages as well.
+    if (options.lock_memory && mlock(buffer, buffer_size) != 0) {
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[RingBufferMemory::allocate] Cannot lock " << buffer_size << " bytes of ring buffer memory";
+        cout << " (" << strerror(errno) << "). Check RLIMIT_MEMLOCK (ulimit -l)." << endl;
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[RingBufferMemory::allocate] Allocated " << buffer_size << " bytes with page_size " << page_size;
+        cout << " and numa_node " << options.numa_node << " and lock_memory " << options.lock_memory;
+        cout << " and prefault " << options.prefault << endl;
+    #endif
+
+    return static_cast<char*>(buffer);
+}
+
+void RingBufferMemory::release(char* buffer, size_t buffer_size)
+{
+    // Also unlocks the memory.
+    munmap(buffer, buffer_size);
+}
+
+int RingBufferMemory::get_network_interface_numa_node(const string& interface_name)
+{
+    ifstream numa_node_file("/sys/class/net/" + interface_name + "/device/numa_node");
+
+    int numa_node = -1;
+    if (!(numa_node_file >> numa_node)) {
+        return -1;
+    }
+
+    return numa_node;
+}
+
+int RingBufferMemory::get_current_numa_node()
+{
+    #ifdef __linux__
+        unsigned int cpu = 0;
+        unsigned int numa_node = 0;
+
+        if (syscall(SYS_getcpu, &cpu, &numa_node, NULL) == 0) {
+            return numa_node;
+        }
+    #endif
+
+    return -1;
+}
+
+RingBufferMemoryOptions RingBufferMemory::get_config_options()
+{
+    RingBufferMemoryOptions options;
+    options.hugepage_size = config::ring_buffer_hugepage_size;
+    options.lock_memory = config::ring_buffer_lock_memory;
+    options.prefault = config::ring_buffer_prefault;
+    options.numa_node = config::ring_buffer_numa_node;
+    // The frames copied into the slots are written from them with direct I/O - not the zero-copy ZMQ messages.
+    options.slot_alignment = config::h5_direct_io ? config::h5_direct_io_alignment : 0;
+
+    // The node of the NIC receiving the stream has priority.
+    if (!config::ring_buffer_numa_interface.empty()) {
+        int interface_numa_node = get_network_interface_numa_node(config::ring_buffer_numa_interface);
+
+        if (interface_numa_node >= 0) {
+            options.numa_node = interface_numa_node;
+        } else {
+            using namespace date;
+            cout << "[" << std::chrono::system_clock::now() << "]";
+            cout << "[RingBufferMemory::get_config_options] Cannot get the NUMA node of ";
+            cout << config::ring_buffer_numa_interface << ". Using ring_buffer_numa_node " << options.numa_node << "." << endl;
+        }
+    }
+
+    // The received ZMQ messages are passed on - the frames never reach the ring buffer memory.
+    bool memory_options_set = options.hugepage_size || options.lock_memory || options.prefault || 
+        options.numa_node != RING_BUFFER_NUMA_NODE_NONE;
+
+    if (config::zmq_zero_copy_receive && memory_options_set) {
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[RingBufferMemory::get_config_options] The ring buffer memory options have no effect on the frames ";
+        cout << "with zmq_zero_copy_receive." << endl;
+    }
+
+    return options;
+}
@@ -0,0 +1,48 @@
+#ifndef RINGBUFFERMEMORY_H
+#define RINGBUFFERMEMORY_H
+
+#include <string>
+#include <cstddef>
+#include <chrono>
+#include "date.h"
+
+#define RING_BUFFER_HUGEPAGE_2MB (2UL * 1024 * 1024)
+#define RING_BUFFER_HUGEPAGE_1GB (1024UL * 1024 * 1024)
+
+// Do not bind the ring buffer memory to a NUMA node.
+#define RING_BUFFER_NUMA_NODE_NONE -1
+// Bind to the NUMA node of the thread initializing the ring buffer (the receiver thread, on the first write).
+#define RING_BUFFER_NUMA_NODE_LOCAL -2
+
+struct RingBufferMemoryOptions
+{
+    // 0 for normal pages, RING_BUFFER_HUGEPAGE_2MB or RING_BUFFER_HUGEPAGE_1GB.
+    // Falls back to transparent hugepages (and normal pages) if no hugepages are reserved.
+    size_t hugepage_size = 0;
+    // Keep the buffer in RAM (needs a large enough RLIMIT_MEMLOCK).
+    bool lock_memory = false;
+    // Touch all pages at allocation - no page faults during the acquisition.
+    bool prefault = false;
+    // NUMA node for the buffer pages, or RING_BUFFER_NUMA_NODE_NONE/LOCAL.
+    int numa_node = RING_BUFFER_NUMA_NODE_NONE;
+    // Slot size rounded up to a multiple of this, so each slot starts aligned for direct I/O - 0 to not round.
+    size_t slot_alignment = 0;
+};
+
+namespace RingBufferMemory
+{
+    // buffer_size is rounded up to the page size used.
+    char* allocate(size_t& buffer_size, const RingBufferMemoryOptions& options);
+
+    void release(char* buffer, size_t buffer_size);
+
+    // -1 if not known.
+    int get_network_interface_numa_node(const std::string& interface_name);
+
+    int get_current_numa_node();
+
+    // Options from the config values.
+    RingBufferMemoryOptions get_config_options();
+};
+
+#endif
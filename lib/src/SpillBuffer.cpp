@@ -0,0 +1,280 @@
+#include <stdexcept>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "SpillBuffer.hpp"
+#include "RingBuffer.hpp"
+
+using namespace std;
+
+SpillBuffer::SpillBuffer(const string& filename, size_t file_size, size_t n_read_slots) :
+    filename(filename), file_size(file_size), n_read_slots(n_read_slots), n_queued_frames(0), n_used_read_slots(0)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[SpillBuffer::SpillBuffer] Creating spill file " << filename << " with file_size " << file_size;
+        cout << " and n_read_slots " << n_read_slots << endl;
+    #endif
+
+    file_descriptor = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_DIRECT, 0600);
+
+    // tmpfs and some network filesystems do not support O_DIRECT.
+    if (file_descriptor < 0 && errno == EINVAL) {
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[SpillBuffer::SpillBuffer] Cannot open spill file " << filename << " with O_DIRECT.";
+        cout << " Using the page cache." << endl;
+
+        file_descriptor = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    }
+
+    if (file_descriptor < 0) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[SpillBuffer::SpillBuffer] Cannot open spill file " << filename;
+        error_message << " (" << strerror(errno) << ")." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    // Nothing is left behind if the writer crashes - the file is freed when it is closed.
+    unlink(filename.c_str());
+
+    // Allocate the blocks now, not while spilling.
+    int allocate_status = posix_fallocate(file_descriptor, 0, file_size);
+    if (allocate_status != 0) {
+        close(file_descriptor);
+
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[SpillBuffer::SpillBuffer] Cannot preallocate " << file_size << " bytes for spill file ";
+        error_message << filename << " (" << strerror(allocate_status) << ")." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+}
+
+SpillBuffer::~SpillBuffer()
+{
+    if (file_descriptor >= 0) {
+        close(file_descriptor);
+    }
+
+    free(write_buffer);
+
+    for (auto read_slot : read_slots) {
+        free(read_slot);
+    }
+}
+
+void SpillBuffer::initialize_slots(size_t frame_bytes_size)
+{
+    slot_size = ((frame_bytes_size + SPILL_BUFFER_ALIGNMENT - 1) / SPILL_BUFFER_ALIGNMENT) * SPILL_BUFFER_ALIGNMENT;
+    n_slots = file_size / slot_size;
+
+    void* buffer = NULL;
+    if (posix_memalign(&buffer, SPILL_BUFFER_ALIGNMENT, slot_size) != 0) {
+        throw bad_alloc();
+    }
+    write_buffer = static_cast<char*>(buffer);
+
+    {
+        lock_guard<mutex> lock(read_slots_mutex);
+
+        for (size_t read_slot_index=0; read_slot_index<n_read_slots; read_slot_index++) {
+            if (posix_memalign(&buffer, SPILL_BUFFER_ALIGNMENT, slot_size) != 0) {
+                throw bad_alloc();
+            }
+
+            read_slots.push_back(static_cast<char*>(buffer));
+        }
+
+        read_slots_used.assign(n_read_slots, false);
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[SpillBuffer::initialize_slots] Spill file " << filename << " has " << n_slots;
+        cout << " slots of slot_size " << slot_size << endl;
+    #endif
+}
+
+bool SpillBuffer::append(const shared_ptr<FrameMetadata>& frame_metadata, const char* data)
+{
+    lock_guard<mutex> append_lock(append_mutex);
+
+    if (!write_buffer) {
+        initialize_slots(frame_metadata->frame_bytes_size);
+    }
+
+    if (frame_metadata->frame_bytes_size > slot_size) {
+        return false;
+    }
+
+    size_t slot_index;
+    {
+        lock_guard<mutex> lock(queue_mutex);
+
+        if (frame_metadata_queue.size() >= n_slots) {
+            return false;
+        }
+
+        // Only this producer appends - the slot stays free until the frame is queued.
+        slot_index = (first_slot + frame_metadata_queue.size()) % n_slots;
+    }
+
+    // O_DIRECT writes whole aligned slots from aligned memory.
+    memcpy(write_buffer, data, frame_metadata->frame_bytes_size);
+
+    auto n_written_bytes = pwrite(file_descriptor, write_buffer, slot_size, slot_index * slot_size);
+
+    if (n_written_bytes != static_cast<ssize_t>(slot_size)) {
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[SpillBuffer::append] Cannot write frame_index " << frame_metadata->frame_index;
+        cout << " to spill file " << filename << " (" << strerror(errno) << ")." << endl;
+
+        return false;
+    }
+
+    {
+        lock_guard<mutex> lock(queue_mutex);
+
+        frame_metadata_queue.push_back(frame_metadata);
+        max_used_slots = max(max_used_slots, frame_metadata_queue.size());
+        n_spilled_frames++;
+
+        n_queued_frames.store(frame_metadata_queue.size(), memory_order_release);
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[SpillBuffer::append] Spilled frame_index " << frame_metadata->frame_index;
+        cout << " to slot " << slot_index << endl;
+    #endif
+
+    return true;
+}
+
+pair<shared_ptr<FrameMetadata>, char*> SpillBuffer::read(size_t& read_slot_index)
+{
+    if (!has_frames()) {
+        return {NULL, NULL};
+    }
+
+    {
+        lock_guard<mutex> lock(read_slots_mutex);
+
+        auto free_read_slot = find(read_slots_used.begin(), read_slots_used.end(), false);
+        if (free_read_slot == read_slots_used.end()) {
+            return {NULL, NULL};
+        }
+
+        read_slot_index = free_read_slot - read_slots_used.begin();
+        *free_read_slot = true;
+        n_used_read_slots++;
+    }
+
+    shared_ptr<FrameMetadata> frame_metadata;
+    size_t slot_index;
+    {
+        lock_guard<mutex> lock(queue_mutex);
+
+        frame_metadata = frame_metadata_queue.front();
+        slot_index = first_slot;
+    }
+
+    char* read_slot = read_slots[read_slot_index];
+    auto n_read_bytes = pread(file_descriptor, read_slot, slot_size, slot_index * slot_size);
+
+    if (n_read_bytes != static_cast<ssize_t>(slot_size)) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[SpillBuffer::read] Cannot read frame_index " << frame_metadata->frame_index;
+        error_message << " from spill file " << filename << " (" << strerror(errno) << ")." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    // The file slot is free for the producers only now.
+    {
+        lock_guard<mutex> lock(queue_mutex);
+
+        frame_metadata_queue.pop_front();
+        first_slot = (first_slot + 1) % n_slots;
+
+        n_queued_frames.store(frame_metadata_queue.size(), memory_order_release);
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[SpillBuffer::read] Read frame_index " << frame_metadata->frame_index;
+        cout << " from slot " << slot_index << " into read slot " << read_slot_index << endl;
+    #endif
+
+    return {frame_metadata, read_slot};
+}
+
+void SpillBuffer::release(size_t read_slot_index)
+{
+    lock_guard<mutex> lock(read_slots_mutex);
+
+    if (read_slot_index >= read_slots_used.size() || !read_slots_used[read_slot_index]) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[SpillBuffer::release] Cannot release empty read slot " << read_slot_index << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    read_slots_used[read_slot_index] = false;
+    n_used_read_slots--;
+}
+
+bool SpillBuffer::has_frames() const
+{
+    return n_queued_frames.load(memory_order_acquire) > 0;
+}
+
+bool SpillBuffer::can_read()
+{
+    return has_frames() && n_used_read_slots.load() < n_read_slots;
+}
+
+bool SpillBuffer::is_empty() const
+{
+    return !has_frames() && n_used_read_slots.load() == 0;
+}
+
+size_t SpillBuffer::get_n_read_slots() const
+{
+    return n_read_slots;
+}
+
+SpillBufferStatistics SpillBuffer::get_statistics()
+{
+    lock_guard<mutex> lock(queue_mutex);
+
+    SpillBufferStatistics statistics;
+
+    statistics.n_used_slots = frame_metadata_queue.size();
+    statistics.max_used_slots = max_used_slots;
+    statistics.n_slots = n_slots;
+    statistics.n_spilled_frames = n_spilled_frames;
+
+    return statistics;
+}
@@ -0,0 +1,86 @@
+#ifndef SPILLBUFFER_H
+#define SPILLBUFFER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include "date.h"
+
+struct FrameMetadata;
+
+// O_DIRECT needs the buffers, file offsets and sizes aligned to the logical block size of the device.
+#define SPILL_BUFFER_ALIGNMENT 4096
+
+struct SpillBufferStatistics
+{
+    // Frames in the spill file now, at most, and the file capacity.
+    size_t n_used_slots = 0;
+    size_t max_used_slots = 0;
+    size_t n_slots = 0;
+    // Frames written to the spill file in total.
+    uint64_t n_spilled_frames = 0;
+};
+
+/*
+ * Second ring buffer tier in a preallocated file, for stalls of the storage longer than the RAM slots can absorb.
+ * Frames are appended and read back in order with O_DIRECT (page cache if the filesystem does not support it).
+ * The file is divided into slots sized for the first frame appended - larger frames are not spilled.
+ * Frames are read into one of n_read_slots aligned buffers, which are held until released.
+ * Append from the producers, read from one consumer, release from any thread.
+ */
+class SpillBuffer
+{
+    const std::string filename;
+    const size_t file_size;
+    const size_t n_read_slots;
+
+    int file_descriptor = -1;
+
+    // Set on the first append.
+    size_t slot_size = 0;
+    size_t n_slots = 0;
+    char* write_buffer = NULL;
+    std::vector<char*> read_slots;
+    std::vector<bool> read_slots_used;
+
+    // Spilled frames in order - frame i of the queue is in the file slot (first_slot + i) % n_slots.
+    std::deque<std::shared_ptr<FrameMetadata>> frame_metadata_queue;
+    size_t first_slot = 0;
+    size_t max_used_slots = 0;
+    uint64_t n_spilled_frames = 0;
+    // The queue holds the frame data only after it is written to the file.
+    std::atomic<size_t> n_queued_frames;
+    std::mutex queue_mutex;
+
+    // The producers write one frame at a time through write_buffer.
+    std::mutex append_mutex;
+
+    std::mutex read_slots_mutex;
+    std::atomic<size_t> n_used_read_slots;
+
+    void initialize_slots(size_t frame_bytes_size);
+
+    public:
+        SpillBuffer(const std::string& filename, size_t file_size, size_t n_read_slots);
+        virtual ~SpillBuffer();
+
+        // Return false if the file is full or the frame is larger than a file slot.
+        bool append(const std::shared_ptr<FrameMetadata>& frame_metadata, const char* data);
+
+        // The oldest frame and its read slot - NULL if no frame was spilled or all read slots are held.
+        std::pair<std::shared_ptr<FrameMetadata>, char*> read(size_t& read_slot_index);
+        void release(size_t read_slot_index);
+
+        bool has_frames() const;
+        bool can_read();
+        // No frames in the file and no read slots held.
+        bool is_empty() const;
+        size_t get_n_read_slots() const;
+        SpillBufferStatistics get_statistics();
+};
+
+#endif
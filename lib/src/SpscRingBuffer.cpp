@@ -0,0 +1,104 @@
+#include <stdexcept>
+#include <sstream>
+#include <iostream>
+
+#include "SpscRingBuffer.hpp"
+
+using namespace std;
+
+SpscRingBuffer::SpscRingBuffer(size_t n_slots, const RingBufferMemoryOptions& memory_options) : 
+    RingBuffer(n_slots, memory_options), frame_metadata_slots(n_slots), slots_occupied(new atomic<bool>[n_slots]),
+    write_position(0), read_position(0), n_used_slots(0)
+{
+    for (size_t slot_index=0; slot_index<n_slots; slot_index++) {
+        slots_occupied[slot_index].store(false);
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[SpscRingBuffer::SpscRingBuffer] Creating lock-free ring buffer with n_slots " << n_slots << endl;
+    #endif
+}
+
+bool SpscRingBuffer::reserve_slot(const shared_ptr<FrameMetadata>& frame_metadata)
+{
+    // Only the producer modifies the write position.
+    size_t slot_index = write_position.load(memory_order_relaxed) % n_slots;
+
+    // Acquire: the consumer must be done with the slot before we overwrite it.
+    if (slots_occupied[slot_index].load(memory_order_acquire)) {
+        return false;
+    }
+
+    slots_occupied[slot_index].store(true, memory_order_relaxed);
+    update_max_used_slots(n_used_slots.fetch_add(1, memory_order_relaxed) + 1);
+
+    frame_metadata->buffer_slot_index = slot_index;
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[SpscRingBuffer::reserve_slot] Ring buffer slot " << slot_index << " reserved for frame_index ";
+        cout << frame_metadata->frame_index << endl;
+    #endif
+
+    return true;
+}
+
+void SpscRingBuffer::commit_slot(const shared_ptr<FrameMetadata>& frame_metadata)
+{
+    frame_metadata_slots[frame_metadata->buffer_slot_index] = frame_metadata;
+
+    // Release: publish the frame data and metadata to the consumer.
+    write_position.store(write_position.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+shared_ptr<FrameMetadata> SpscRingBuffer::take_committed_slot()
+{
+    // Only the consumer modifies the read position.
+    size_t current_read_position = read_position.load(memory_order_relaxed);
+
+    if (current_read_position == write_position.load(memory_order_acquire)) {
+        return NULL;
+    }
+
+    size_t slot_index = current_read_position % n_slots;
+    auto frame_metadata = move(frame_metadata_slots[slot_index]);
+
+    read_position.store(current_read_position + 1, memory_order_relaxed);
+
+    return frame_metadata;
+}
+
+void SpscRingBuffer::free_slot(size_t buffer_slot_index)
+{
+    if (!slots_occupied[buffer_slot_index].load(memory_order_relaxed)) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[SpscRingBuffer::free_slot] Cannot release empty ring buffer slot " << buffer_slot_index << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    n_used_slots.fetch_sub(1, memory_order_relaxed);
+
+    // Release: hand the slot memory back to the producer.
+    slots_occupied[buffer_slot_index].store(false, memory_order_release);
+}
+
+bool SpscRingBuffer::has_committed_slots()
+{
+    return read_position.load(memory_order_relaxed) != write_position.load(memory_order_acquire);
+}
+
+bool SpscRingBuffer::are_slots_empty()
+{
+    return n_used_slots.load(memory_order_acquire) == 0;
+}
+
+size_t SpscRingBuffer::get_n_used_slots()
+{
+    return n_used_slots.load(memory_order_relaxed);
+}
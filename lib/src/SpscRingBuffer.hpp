@@ -0,0 +1,48 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "RingBuffer.hpp"
+
+// Avoid false sharing between the producer and consumer indices.
+#define SPSC_CACHE_LINE_SIZE 64
+
+/*
+ * Lock-free ring buffer for exactly one producer thread (write) and one consumer (read, release).
+ * Reads must not be concurrent - release can be called from another thread than read.
+ * The metadata queue is a preallocated array indexed by the ring buffer slot - no allocations per frame.
+ */
+class SpscRingBuffer : public RingBuffer
+{
+    // Frame metadata for each slot, published by the producer with write_position.
+    std::vector<std::shared_ptr<FrameMetadata>> frame_metadata_slots;
+    std::unique_ptr<std::atomic<bool>[]> slots_occupied;
+
+    char padding_write_position[SPSC_CACHE_LINE_SIZE];
+    // Number of frames committed so far - modified only by the producer.
+    std::atomic<size_t> write_position;
+
+    char padding_read_position[SPSC_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    // Number of frames read so far - modified only by the consumer.
+    std::atomic<size_t> read_position;
+
+    char padding_used_slots[SPSC_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> n_used_slots;
+
+    protected:
+        bool reserve_slot(const std::shared_ptr<FrameMetadata>& frame_metadata) override;
+        void commit_slot(const std::shared_ptr<FrameMetadata>& frame_metadata) override;
+        std::shared_ptr<FrameMetadata> take_committed_slot() override;
+        void free_slot(size_t buffer_slot_index) override;
+        bool has_committed_slots() override;
+        bool are_slots_empty() override;
+
+    public:
+        SpscRingBuffer(size_t n_slots, const RingBufferMemoryOptions& memory_options=RingBufferMemoryOptions());
+        size_t get_n_used_slots() override;
+};
+
+#endif
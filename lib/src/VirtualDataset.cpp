@@ -0,0 +1,145 @@
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+
+#include "VirtualDataset.hpp"
+#include "H5Format.hpp"
+
+using namespace std;
+
+string VirtualDatasetUtils::get_filename(const string& filename_template, hsize_t file_index)
+{
+    // Space for 10 digits should be enough.
+    char buffer[filename_template.length() + 10];
+
+    sprintf(buffer, filename_template.c_str(), file_index);
+    
+    return string(buffer);
+}
+
+string VirtualDatasetUtils::get_master_filename(const string& filename_template)
+{
+    auto position = filename_template.find("%d");
+
+    if (position == string::npos) {
+        stringstream error_message;
+        using namespace date;
+        error_message << "[" << std::chrono::system_clock::now() << "]";
+        error_message << "[VirtualDatasetUtils::get_master_filename] Filename " << filename_template;
+        error_message << " is not a template (%d missing)." << endl;
+
+        throw runtime_error(error_message.str());
+    }
+
+    auto master_filename = filename_template;
+    master_filename.replace(position, 2, "master");
+
+    return master_filename;
+}
+
+H5::DataSet VirtualDatasetUtils::create_virtual_dataset(H5::Group& target, const VirtualDatasetDefinition& definition, 
+    const vector<VirtualDatasetSource>& sources)
+{
+    H5::AtomType dataset_data_type(H5FormatUtils::get_dataset_data_type(definition.data_type));
+
+    if (definition.endianness == "big") {
+        dataset_data_type.setOrder(H5T_ORDER_BE);
+    } else {
+        dataset_data_type.setOrder(H5T_ORDER_LE);
+    }
+
+    return create_virtual_dataset(target, definition.name, definition.source_name, definition.data_shape, 
+        dataset_data_type, sources);
+}
+
+H5::DataSet VirtualDatasetUtils::create_virtual_dataset(H5::Group& target, const string& name, const string& source_name, 
+    const vector<size_t>& data_shape, const H5::DataType& data_type, const vector<VirtualDatasetSource>& sources)
+{
+    const size_t data_rank = data_shape.size();
+    const hsize_t dataset_rank = data_rank + 1;
+
+    // The dataset ends with the last frame of any source.
+    hsize_t n_frames = 0;
+    for (const auto& source : sources) {
+        if (source.n_frames) {
+            n_frames = max(n_frames, source.first_frame_index + ((source.n_frames - 1) * source.frame_stride) + 1);
+        }
+    }
+
+    hsize_t dataset_dimension[dataset_rank];
+    dataset_dimension[0] = n_frames;
+    for (size_t index=0; index<data_rank; ++index) {
+        dataset_dimension[index+1] = data_shape[index];
+    }
+
+    H5::DataSpace virtual_space(dataset_rank, dataset_dimension);
+    H5::DSetCreatPropList dataset_properties;
+
+    for (const auto& source : sources) {
+        if (!source.n_frames) {
+            continue;
+        }
+
+        hsize_t start[dataset_rank];
+        hsize_t stride[dataset_rank];
+        hsize_t count[dataset_rank];
+        hsize_t block[dataset_rank];
+
+        start[0] = source.first_frame_index;
+        stride[0] = source.frame_stride;
+        count[0] = source.n_frames;
+        block[0] = 1;
+
+        for (size_t index=0; index<data_rank; ++index) {
+            start[index+1] = 0;
+            stride[index+1] = 1;
+            count[index+1] = 1;
+            block[index+1] = data_shape[index];
+        }
+
+        virtual_space.selectHyperslab(H5S_SELECT_SET, count, start, stride, block);
+
+        hsize_t source_dimension[dataset_rank];
+        source_dimension[0] = source.n_frames;
+        for (size_t index=0; index<data_rank; ++index) {
+            source_dimension[index+1] = data_shape[index];
+        }
+
+        H5::DataSpace source_space(dataset_rank, source_dimension);
+
+        // The source files are next to the master file.
+        auto source_filename = source.filename.substr(source.filename.find_last_of('/') + 1);
+
+        auto source_dataset_name = source.dataset_name.empty() ? source_name : source.dataset_name;
+
+        if (H5Pset_virtual(dataset_properties.getId(), virtual_space.getId(), source_filename.c_str(), 
+            source_dataset_name.c_str(), source_space.getId()) < 0) {
+            
+            stringstream error_message;
+            using namespace date;
+            error_message << "[" << std::chrono::system_clock::now() << "]";
+            error_message << "[VirtualDatasetUtils::create_virtual_dataset] Cannot map " << source.filename;
+            error_message << ":" << source_dataset_name << " to dataset " << name << "." << endl;
+
+            throw runtime_error(error_message.str());
+        }
+    }
+
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[VirtualDatasetUtils::create_virtual_dataset] Creating virtual dataset " << name;
+        cout << " with " << n_frames << " frames from " << sources.size() << " files." << endl;
+    #endif
+
+    virtual_space.selectAll();
+
+    // The name can be a path into the file format.
+    H5::LinkCreatPropList link_properties;
+    link_properties.setCreateIntermediateGroup(true);
+
+    return target.createDataSet(name.c_str(), data_type, virtual_space, dataset_properties, 
+        H5::DSetAccPropList::DEFAULT, link_properties);
+}
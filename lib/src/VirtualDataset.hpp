@@ -0,0 +1,47 @@
+#ifndef VIRTUALDATASET_H
+#define VIRTUALDATASET_H
+
+#include <string>
+#include <vector>
+#include <H5Cpp.h>
+#include <chrono>
+#include "date.h"
+
+// Dataset presented in the master file, made of the frames in the source files.
+struct VirtualDatasetDefinition
+{
+    // Name in the master file.
+    std::string name;
+    // Name of the dataset in the source files.
+    std::string source_name;
+    // Shape of one frame.
+    std::vector<size_t> data_shape;
+    std::string data_type;
+    std::string endianness;
+};
+
+// The first n_frames of a source file go to first_frame_index, first_frame_index + frame_stride, ...
+struct VirtualDatasetSource
+{
+    std::string filename;
+    hsize_t n_frames;
+    hsize_t first_frame_index;
+    hsize_t frame_stride;
+    // Name of the dataset in this file, if different from the definition source_name.
+    std::string dataset_name;
+};
+
+namespace VirtualDatasetUtils
+{
+    std::string get_filename(const std::string& filename_template, hsize_t file_index);
+
+    std::string get_master_filename(const std::string& filename_template);
+
+    H5::DataSet create_virtual_dataset(H5::Group& target, const VirtualDatasetDefinition& definition, 
+        const std::vector<VirtualDatasetSource>& sources);
+
+    H5::DataSet create_virtual_dataset(H5::Group& target, const std::string& name, const std::string& source_name, 
+        const std::vector<size_t>& data_shape, const H5::DataType& data_type, const std::vector<VirtualDatasetSource>& sources);
+};
+
+#endif
@@ -1,10 +1,22 @@
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <iterator>
 
 #include "WriterManager.hpp"
+#include "RingBuffer.hpp"
 
 using namespace std;
 
+namespace {
+    // Steady clock time in ns - never 0 on a running system.
+    uint64_t get_steady_time()
+    {
+        auto time_since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time_since_epoch).count();
+    }
+}
+
 void writer_utils::set_process_id(int user_id)
 {
 
@@ -51,7 +63,8 @@ void writer_utils::create_destination_folder(const string& output_file)
 WriterManager::WriterManager(const unordered_map<string, DATA_TYPE>& parameters_type, 
     const string& output_file, uint64_t n_frames):
         parameters_type(parameters_type), output_file(output_file), n_frames(n_frames), 
-        running_flag(true), killed_flag(false), n_received_frames(0), n_written_frames(0), n_lost_frames(0)
+        running_flag(true), killed_flag(false), n_received_frames(0), n_written_frames(0), n_dropped_frames(0), 
+        n_lost_frames(0), n_written_bytes(0), file_index(0), first_received_time(0), last_written_time(0)
 {
     #ifdef DEBUG_OUTPUT
         using namespace date;
@@ -90,7 +103,7 @@ string WriterManager::get_status()
 {
     if (running_flag) {
         return "receiving";
-    } else if (n_received_frames.load() > n_written_frames) {
+    } else if (n_received_frames.load() - n_dropped_frames.load() > n_written_frames) {
         return "writing";
     } else if (!are_all_parameters_set()) {
         return "waiting for parameters";
@@ -108,9 +121,54 @@ unordered_map<string, uint64_t> WriterManager::get_statistics() const
 {
     unordered_map<string, uint64_t> result = {{"n_received_frames", n_received_frames.load()},
                                     {"n_written_frames", n_written_frames.load()},
+                                    {"n_dropped_frames", n_dropped_frames.load()},
                                     {"n_lost_frames", n_lost_frames.load()},
                                     {"total_expected_frames", n_frames}};
 
+    // Occupancy of the RAM slots and the spill buffer, and what the overflow policy did - over all striped writers.
+    uint64_t used_slots = 0;
+    uint64_t n_slots = 0;
+    uint64_t max_used_slots = 0;
+    SpillBufferStatistics spill_statistics;
+    RingBufferOverflowStatistics overflow_statistics;
+    {
+        lock_guard<mutex> lock(metrics_mutex);
+
+        for (auto ring_buffer : ring_buffers) {
+            used_slots += ring_buffer->get_n_used_slots();
+            n_slots += ring_buffer->get_n_slots();
+            max_used_slots += ring_buffer->get_max_used_slots();
+
+            auto ring_buffer_spill_statistics = ring_buffer->get_spill_statistics();
+
+            spill_statistics.n_used_slots += ring_buffer_spill_statistics.n_used_slots;
+            spill_statistics.max_used_slots += ring_buffer_spill_statistics.max_used_slots;
+            spill_statistics.n_slots += ring_buffer_spill_statistics.n_slots;
+            spill_statistics.n_spilled_frames += ring_buffer_spill_statistics.n_spilled_frames;
+
+            auto ring_buffer_statistics = ring_buffer->get_overflow_statistics();
+
+            overflow_statistics.n_blocked_writes += ring_buffer_statistics.n_blocked_writes;
+            overflow_statistics.blocked_time += ring_buffer_statistics.blocked_time;
+            overflow_statistics.n_dropped_newest_frames += ring_buffer_statistics.n_dropped_newest_frames;
+            overflow_statistics.n_dropped_oldest_frames += ring_buffer_statistics.n_dropped_oldest_frames;
+        }
+    }
+
+    result["ring_buffer_used_slots"] = used_slots;
+    result["ring_buffer_slots"] = n_slots;
+    result["ring_buffer_max_used_slots"] = max_used_slots;
+
+    result["spill_used_slots"] = spill_statistics.n_used_slots;
+    result["spill_slots"] = spill_statistics.n_slots;
+    result["spill_max_used_slots"] = spill_statistics.max_used_slots;
+    result["n_spilled_frames"] = spill_statistics.n_spilled_frames;
+
+    result["n_overflow_blocked_writes"] = overflow_statistics.n_blocked_writes;
+    result["overflow_blocked_time_ms"] = overflow_statistics.blocked_time / 1000000;
+    result["n_overflow_dropped_newest_frames"] = overflow_statistics.n_dropped_newest_frames;
+    result["n_overflow_dropped_oldest_frames"] = overflow_statistics.n_dropped_oldest_frames;
+
     return result;
 }
 
@@ -170,17 +228,180 @@ bool WriterManager::is_killed() const
 
 void WriterManager::received_frame(size_t frame_index)
 {
+    {
+        lock_guard<mutex> lock(missing_frames_mutex);
+
+        // Frames in between did not arrive (yet).
+        if (frame_index > next_frame_index) {
+            add_missing_frames(next_frame_index, frame_index - 1);
+        }
+
+        if (dropped_frames.erase(frame_index)) {
+            add_missing_frames(frame_index, frame_index);
+        } else {
+            // Arrived late, or was already declared lost by the writer.
+            remove_missing_frame(frame_index);
+        }
+
+        next_frame_index = max(next_frame_index, static_cast<uint64_t>(frame_index) + 1);
+    }
+
+    if (!first_received_time.load(memory_order_relaxed)) {
+        uint64_t no_time = 0;
+        first_received_time.compare_exchange_strong(no_time, get_steady_time());
+    }
+
     n_received_frames++;
 }
 
-void WriterManager::written_frame(size_t frame_index)
+void WriterManager::written_frame(size_t frame_index, size_t frame_bytes_size)
 {
+    n_written_bytes += frame_bytes_size;
+    last_written_time = get_steady_time();
+
     n_written_frames++;
 }
 
-void WriterManager::lost_frame(size_t frame_index)
+void WriterManager::set_file_index(uint64_t file_index)
+{
+    this->file_index = file_index;
+}
+
+void WriterManager::set_ring_buffers(const vector<RingBuffer*>& ring_buffers)
+{
+    lock_guard<mutex> lock(metrics_mutex);
+
+    this->ring_buffers = ring_buffers;
+}
+
+unordered_map<string, double> WriterManager::get_metrics()
+{
+    unordered_map<string, double> result;
+
+    for (const auto& statistic : get_statistics()) {
+        result[statistic.first] = statistic.second;
+    }
+
+    uint64_t written_frames = n_written_frames.load();
+    uint64_t written_bytes = n_written_bytes.load();
+
+    result["n_written_bytes"] = written_bytes;
+    result["file_index"] = file_index.load();
+
+    // The current throughput is left to the scraper (rate of the counters) - no state shared between the scrapes.
+    // Average throughput from the first received to the last written frame.
+    double average_frame_rate = 0;
+    double average_byte_rate = 0;
+
+    uint64_t first_time = first_received_time.load();
+    uint64_t last_time = last_written_time.load();
+
+    if (first_time && last_time > first_time) {
+        double total_seconds = (last_time - first_time) / 1e9;
+
+        average_frame_rate = written_frames / total_seconds;
+        average_byte_rate = written_bytes / total_seconds;
+    }
+
+    result["average_frame_rate"] = average_frame_rate;
+    result["average_byte_rate"] = average_byte_rate;
+
+    return result;
+}
+
+void WriterManager::lost_frames(size_t first_frame_index, size_t last_frame_index)
+{
+    lock_guard<mutex> lock(missing_frames_mutex);
+
+    // Frames before next_frame_index are already accounted for - the ones after it were not received by any receiver.
+    if (last_frame_index >= next_frame_index) {
+        add_missing_frames(max(static_cast<uint64_t>(first_frame_index), next_frame_index), last_frame_index);
+    }
+}
+
+void WriterManager::dropped_frame(size_t frame_index)
+{
+    n_dropped_frames++;
+
+    lock_guard<mutex> lock(missing_frames_mutex);
+
+    // The frame can be dropped before its receiver called received_frame. Then it is either past next_frame_index, 
+    // or another receiver already added it as missing.
+    if (frame_index >= next_frame_index || is_missing_frame(frame_index)) {
+        dropped_frames.insert(frame_index);
+    } else {
+        add_missing_frames(frame_index, frame_index);
+    }
+}
+
+void WriterManager::add_missing_frames(uint64_t first_frame_index, uint64_t last_frame_index)
+{
+    #ifdef DEBUG_OUTPUT
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[WriterManager::add_missing_frames] Frames " << first_frame_index << " to " << last_frame_index << " missing." << endl;
+    #endif
+
+    // Merge with the overlapping and adjacent ranges.
+    auto range = missing_frames.upper_bound(first_frame_index);
+    if (range != missing_frames.begin() && prev(range)->second + 1 >= first_frame_index) {
+        range = prev(range);
+    }
+
+    while (range != missing_frames.end() && range->first <= last_frame_index + 1) {
+        n_lost_frames -= range->second - range->first + 1;
+
+        first_frame_index = min(first_frame_index, range->first);
+        last_frame_index = max(last_frame_index, range->second);
+
+        range = missing_frames.erase(range);
+    }
+
+    missing_frames[first_frame_index] = last_frame_index;
+    n_lost_frames += last_frame_index - first_frame_index + 1;
+}
+
+void WriterManager::remove_missing_frame(uint64_t frame_index)
 {
-    n_lost_frames++;
+    auto range = missing_frames.upper_bound(frame_index);
+    if (range == missing_frames.begin()) {
+        return;
+    }
+
+    range = prev(range);
+    if (range->second < frame_index) {
+        return;
+    }
+
+    auto first_frame_index = range->first;
+    auto last_frame_index = range->second;
+    missing_frames.erase(range);
+    n_lost_frames--;
+
+    if (first_frame_index < frame_index) {
+        missing_frames[first_frame_index] = frame_index - 1;
+    }
+
+    if (frame_index < last_frame_index) {
+        missing_frames[frame_index + 1] = last_frame_index;
+    }
+}
+
+bool WriterManager::is_missing_frame(uint64_t frame_index) const
+{
+    auto range = missing_frames.upper_bound(frame_index);
+    if (range == missing_frames.begin()) {
+        return false;
+    }
+
+    return prev(range)->second >= frame_index;
+}
+
+vector<pair<uint64_t, uint64_t>> WriterManager::get_missing_frames() const
+{
+    lock_guard<mutex> lock(missing_frames_mutex);
+
+    return vector<pair<uint64_t, uint64_t>>(missing_frames.begin(), missing_frames.end());
 }
 
 bool WriterManager::are_all_parameters_set()
@@ -2,6 +2,9 @@
 #define WRITERMANAGER_H
 
 #include <unordered_map>
+#include <map>
+#include <set>
+#include <vector>
 #include <string>
 #include <atomic>
 #include <mutex>
@@ -11,6 +14,8 @@
 
 #include "H5Format.hpp"
 
+class RingBuffer;
+
 namespace writer_utils {
     void set_process_id(int user_id);
     void create_destination_folder(const std::string& output_file);
@@ -31,8 +36,33 @@ class WriterManager
     std::atomic_bool killed_flag;
     std::atomic<uint64_t> n_received_frames;
     std::atomic<uint64_t> n_written_frames;
+    // Received, but dropped before they were written - they never count in n_written_frames.
+    std::atomic<uint64_t> n_dropped_frames;
     std::atomic<uint64_t> n_lost_frames;
 
+    // Ranges (first, last) of frame indices that did not arrive - frames arriving late are removed.
+    std::map<uint64_t, uint64_t> missing_frames;
+    uint64_t next_frame_index = 0;
+    // Frames dropped before received_frame was called for them - they must not count as late.
+    // With multiple receivers next_frame_index can already be past them.
+    std::set<uint64_t> dropped_frames;
+    mutable std::mutex missing_frames_mutex;
+
+    std::atomic<uint64_t> n_written_bytes;
+    std::atomic<uint64_t> file_index;
+
+    // Steady clock time in ns of the first received and the last written frame - 0 if none yet.
+    std::atomic<uint64_t> first_received_time;
+    std::atomic<uint64_t> last_written_time;
+
+    // Ring buffers for the occupancy - not owned.
+    std::vector<RingBuffer*> ring_buffers;
+    mutable std::mutex metrics_mutex;
+
+    void add_missing_frames(uint64_t first_frame_index, uint64_t last_frame_index);
+    void remove_missing_frame(uint64_t frame_index);
+    bool is_missing_frame(uint64_t frame_index) const;
+
     public:
         WriterManager(const std::unordered_map<std::string, DATA_TYPE>& parameters_type, const std::string& output_file, uint64_t n_frames=0);
         virtual ~WriterManager();
@@ -50,9 +80,15 @@ class WriterManager
         void set_parameters(const std::unordered_map<std::string, boost::any>& new_parameters);
         
         std::unordered_map<std::string, uint64_t> get_statistics() const;
+        std::unordered_map<std::string, double> get_metrics();
         void received_frame(size_t frame_index);
-        void written_frame(size_t frame_index);
-        void lost_frame(size_t frame_index);
+        void written_frame(size_t frame_index, size_t frame_bytes_size=0);
+        // Frames first_frame_index to last_frame_index declared lost by the writer.
+        void lost_frames(size_t first_frame_index, size_t last_frame_index);
+        void dropped_frame(size_t frame_index);
+        std::vector<std::pair<uint64_t, uint64_t>> get_missing_frames() const;
+        void set_file_index(uint64_t file_index);
+        void set_ring_buffers(const std::vector<RingBuffer*>& ring_buffers);
 
         size_t get_n_frames();
 };
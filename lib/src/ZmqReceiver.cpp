@@ -1,5 +1,6 @@
 #include <iostream>
 #include <stdexcept>
+#include <sstream>
 
 #include "config.hpp"
 #include "ZmqReceiver.hpp"
@@ -8,53 +9,38 @@
 using namespace std;
 namespace pt = boost::property_tree;
 
-HeaderDataType::HeaderDataType(const std::string& type, size_t shape) : 
-    type(type), value_shape(shape), endianness("little"), is_array(true) {
-        value_bytes_size = get_type_byte_size(type);
-}
-
-HeaderDataType::HeaderDataType(const std::string& type) : 
-    type(type), value_shape(1), endianness("little"), is_array(false) {
-        value_bytes_size = get_type_byte_size(type);
-}
+ZmqReceiver::ZmqReceiver(const std::string& connect_address, const int n_io_threads, const int receive_timeout,
+    shared_ptr<unordered_map<string, HeaderDataType>> header_values_type) :
+        connect_address(connect_address), n_io_threads(n_io_threads), 
+        receive_timeout(receive_timeout), receiver(NULL), header_values_type(header_values_type), 
+        header_decode_plan(make_shared<HeaderDecodePlan>(header_values_type)), header_parser(header_decode_plan)
 
-size_t get_type_byte_size(const string& type)
 {
-    if (type == "uint8" || type== "int8") {
-        return 1;
-
-    } else if (type == "uint16" || type == "int16") {
-        return 2;
-
-    } else if (type == "uint32" || type == "int32" || type == "float32") {
-        return 4;
-
-    } else if (type == "uint64" || type == "int64" || type == "float64") {
-        return 8;
-
-    } else {
-        stringstream error_message;
+    #ifdef DEBUG_OUTPUT
         using namespace date;
-        error_message << "[" << std::chrono::system_clock::now() << "]";
-        error_message << "[ZmqReceiver::get_type_byte_size] Unsupported data type " << type << endl;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[ZmqReceiver::ZmqReceiver] Creating ZMQ receiver with";
+        cout << " connect_address " << connect_address;
+        cout << " n_io_threads " << n_io_threads;
+        cout << " receive_timeout " << receive_timeout;
+        cout << endl;
+    #endif
 
-        throw runtime_error(error_message.str());
-    }
+    message_header = zmq::message_t(config::zmq_buffer_size_header);
+    message_data = zmq::message_t(config::zmq_buffer_size_data);
 }
 
 ZmqReceiver::ZmqReceiver(const std::string& connect_address, const int n_io_threads, const int receive_timeout,
-    shared_ptr<unordered_map<string, HeaderDataType>> header_values_type) :
+    shared_ptr<unordered_map<string, HeaderDataType>> header_values_type, shared_ptr<const HeaderDecodePlan> header_decode_plan) :
         connect_address(connect_address), n_io_threads(n_io_threads), 
-        receive_timeout(receive_timeout), receiver(NULL), header_values_type(header_values_type)
-
+        receive_timeout(receive_timeout), receiver(NULL), header_values_type(header_values_type), 
+        header_decode_plan(header_decode_plan), header_parser(header_decode_plan)
 {
     #ifdef DEBUG_OUTPUT
         using namespace date;
         cout << "[" << std::chrono::system_clock::now() << "]";
-        cout << "[ZmqReceiver::ZmqReceiver] Creating ZMQ receiver with";
+        cout << "[ZmqReceiver::ZmqReceiver] Creating ZMQ receiver with shared header decode plan and";
         cout << " connect_address " << connect_address;
-        cout << " n_io_threads " << n_io_threads;
-        cout << " receive_timeout " << receive_timeout;
         cout << endl;
     #endif
 
@@ -75,16 +61,26 @@ void ZmqReceiver::connect()
     receiver = make_shared<zmq::socket_t>(*context, ZMQ_PULL);
 
     receiver->setsockopt(ZMQ_RCVTIMEO, receive_timeout);
-    receiver->connect(connect_address);
+    receiver->setsockopt(ZMQ_RCVHWM, config::zmq_receive_hwm);
+
+    // Messages from multiple addresses are fair queued.
+    stringstream addresses(connect_address);
+    string address;
+
+    while (getline(addresses, address, ',')) {
+        if (!address.empty()) {
+            receiver->connect(address);
+        }
+    }
 }
 
-pair<shared_ptr<FrameMetadata>, char*> ZmqReceiver::receive()
+shared_ptr<FrameMetadata> ZmqReceiver::receive_header()
 {
     if (!receiver) {
         stringstream error_message;
         using namespace date;
         error_message << "[" << std::chrono::system_clock::now() << "]";
-        error_message << "[ZmqReceiver::receive] Cannot receive before connecting. ";
+        error_message << "[ZmqReceiver::receive_header] Cannot receive before connecting. ";
         error_message << "Connect first." << endl;
 
         throw runtime_error(error_message.str());
@@ -92,11 +88,21 @@ pair<shared_ptr<FrameMetadata>, char*> ZmqReceiver::receive()
 
     // Get the message header.
     if (!receiver->recv(&message_header)){
-        return {NULL, NULL};
+        return NULL;
     }
 
-    auto header_string = string(static_cast<char*>(message_header.data()), message_header.size());
-    auto frame_metadata = read_json_header(header_string);
+    header_receive_time = std::chrono::steady_clock::now();
+
+    return parse_json_header(static_cast<const char*>(message_header.data()), message_header.size());
+}
+
+pair<shared_ptr<FrameMetadata>, char*> ZmqReceiver::receive()
+{
+    auto frame_metadata = receive_header();
+
+    if (!frame_metadata) {
+        return {NULL, NULL};
+    }
 
     // Get the message data.
     if (!receiver->recv(&message_data)) {
@@ -110,9 +116,44 @@ pair<shared_ptr<FrameMetadata>, char*> ZmqReceiver::receive()
 
     frame_metadata->frame_bytes_size = message_data.size();
 
+    LatencyMetrics::record(LATENCY_RECEIVE, std::chrono::steady_clock::now() - header_receive_time);
+
     return {frame_metadata, static_cast<char*>(message_data.data())};
 }
 
+pair<shared_ptr<FrameMetadata>, shared_ptr<char>> ZmqReceiver::receive_zero_copy()
+{
+    auto frame_metadata = receive_header();
+
+    if (!frame_metadata) {
+        return {NULL, NULL};
+    }
+
+    // Each frame gets its own message - ZMQ receives large messages directly into the message memory.
+    unique_ptr<zmq::message_t> frame_message(new zmq::message_t());
+
+    // Get the message data.
+    if (!receiver->recv(frame_message.get())) {
+        using namespace date;
+        cout << "[" << std::chrono::system_clock::now() << "]";
+        cout << "[ZmqReceiver::receive_zero_copy] Error while reading from ZMQ. Frame index " << frame_metadata->frame_index << " lost."; 
+        cout << " Trying to continue with the next frame." << endl;
+
+        return {NULL, NULL};
+    }
+
+    frame_metadata->frame_bytes_size = frame_message->size();
+
+    LatencyMetrics::record(LATENCY_RECEIVE, std::chrono::steady_clock::now() - header_receive_time);
+
+    // The returned pointer owns the message - it is freed when the last reference to the frame data is dropped.
+    auto message_pointer = frame_message.release();
+    shared_ptr<char> frame_data(static_cast<char*>(message_pointer->data()), 
+        [message_pointer](char*){ delete message_pointer; });
+
+    return {frame_metadata, frame_data};
+}
+
 shared_ptr<FrameMetadata> ZmqReceiver::read_json_header(const string& header)
 {   
     try {
@@ -134,115 +175,96 @@ shared_ptr<FrameMetadata> ZmqReceiver::read_json_header(const string& header)
 
         header_data->type = json_header.get<string>("type");
 
-        if (header_values_type) {
-            for (const auto& value_mapping : *header_values_type) {
-                
-                const auto& name = value_mapping.first;
-                const auto& header_data_type = value_mapping.second;
-
-                auto value = get_value_from_json(json_header, name, header_data_type);
+        header_data->header_values.resize(header_decode_plan->get_record_bytes_size());
 
-                header_data->header_values.insert(
-                    {name, value}
-                );
-            }
+        for (const auto& field : header_decode_plan->get_fields()) {
+            get_value_from_json(json_header, field, header_data->header_values.data());
         }
         
         return header_data;
 
     } catch (...) {
-        using namespace date;
-        cout << "[" << std::chrono::system_clock::now() << "]";
-        cout << "[ZmqReceiver::read_json_header] Error while interpreting the JSON header. Header string: " << header << endl; 
-        cout << "Expected JSON header format: " << endl; 
-
-        if (header_values_type) {
-            for (const auto& value_mapping : *header_values_type) {
-                cout << "\t" << value_mapping.first << ":" << value_mapping.second.type;
-                cout << "[" << value_mapping.second.value_shape << "]" << endl;
-            }
-        } else {
-            cout << "\tExpected header value types is a null pointer." << endl; 
-        }
+        print_header_error(header);
         throw;
     }
 }
 
-void copy_value_to_buffer(char* buffer, const size_t offset, const pt::ptree& json_value, const HeaderDataType& header_data_type)
+shared_ptr<FrameMetadata> ZmqReceiver::parse_json_header(const char* header, size_t header_size)
 {
-    if (header_data_type.type == "uint8") {
-        auto value = json_value.get_value<uint8_t>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
+    LatencyTimer latency_timer(LATENCY_JSON_PARSE);
 
-    } else if (header_data_type.type == "uint16") {
-        auto value = json_value.get_value<uint16_t>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
+    try {
 
-    } else if (header_data_type.type == "uint32") {
-        auto value = json_value.get_value<uint32_t>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
+        auto header_data = make_shared<FrameMetadata>();
+        header_data->header_values.resize(header_decode_plan->get_record_bytes_size());
 
-    } else if (header_data_type.type == "uint64") {
-        auto value = json_value.get_value<uint64_t>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
+        header_parser.parse(header, header_size, header_data->header_values.data());
 
-    } else if (header_data_type.type == "int8") {
-        auto value = json_value.get_value<int8_t>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
-        
-    } else if (header_data_type.type == "int16") {
-        auto value = json_value.get_value<int16_t>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
-
-    } else if (header_data_type.type == "int32") {
-        auto value = json_value.get_value<int32_t>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
-    
-    } else if (header_data_type.type == "int64") {
-        auto value = json_value.get_value<int64_t>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
-    
-    } else if (header_data_type.type == "float32") {
-        auto value = json_value.get_value<float>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
-
-    } else if (header_data_type.type == "float64") {
-        auto value = json_value.get_value<double>();
-        memcpy(buffer + offset, reinterpret_cast<char*>(&value), header_data_type.value_bytes_size);
+        header_data->frame_index = header_parser.get_frame_index();
+        header_data->frame_shape = header_parser.get_frame_shape();
+        header_data->endianness = header_parser.get_endianness();
+        header_data->type = header_parser.get_type();
 
-    } else {
-        // We cannot really convert this attribute.
-        stringstream error_message;
-        using namespace date;
-        error_message << "[" << std::chrono::system_clock::now() << "]";
-        error_message << "[ZmqReceiver::get_value_from_json] Unsupported header data type " << header_data_type.type << endl;
+        return header_data;
 
-        throw runtime_error(error_message.str());
+    } catch (...) {
+        print_header_error(string(header, header_size));
+        throw;
     }
 }
 
-shared_ptr<char> get_value_from_json(const pt::ptree& json_header, const string& name, const HeaderDataType& header_data_type)
+void ZmqReceiver::print_header_error(const string& header) const
 {
-    char* buffer = new char[header_data_type.value_bytes_size * header_data_type.value_shape];
+    using namespace date;
+    cout << "[" << std::chrono::system_clock::now() << "]";
+    cout << "[ZmqReceiver::print_header_error] Error while interpreting the JSON header. Header string: " << header << endl; 
+    cout << "Expected JSON header format: " << endl; 
+
+    if (header_values_type) {
+        for (const auto& value_mapping : *header_values_type) {
+            cout << "\t" << value_mapping.first << ":" << value_mapping.second.type;
+            cout << "[" << value_mapping.second.value_shape << "]" << endl;
+        }
+    } else {
+        cout << "\tExpected header value types is a null pointer." << endl; 
+    }
+}
 
-    if (header_data_type.is_array) {
+void get_value_from_json(const pt::ptree& json_header, const HeaderValueField& field, char* header_values_record)
+{
+    char* buffer = header_values_record + field.offset;
+
+    if (field.is_array) {
         size_t index = 0;
 
-        for (const auto& item : json_header.get_child(name)) {
-            auto offset = index * header_data_type.value_bytes_size;
-            copy_value_to_buffer(buffer, offset, item.second, header_data_type);
+        for (const auto& item : json_header.get_child(field.name)) {
+            field.convert_ptree(buffer + (index * field.value_bytes_size), item.second);
 
             ++index;
         }
 
     } else {
-        copy_value_to_buffer(buffer, 0, json_header.get_child(name), header_data_type);
+        field.convert_ptree(buffer, json_header.get_child(field.name));
     }
-
-    return shared_ptr<char>(buffer, default_delete<char[]>());
 }
 
 const shared_ptr<unordered_map<string, HeaderDataType>> ZmqReceiver::get_header_values_type() const
 {
     return header_values_type;
 }
+
+const shared_ptr<const HeaderDecodePlan> ZmqReceiver::get_header_decode_plan() const
+{
+    return header_decode_plan;
+}
+
+const string& ZmqReceiver::get_connect_address() const
+{
+    return connect_address;
+}
+
+unique_ptr<ZmqReceiver> ZmqReceiver::get_receiver(const string& connect_address) const
+{
+    return unique_ptr<ZmqReceiver>(new ZmqReceiver(connect_address, n_io_threads, receive_timeout, 
+        header_values_type, header_decode_plan));
+}
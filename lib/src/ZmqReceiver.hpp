@@ -13,26 +13,11 @@
 #include "date.h"
 
 #include "RingBuffer.hpp"
+#include "HeaderDecodePlan.hpp"
+#include "JsonHeaderParser.hpp"
 
-struct HeaderDataType
-{
-    std::string type;
-    size_t value_shape;
-    std::string endianness;
-    size_t value_bytes_size;
-    bool is_array;
-
-    HeaderDataType(const std::string& type);
-    HeaderDataType(const std::string& type, size_t shape);
-};
-
-size_t get_type_byte_size(const std::string& type);
-
-void copy_value_to_buffer(const char* buffer, size_t offset, const boost::property_tree::ptree& json_value, 
-    const HeaderDataType& header_data_type);
-
-std::shared_ptr<char> get_value_from_json(const boost::property_tree::ptree& json_header, 
-    const std::string& name, const HeaderDataType& header_data_type);
+void get_value_from_json(const boost::property_tree::ptree& json_header, const HeaderValueField& field, 
+    char* header_values_record);
 
 class ZmqReceiver
 {
@@ -44,23 +29,47 @@ class ZmqReceiver
     zmq::message_t message_header;
     zmq::message_t message_data;
     boost::property_tree::ptree json_header;
+    // The data part latency is measured from here.
+    std::chrono::steady_clock::time_point header_receive_time;
 
     std::shared_ptr<std::unordered_map<std::string, HeaderDataType>> header_values_type = NULL;
+    std::shared_ptr<const HeaderDecodePlan> header_decode_plan;
+    JsonHeaderParser header_parser;
+
+    std::shared_ptr<FrameMetadata> receive_header();
+    void print_header_error(const std::string& header) const;
 
     public:
         ZmqReceiver(const std::string& connect_address, const int n_io_threads, const int receive_timeout,
             std::shared_ptr<std::unordered_map<std::string, HeaderDataType>> header_values_type=NULL);
 
+        // Receivers running in parallel share the decode plan of the first one.
+        ZmqReceiver(const std::string& connect_address, const int n_io_threads, const int receive_timeout,
+            std::shared_ptr<std::unordered_map<std::string, HeaderDataType>> header_values_type,
+            std::shared_ptr<const HeaderDecodePlan> header_decode_plan);
+
         virtual ~ZmqReceiver(){};
 
+        // The connect address can be a comma separated list of addresses - the socket connects to all of them.
         void connect();
 
         std::shared_ptr<FrameMetadata> read_json_header(const std::string& header);
 
+        std::shared_ptr<FrameMetadata> parse_json_header(const char* header, size_t header_size);
+
         std::pair<std::shared_ptr<FrameMetadata>, char*> receive();
 
+        std::pair<std::shared_ptr<FrameMetadata>, std::shared_ptr<char>> receive_zero_copy();
+
         const std::shared_ptr<std::unordered_map<std::string, HeaderDataType>> get_header_values_type() const;
 
+        const std::shared_ptr<const HeaderDecodePlan> get_header_decode_plan() const;
+
+        const std::string& get_connect_address() const;
+
+        // Receiver with the same settings for another address.
+        std::unique_ptr<ZmqReceiver> get_receiver(const std::string& connect_address) const;
+
 };
 
 #endif
\ No newline at end of file
@@ -9,19 +9,104 @@ namespace config {
     int zmq_buffer_size_header = 1024 * 1024 * 1;
     // Data message buffer size - 10MB.
     int zmq_buffer_size_data = 1024 * 1024 * 10;
+    // Pass the received ZMQ message to the ring buffer instead of copying it into a ring buffer slot. The frames then 
+    // never use the slot memory, so the ring_buffer_* memory options and the h5_direct_io slot alignment do not apply.
+    bool zmq_zero_copy_receive = false;
+    // Receiving threads, each with its own socket, feeding a multi producer ring buffer. With a comma separated 
+    // connect address, receiver i connects to the addresses i, i + zmq_n_receivers..., otherwise all to the same one.
+    size_t zmq_n_receivers = 1;
+    // Messages (2 per frame) queued by ZMQ before the sender is blocked - bounds the backlog when the ring buffer is full.
+    int zmq_receive_hwm = 1000;
 
     // Ring buffer config.
     // Allow for a couple of seconds (file creation might be slow).
     size_t ring_buffer_n_slots = 1000;
-    // Delay before trying again to get data from the ring buffer.
-    uint32_t ring_buffer_read_retry_interval = 5;
+    // Max time to wait for data in the ring buffer before checking the writer status again.
+    // The writer wakes up as soon as data arrives, this only limits the reaction time to /stop.
+    uint32_t ring_buffer_read_timeout = 100;
+    // When the ring buffer is full: block (push back to the sender through the ZMQ high water mark), 
+    // drop_newest, drop_oldest (the frames are reported missing) or error (stop receiving).
+    std::string ring_buffer_overflow_policy = "block";
+    // The ring buffer memory options below only apply to the frames copied into the slots - with 
+    // zmq_zero_copy_receive the frames stay in the ZMQ message memory (a warning is printed).
+    // Hugepages for the ring buffer memory: 0 (normal pages), 2MB or 1GB. Falls back to transparent hugepages.
+    size_t ring_buffer_hugepage_size = 0;
+    // mlock the ring buffer memory (needs a large enough ulimit -l).
+    bool ring_buffer_lock_memory = false;
+    // Touch all ring buffer pages at allocation, so no page faults happen while receiving.
+    bool ring_buffer_prefault = false;
+    // NUMA node of the ring buffer memory: -1 (no binding), -2 (node of the receiving thread) or the node number.
+    int ring_buffer_numa_node = -1;
+    // Use the NUMA node of this network interface (e.g. "eth0") instead - overrides ring_buffer_numa_node if it 
+    // can be resolved.
+    std::string ring_buffer_numa_interface = "";
+    // Second ring buffer tier in this file (on a local NVMe) for storage stalls the RAM slots cannot absorb - 
+    // "" disables it. Striped writers append _<stripe index>. The file is removed right after it is created.
+    std::string spill_file = "";
+    // Preallocated size of the spill file in bytes - 16GB.
+    size_t spill_file_size = 16UL * 1024 * 1024 * 1024;
+    // Frames are spilled once this fraction of the RAM slots is used, until the writer has read all spilled frames.
+    double spill_threshold = 0.8;
+    // Spilled frames the writer can hold at once - more than reorder_window_size + compression_n_threads.
+    size_t spill_n_read_slots = 64;
 
     std::string raw_image_dataset_name = "raw_data";
+
+    // Compression of the raw image dataset: none, bitshuffle_lz4 (WITH_BITSHUFFLE) or zstd (WITH_ZSTD).
+    std::string compression_method = "none";
+    // Used by zstd only.
+    int compression_level = 3;
+    // Roughly 1 thread / (500 MB/s) for bitshuffle_lz4.
+    size_t compression_n_threads = 4;
     
     // By how much to enlarge a dataset when a resizing is needed.
     hsize_t dataset_increase_step = 1000;
     // To which value to initialize a dataset size.
     hsize_t initial_dataset_size = 1000;
+    // Number of frames stored in one HDF5 chunk. Frames of compressed datasets are always in their own chunk (a warning 
+    // is printed if compression is configured as well). With more than 1, every frame is copied into a chunk buffer 
+    // before it is written - the frames are not written directly from the ring buffer slots (zmq_zero_copy_receive).
+    hsize_t frames_per_chunk = 1;
+    // Create the next file and close the previous one on a helper thread (needs a threadsafe HDF5).
+    bool async_file_rollover = true;
+    // Striped writers - frame i goes to output file (i % n_writers) + 1, the output file is a %d template.
+    size_t n_writers = 1;
+    // With frames_per_file, write a master file (output template with %d replaced by 'master') with virtual datasets.
+    bool write_master_file = true;
+    // Single writer multiple readers - the files can be read while they are written.
+    bool swmr_mode = false;
+    // How often (in ms) to make the written frames visible to the SWMR readers.
+    uint32_t swmr_flush_interval = 1000;
+    // HDF5 file tuning (H5WriterIoProfile) - 0 (false) keeps the library default.
+    // Chunks (allocations of at least h5_alignment_threshold bytes) start at a multiple of h5_alignment - the RAID stripe.
+    // A threshold of 0 uses h5_alignment, so the metadata blocks and small datasets are not padded to the stripe.
+    hsize_t h5_alignment = 0;
+    hsize_t h5_alignment_threshold = 0;
+    // Metadata allocated in blocks of this size, apart from the raw data.
+    hsize_t h5_meta_block_size = 0;
+    // Paged aggregation with this page size, and a page buffer (multiple of h5_page_size, not used in SWMR mode).
+    hsize_t h5_page_size = 0;
+    size_t h5_page_buffer_size = 0;
+    bool h5_latest_format = false;
+    // Metadata cache size (at most 128MB) - nothing is evicted before the file is closed.
+    size_t h5_metadata_cache_size = 0;
+    // Write the files with O_DIRECT (HDF5 direct VFD), bypassing the page cache - sec2 if the filesystem or the HDF5 
+    // build does not support it. Not with swmr_mode. The ring buffer slots and the chunks in the file are aligned to 
+    // h5_direct_io_alignment - the ZMQ messages (zmq_zero_copy_receive), the frames_per_chunk buffers and the 
+    // compressed frames are not, they go through the copy buffer.
+    bool h5_direct_io = false;
+    size_t h5_direct_io_alignment = 4096;
+    // Unaligned writes (metadata, small chunks) go through a copy buffer of this size.
+    size_t h5_direct_io_copy_buffer_size = 16 * 1024 * 1024;
+    // The metadata is written in blocks (and chunks) of this many frames - the staging buffer holds one block.
+    size_t metadata_block_n_frames = 1000;
+    // Write the frames in frame_index order, holding at most this many early frames (0 writes in arrival order).
+    // Must be well below ring_buffer_n_slots - the held frames keep their ring buffer slots.
+    size_t reorder_window_size = 0;
+    // How long (in ms) to wait for a missing frame before it is declared lost.
+    uint32_t reorder_lost_frame_timeout = 1000;
+    // Pixel value of the frames that did not arrive (converted to the image type). The metadata of these frames is 0.
+    double missing_frame_fill_value = 0;
 
     // Delay in between attempts to see if the requred parameters were passed over the REST api.
     uint32_t parameters_read_retry_interval = 300;
@@ -10,14 +10,51 @@ namespace config
     extern int zmq_receive_timeout;
     extern int zmq_buffer_size_header;
     extern int zmq_buffer_size_data;
+    extern bool zmq_zero_copy_receive;
+    extern size_t zmq_n_receivers;
+    extern int zmq_receive_hwm;
 
     extern size_t ring_buffer_n_slots;
-    extern uint32_t ring_buffer_read_retry_interval;
+    extern uint32_t ring_buffer_read_timeout;
+    extern std::string ring_buffer_overflow_policy;
+    extern size_t ring_buffer_hugepage_size;
+    extern bool ring_buffer_lock_memory;
+    extern bool ring_buffer_prefault;
+    extern int ring_buffer_numa_node;
+    extern std::string ring_buffer_numa_interface;
+    extern std::string spill_file;
+    extern size_t spill_file_size;
+    extern double spill_threshold;
+    extern size_t spill_n_read_slots;
 
     extern hsize_t dataset_increase_step;
     extern hsize_t initial_dataset_size;
+    extern hsize_t frames_per_chunk;
+    extern bool async_file_rollover;
+    extern size_t n_writers;
+    extern bool write_master_file;
+    extern bool swmr_mode;
+    extern uint32_t swmr_flush_interval;
+    extern hsize_t h5_alignment;
+    extern hsize_t h5_alignment_threshold;
+    extern hsize_t h5_meta_block_size;
+    extern hsize_t h5_page_size;
+    extern size_t h5_page_buffer_size;
+    extern bool h5_latest_format;
+    extern size_t h5_metadata_cache_size;
+    extern bool h5_direct_io;
+    extern size_t h5_direct_io_alignment;
+    extern size_t h5_direct_io_copy_buffer_size;
+    extern size_t metadata_block_n_frames;
+    extern size_t reorder_window_size;
+    extern uint32_t reorder_lost_frame_timeout;
+    extern double missing_frame_fill_value;
     extern std::string raw_image_dataset_name;
 
+    extern std::string compression_method;
+    extern int compression_level;
+    extern size_t compression_n_threads;
+
     extern uint32_t parameters_read_retry_interval;
 }
 
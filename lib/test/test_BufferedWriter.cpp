@@ -71,4 +71,105 @@ TEST(BufferedWriter, process_manager_workflow)
     EXPECT_FALSE(writer->is_file_open());
 
     EXPECT_NO_THROW(writer->close_file());
-}
\ No newline at end of file
+}
+TEST(BufferedWriter, swmr_mode)
+{
+    auto header_values = shared_ptr<unordered_map<string, HeaderDataType>>(new unordered_map<string, HeaderDataType> {
+        {"frame", HeaderDataType("uint64")}
+    });
+
+    vector<size_t> frame_shape = {2};
+    size_t frame_bytes_size = 2 * sizeof(uint16_t);
+
+    auto metadata_buffer = unique_ptr<MetadataBuffer>(new MetadataBuffer(10, header_values));
+    BufferedWriter writer("ignore_swmr.h5", 10, move(metadata_buffer), 0, 10, 10);
+    writer.set_swmr_mode(true, 0);
+
+    auto read_frames = [](const char* dataset_name) {
+        H5::FileAccPropList file_access_properties;
+        file_access_properties.setLibverBounds(H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+
+        H5::H5File input_file("ignore_swmr.h5", H5F_ACC_RDONLY | H5F_ACC_SWMR_READ, 
+            H5::FileCreatPropList::DEFAULT, file_access_properties);
+
+        hsize_t dataset_dimensions[2];
+        input_file.openDataSet(dataset_name).getSpace().getSimpleExtentDims(dataset_dimensions);
+
+        return dataset_dimensions[0];
+    };
+
+    for (uint64_t frame_index=0; frame_index<5; frame_index++) {
+        uint16_t frame_data[2] = {static_cast<uint16_t>(frame_index), 0};
+
+        writer.write_data("data", frame_index, reinterpret_cast<char*>(frame_data), frame_shape, 
+            frame_bytes_size, "uint16", "little");
+        writer.cache_metadata("frame", frame_index, reinterpret_cast<char*>(&frame_index));
+    }
+
+    // Visible while the file is written - the metadata of the last frame comes with the next flush.
+    ASSERT_EQ(read_frames("data"), 5u);
+    ASSERT_EQ(read_frames("frame"), 4u);
+
+    writer.close_file();
+
+    H5::H5File input_file("ignore_swmr.h5", H5F_ACC_RDONLY);
+    uint64_t frames[5];
+    input_file.openDataSet("frame").read(frames, H5::PredType::NATIVE_UINT64);
+
+    for (uint64_t frame_index=0; frame_index<5; frame_index++) {
+        ASSERT_EQ(frames[frame_index], frame_index);
+    }
+}
+
+TEST(BufferedWriter, streamed_metadata)
+{
+    auto header_values = shared_ptr<unordered_map<string, HeaderDataType>>(new unordered_map<string, HeaderDataType> {
+        {"frame", HeaderDataType("uint64")},
+        {"module_number", HeaderDataType("uint64", 2)}
+    });
+
+    vector<size_t> frame_shape = {2};
+    size_t frame_bytes_size = 2 * sizeof(uint16_t);
+
+    {
+        // Staging buffer for 3 frames, unknown number of frames.
+        auto metadata_buffer = unique_ptr<MetadataBuffer>(new MetadataBuffer(3, header_values));
+        BufferedWriter writer("ignore_streamed_metadata.h5", 0, move(metadata_buffer), 0, 0, 4);
+
+        // Frame 2 arrives after its block was written, frame 8 never arrives.
+        vector<uint64_t> frame_indexes = {0, 1, 3, 4, 2, 5, 6, 7, 9};
+
+        for (auto frame_index : frame_indexes) {
+            uint16_t frame_data[2] = {static_cast<uint16_t>(frame_index), 0};
+            uint64_t module_number[2] = {frame_index * 10, (frame_index * 10) + 1};
+
+            writer.write_data("data", frame_index, reinterpret_cast<char*>(frame_data), frame_shape, 
+                frame_bytes_size, "uint16", "little");
+            writer.cache_metadata("frame", frame_index, reinterpret_cast<char*>(&frame_index));
+            writer.cache_metadata("module_number", frame_index, reinterpret_cast<char*>(module_number));
+        }
+    }
+
+    H5::H5File input_file("ignore_streamed_metadata.h5", H5F_ACC_RDONLY);
+    auto frame_dataset = input_file.openDataSet("frame");
+
+    hsize_t chunk_dimensions[2];
+    frame_dataset.getCreatePlist().getChunk(2, chunk_dimensions);
+    ASSERT_EQ(chunk_dimensions[0], 3u);
+
+    hsize_t dataset_dimensions[2];
+    frame_dataset.getSpace().getSimpleExtentDims(dataset_dimensions);
+    ASSERT_EQ(dataset_dimensions[0], 10u);
+
+    uint64_t frames[10];
+    frame_dataset.read(frames, H5::PredType::NATIVE_UINT64);
+
+    uint64_t module_number[10][2];
+    input_file.openDataSet("module_number").read(module_number, H5::PredType::NATIVE_UINT64);
+
+    for (uint64_t frame_index=0; frame_index<10; frame_index++) {
+        uint64_t expected_frame = frame_index == 8 ? 0 : frame_index;
+        ASSERT_EQ(frames[frame_index], expected_frame);
+        ASSERT_EQ(module_number[frame_index][1], frame_index == 8 ? 0 : (frame_index * 10) + 1);
+    }
+}
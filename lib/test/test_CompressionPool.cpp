@@ -0,0 +1,166 @@
+#include <thread>
+#include "gtest/gtest.h"
+#include "../src/CompressionPool.hpp"
+#include "../src/SpscRingBuffer.hpp"
+#include "../src/H5Writer.hpp"
+
+using namespace std;
+
+// Byte shuffle, as done by the HDF5 built-in shuffle filter - the file is readable without plugins.
+class ShuffleCompressor : public FrameCompressor
+{
+    public:
+        string get_name() const override
+            { return "shuffle"; }
+
+        size_t get_max_compressed_bytes_size(size_t data_bytes_size, size_t element_bytes_size) const override
+            { return data_bytes_size; }
+
+        size_t compress(const char* data, size_t data_bytes_size, size_t element_bytes_size,
+            char* compressed_data, size_t max_compressed_bytes_size) const override
+        {
+            size_t n_elements = data_bytes_size / element_bytes_size;
+
+            for (size_t element=0; element<n_elements; element++) {
+                for (size_t byte=0; byte<element_bytes_size; byte++) {
+                    compressed_data[(byte * n_elements) + element] = data[(element * element_bytes_size) + byte];
+                }
+            }
+
+            // Make the workers finish out of order.
+            this_thread::sleep_for(chrono::microseconds(rand() % 500));
+
+            return data_bytes_size;
+        }
+
+        void set_dataset_filter(H5::DSetCreatPropList& dataset_properties, size_t element_bytes_size) const override
+            { dataset_properties.setShuffle(); }
+};
+
+TEST(CompressionPool, frame_order)
+{
+    size_t n_frames = 200;
+    size_t frame_bytes_size = 64;
+
+    SpscRingBuffer ring_buffer(20);
+    ring_buffer.initialize(frame_bytes_size);
+
+    CompressionPool compression_pool(ring_buffer, make_shared<ShuffleCompressor>(), 4, 10);
+
+    thread producer([&](){
+        char frame_data[frame_bytes_size];
+
+        for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+            auto frame_metadata = make_shared<FrameMetadata>();
+            frame_metadata->frame_index = frame_index;
+            frame_metadata->frame_bytes_size = frame_bytes_size;
+            frame_metadata->type = "uint32";
+
+            memset(frame_data, static_cast<int>(frame_index), frame_bytes_size);
+
+            // Wait for the writer to release the slots.
+            while (true) {
+                try {
+                    ring_buffer.write(frame_metadata, frame_data);
+                    break;
+                } catch (const runtime_error&) {
+                    this_thread::sleep_for(chrono::microseconds(100));
+                }
+            }
+        }
+
+        ring_buffer.shutdown();
+    });
+
+    for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+        const CompressedFrame* compressed_frame = NULL;
+
+        while (!compressed_frame) {
+            compressed_frame = compression_pool.read_wait(100);
+        }
+
+        ASSERT_EQ(compressed_frame->frame_metadata->frame_index, frame_index);
+        ASSERT_EQ(compressed_frame->filter_mask, 0u);
+        ASSERT_EQ(compressed_frame->data_bytes_size, frame_bytes_size);
+        ASSERT_EQ(compressed_frame->data[0], static_cast<char>(frame_index));
+
+        ring_buffer.release(compressed_frame->frame_metadata->buffer_slot_index);
+        compression_pool.release();
+    }
+
+    producer.join();
+
+    ASSERT_TRUE(compression_pool.is_empty());
+    ASSERT_TRUE(ring_buffer.is_empty());
+    ASSERT_THROW(compression_pool.release(), runtime_error);
+}
+
+TEST(CompressionPool, write_compressed_chunks)
+{
+    vector<size_t> frame_shape = {2, 4};
+    size_t frame_bytes_size = 2 * 4 * sizeof(uint16_t);
+    size_t n_frames = 5;
+
+    SpscRingBuffer ring_buffer(10);
+    ring_buffer.initialize(frame_bytes_size);
+
+    auto frame_compressor = make_shared<ShuffleCompressor>();
+    CompressionPool compression_pool(ring_buffer, frame_compressor, 2, 10);
+
+    for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = frame_index;
+        frame_metadata->frame_bytes_size = frame_bytes_size;
+        frame_metadata->frame_shape = frame_shape;
+        frame_metadata->type = "uint16";
+        frame_metadata->endianness = "little";
+
+        uint16_t frame_data[8];
+        for (uint16_t value=0; value<8; value++) {
+            frame_data[value] = (frame_index * 1000) + value;
+        }
+
+        ring_buffer.write(frame_metadata, reinterpret_cast<char*>(frame_data));
+    }
+
+    {
+        H5Writer writer("ignore_compression.h5", 0, n_frames, 1);
+        writer.set_dataset_compression("data", frame_compressor);
+
+        for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+            const CompressedFrame* compressed_frame = NULL;
+
+            while (!compressed_frame) {
+                compressed_frame = compression_pool.read_wait(100);
+            }
+
+            const auto& frame_metadata = compressed_frame->frame_metadata;
+
+            // The last frame is written as it is, skipping the filter.
+            if (frame_index == n_frames - 1) {
+                writer.write_data("data", frame_index, compressed_frame->frame_data, frame_metadata->frame_shape,
+                    frame_metadata->frame_bytes_size, frame_metadata->type, frame_metadata->endianness, 1);
+            } else {
+                writer.write_data("data", frame_index, compressed_frame->data, frame_metadata->frame_shape,
+                    compressed_frame->data_bytes_size, frame_metadata->type, frame_metadata->endianness, compressed_frame->filter_mask);
+            }
+
+            ring_buffer.release(frame_metadata->buffer_slot_index);
+            compression_pool.release();
+        }
+    }
+
+    H5::H5File input_file("ignore_compression.h5", H5F_ACC_RDONLY);
+    auto dataset = input_file.openDataSet("data");
+
+    ASSERT_EQ(dataset.getCreatePlist().getNfilters(), 1);
+
+    uint16_t data[5][2][4];
+    dataset.read(data, H5::PredType::NATIVE_UINT16);
+
+    for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+        for (uint16_t value=0; value<8; value++) {
+            ASSERT_EQ(data[frame_index][value / 4][value % 4], (frame_index * 1000) + value);
+        }
+    }
+}
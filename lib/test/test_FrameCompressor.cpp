@@ -0,0 +1,108 @@
+#include <vector>
+#include <cstring>
+#include "gtest/gtest.h"
+#include "../src/FrameCompressor.hpp"
+
+#ifdef WITH_BITSHUFFLE
+extern "C"
+{
+    #include "bitshuffle.h"
+}
+#endif
+
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+#if defined(WITH_BITSHUFFLE) || defined(WITH_ZSTD)
+namespace {
+    // Compressible frame - a ramp of uint16 pixels.
+    vector<uint16_t> get_test_frame()
+    {
+        vector<uint16_t> frame(512 * 1024);
+
+        for (size_t pixel=0; pixel<frame.size(); pixel++) {
+            frame[pixel] = pixel % 1024;
+        }
+
+        return frame;
+    }
+}
+#endif
+
+TEST(FrameCompressor, get_frame_compressor)
+{
+    EXPECT_EQ(get_frame_compressor("none"), nullptr);
+    EXPECT_THROW(get_frame_compressor("no_such_compression"), runtime_error);
+}
+
+#ifdef WITH_BITSHUFFLE
+TEST(FrameCompressor, bitshuffle_lz4)
+{
+    auto compressor = get_frame_compressor("bitshuffle_lz4");
+    ASSERT_EQ(compressor->get_name(), "bitshuffle_lz4");
+
+    auto frame = get_test_frame();
+    size_t frame_bytes_size = frame.size() * sizeof(uint16_t);
+
+    vector<char> compressed_data(compressor->get_max_compressed_bytes_size(frame_bytes_size, sizeof(uint16_t)));
+    auto compressed_bytes_size = compressor->compress(reinterpret_cast<const char*>(frame.data()), frame_bytes_size,
+        sizeof(uint16_t), compressed_data.data(), compressed_data.size());
+
+    ASSERT_GT(compressed_bytes_size, 0u);
+    EXPECT_LT(compressed_bytes_size, frame_bytes_size);
+
+    // Chunk header as read by the bitshuffle HDF5 filter: big endian uint64 size, uint32 block size in bytes.
+    auto header = reinterpret_cast<const unsigned char*>(compressed_data.data());
+    uint64_t uncompressed_bytes_size = 0;
+    for (size_t index=0; index<8; index++) {
+        uncompressed_bytes_size = (uncompressed_bytes_size << 8) | header[index];
+    }
+    uint32_t block_bytes_size = 0;
+    for (size_t index=8; index<12; index++) {
+        block_bytes_size = (block_bytes_size << 8) | header[index];
+    }
+
+    ASSERT_EQ(uncompressed_bytes_size, frame_bytes_size);
+
+    vector<uint16_t> decompressed_frame(frame.size());
+    auto n_read_bytes = bshuf_decompress_lz4(compressed_data.data() + 12, decompressed_frame.data(), frame.size(),
+        sizeof(uint16_t), block_bytes_size / sizeof(uint16_t));
+
+    EXPECT_EQ(static_cast<size_t>(n_read_bytes), compressed_bytes_size - 12);
+    EXPECT_EQ(decompressed_frame, frame);
+}
+#endif
+
+#ifdef WITH_ZSTD
+TEST(FrameCompressor, zstd)
+{
+    auto compressor = get_frame_compressor("zstd", 3);
+    ASSERT_EQ(compressor->get_name(), "zstd");
+
+    auto frame = get_test_frame();
+    size_t frame_bytes_size = frame.size() * sizeof(uint16_t);
+
+    vector<char> compressed_data(compressor->get_max_compressed_bytes_size(frame_bytes_size, sizeof(uint16_t)));
+    auto compressed_bytes_size = compressor->compress(reinterpret_cast<const char*>(frame.data()), frame_bytes_size,
+        sizeof(uint16_t), compressed_data.data(), compressed_data.size());
+
+    ASSERT_GT(compressed_bytes_size, 0u);
+    EXPECT_LT(compressed_bytes_size, frame_bytes_size);
+
+    // The zstd HDF5 filter decompresses the chunk as one zstd frame.
+    vector<uint16_t> decompressed_frame(frame.size());
+    auto decompressed_bytes_size = ZSTD_decompress(decompressed_frame.data(), frame_bytes_size, 
+        compressed_data.data(), compressed_bytes_size);
+
+    ASSERT_FALSE(ZSTD_isError(decompressed_bytes_size));
+    EXPECT_EQ(decompressed_bytes_size, frame_bytes_size);
+    EXPECT_EQ(decompressed_frame, frame);
+
+    // Too small output buffer - written uncompressed.
+    EXPECT_EQ(compressor->compress(reinterpret_cast<const char*>(frame.data()), frame_bytes_size, sizeof(uint16_t),
+        compressed_data.data(), 10), 0u);
+}
+#endif
@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+
+#include "../src/FrameReorderWindow.hpp"
+#include "../src/SpscRingBuffer.hpp"
+
+using namespace std;
+
+namespace {
+    void write_frame(RingBuffer& ring_buffer, uint64_t frame_index)
+    {
+        char frame_data[] = {1, 2, 3, 4};
+
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = frame_index;
+        frame_metadata->frame_bytes_size = sizeof(frame_data);
+
+        ring_buffer.write(frame_metadata, frame_data);
+    }
+
+    uint64_t read_frame_index(RingBuffer& ring_buffer, FrameReorderWindow& reorder_window, uint32_t timeout=10)
+    {
+        auto received_data = reorder_window.read_wait(timeout);
+        if (!received_data.first) {
+            return -1;
+        }
+
+        ring_buffer.release(received_data.first->buffer_slot_index);
+        return received_data.first->frame_index;
+    }
+}
+
+TEST(FrameReorderWindow, frame_index_order)
+{
+    SpscRingBuffer ring_buffer(10);
+    FrameReorderWindow reorder_window(ring_buffer, 5, 10000);
+
+    for (uint64_t frame_index : {2, 0, 3, 1}) {
+        write_frame(ring_buffer, frame_index);
+    }
+
+    for (uint64_t frame_index=0; frame_index<4; frame_index++) {
+        EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), frame_index);
+    }
+
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), uint64_t(-1));
+    EXPECT_EQ(reorder_window.get_n_lost_frames(), 0u);
+    EXPECT_TRUE(ring_buffer.is_empty());
+}
+
+TEST(FrameReorderWindow, lost_frames)
+{
+    SpscRingBuffer ring_buffer(10);
+    // Striped - frames 1, 3, 5...
+    FrameReorderWindow reorder_window(ring_buffer, 2, 50, 1, 2);
+
+    vector<pair<uint64_t, uint64_t>> lost_frames;
+    reorder_window.set_lost_frames_callback([&lost_frames](uint64_t first_frame_index, uint64_t last_frame_index){ 
+        lost_frames.push_back({first_frame_index, last_frame_index}); 
+    });
+
+    write_frame(ring_buffer, 5);
+
+    // Frames 1 and 3 are lost after the timeout.
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), uint64_t(-1));
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window, 100), 5u);
+    EXPECT_EQ(lost_frames, (vector<pair<uint64_t, uint64_t>>{{1, 3}}));
+
+    // Frame 3 arrives late, frame 9 is lost when the window is full.
+    for (uint64_t frame_index : {3, 7, 11, 13}) {
+        write_frame(ring_buffer, frame_index);
+    }
+
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), 3u);
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), 7u);
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), 11u);
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), 13u);
+    EXPECT_EQ(lost_frames, (vector<pair<uint64_t, uint64_t>>{{1, 3}, {9, 9}}));
+
+    // Held frames are returned at shutdown.
+    write_frame(ring_buffer, 17);
+    ring_buffer.shutdown();
+
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), 17u);
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), uint64_t(-1));
+    EXPECT_TRUE(reorder_window.is_shutdown());
+    EXPECT_EQ(lost_frames, (vector<pair<uint64_t, uint64_t>>{{1, 3}, {9, 9}, {15, 15}}));
+
+    EXPECT_EQ(reorder_window.get_n_lost_frames(), 4u);
+}
+
+TEST(FrameReorderWindow, late_frame_for_past_file)
+{
+    SpscRingBuffer ring_buffer(10);
+    FrameReorderWindow reorder_window(ring_buffer, 1, 10000);
+    reorder_window.set_frames_per_file(3);
+
+    vector<uint64_t> dropped_frames;
+    reorder_window.set_dropped_frame_callback([&dropped_frames](uint64_t frame_index){ 
+        dropped_frames.push_back(frame_index); 
+    });
+
+    // Frames 1 and 2 are lost when the window is full, frame 3 starts the second file.
+    for (uint64_t frame_index : {0, 3, 1, 4, 5, 2}) {
+        write_frame(ring_buffer, frame_index);
+    }
+
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), 0u);
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), 3u);
+
+    // Frames 1 and 2 belong to the first file - not returned.
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), 4u);
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), 5u);
+    EXPECT_EQ(read_frame_index(ring_buffer, reorder_window), uint64_t(-1));
+
+    EXPECT_EQ(dropped_frames, vector<uint64_t>({1, 2}));
+    EXPECT_EQ(reorder_window.get_n_lost_frames(), 2u);
+    EXPECT_TRUE(ring_buffer.is_empty());
+}
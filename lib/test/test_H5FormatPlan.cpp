@@ -0,0 +1,149 @@
+#include "gtest/gtest.h"
+#include "../src/H5FormatPlan.hpp"
+#include "../src/H5Writer.hpp"
+
+using namespace std;
+
+class TestFormat : public H5Format
+{
+    unordered_map<string, DATA_TYPE> input_value_type = {{"user", NX_CHAR}};
+    // The calculated distance overrides its default.
+    unordered_map<string, boost::any> default_values = {{"n_modules", 4}, {"distance", 1.0}};
+    unordered_map<string, string> dataset_move_mapping = {{"data", "entry/detector/data"}};
+    h5_parent format_definition;
+
+    public:
+        TestFormat() : format_definition("", EMPTY_ROOT, {
+            shared_ptr<h5_base>(new h5_group("entry", {
+                shared_ptr<h5_base>(new h5_attr("NX_class", "NXentry", NX_CHAR)),
+                shared_ptr<h5_base>(new h5_dataset("user", "user", NX_CHAR)),
+                shared_ptr<h5_base>(new h5_group("detector", {
+                    shared_ptr<h5_base>(new h5_dataset("n_modules", "n_modules", NX_INT, {
+                        shared_ptr<h5_base>(new h5_attr("units", "modules", NX_CHAR))
+                    })),
+                    shared_ptr<h5_base>(new h5_dataset("distance", "distance", NX_FLOAT)),
+                }))
+            }))
+        }) {}
+
+        const unordered_map<string, DATA_TYPE>& get_input_value_type() const override { return input_value_type; }
+        const unordered_map<string, boost::any>& get_default_values() const override { return default_values; }
+        const h5_parent& get_format_definition() const override { return format_definition; }
+        const unordered_map<string, string>& get_dataset_move_mapping() const override { return dataset_move_mapping; }
+
+        void add_calculated_values(unordered_map<string, boost::any>& values) const override
+        {
+            values["distance"] = 1.5;
+        }
+
+        void add_input_values(unordered_map<string, boost::any>& values,
+            const unordered_map<string, boost::any>& input_values) const override
+        {
+            for (const auto& input_value : input_values) {
+                values[input_value.first] = input_value.second;
+            }
+        }
+};
+
+TEST(H5FormatPlan, write)
+{
+    TestFormat format;
+    H5FormatPlan format_plan(format);
+
+    // 2 groups, 3 datasets, 2 attributes and the move.
+    EXPECT_EQ(format_plan.get_operations().size(), 8u);
+
+    // The plan is reused for each file.
+    for (int file_index=0; file_index<2; file_index++) {
+        H5::H5File file("ignore_format_plan.h5", H5F_ACC_TRUNC);
+
+        int data_value = 7;
+        file.createDataSet("data", H5::PredType::NATIVE_INT, H5::DataSpace(H5S_SCALAR)).write(&data_value, H5::PredType::NATIVE_INT);
+
+        format_plan.write(file, {{"user", string("e12345")}});
+
+        string user;
+        H5::DataSet user_dataset = file.openDataSet("entry/user");
+        user_dataset.read(user, user_dataset.getDataType());
+        EXPECT_EQ(user, "e12345");
+
+        int n_modules;
+        file.openDataSet("entry/detector/n_modules").read(&n_modules, H5::PredType::NATIVE_INT);
+        EXPECT_EQ(n_modules, 4);
+
+        double distance;
+        file.openDataSet("entry/detector/distance").read(&distance, H5::PredType::NATIVE_DOUBLE);
+        EXPECT_EQ(distance, 1.5);
+
+        string nx_class;
+        H5::Attribute nx_class_attribute = file.openGroup("entry").openAttribute("NX_class");
+        nx_class_attribute.read(nx_class_attribute.getDataType(), nx_class);
+        EXPECT_EQ(nx_class, "NXentry");
+
+        EXPECT_TRUE(file.openDataSet("entry/detector/n_modules").attrExists("units"));
+        EXPECT_FALSE(file.nameExists("data"));
+        EXPECT_TRUE(file.nameExists("entry/detector/data"));
+    }
+
+    // Missing reference values are reported when writing.
+    H5::H5File file("ignore_format_plan.h5", H5F_ACC_TRUNC);
+    EXPECT_THROW(format_plan.write(file, {}), runtime_error);
+}
+
+TEST(H5FormatPlan, datasets_in_place)
+{
+    TestFormat format;
+    H5FormatPlan format_plan(format, false);
+
+    // Without the move.
+    EXPECT_EQ(format_plan.get_operations().size(), 7u);
+
+    vector<size_t> frame_shape = {2};
+
+    {
+        H5Writer writer("ignore_format_plan_in_place.h5", 0, 4, 4);
+
+        // The writer creates the groups on the way, the format fills them.
+        writer.set_dataset_path("data", format.get_dataset_move_mapping().at("data"));
+        writer.set_file_finalizer([&](H5::H5File& file){ format_plan.write(file, {{"user", string("e12345")}}); });
+
+        for (size_t frame_index=0; frame_index<4; frame_index++) {
+            uint32_t frame_data[2] = {static_cast<uint32_t>(frame_index), static_cast<uint32_t>(frame_index)};
+
+            writer.write_data("data", frame_index, reinterpret_cast<char*>(frame_data), frame_shape, 
+                sizeof(frame_data), "uint32", "little");
+        }
+    }
+
+    H5::H5File file("ignore_format_plan_in_place.h5", H5F_ACC_RDONLY);
+
+    EXPECT_FALSE(file.nameExists("data"));
+    EXPECT_TRUE(file.nameExists("entry/detector/data"));
+    EXPECT_TRUE(file.nameExists("entry/detector/n_modules"));
+    EXPECT_TRUE(file.openGroup("entry").attrExists("NX_class"));
+}
+
+TEST(H5FormatPlan, skeleton)
+{
+    TestFormat format;
+    H5FormatPlan format_plan(format, false);
+
+    H5::H5File file("ignore_format_plan_skeleton.h5", H5F_ACC_TRUNC);
+
+    // Groups and default values only.
+    format_plan.write_skeleton(file);
+
+    EXPECT_TRUE(file.nameExists("entry/detector/n_modules"));
+    EXPECT_TRUE(file.openDataSet("entry/detector/n_modules").attrExists("units"));
+    EXPECT_FALSE(file.nameExists("entry/user"));
+    EXPECT_FALSE(file.nameExists("entry/detector/distance"));
+
+    // The input and calculated values are added to the skeleton.
+    format_plan.write(file, {{"user", string("e12345")}}, true);
+
+    EXPECT_TRUE(file.nameExists("entry/user"));
+
+    double distance;
+    file.openDataSet("entry/detector/distance").read(&distance, H5::PredType::NATIVE_DOUBLE);
+    EXPECT_EQ(distance, 1.5);
+}
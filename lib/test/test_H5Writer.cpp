@@ -1,4 +1,5 @@
 #include "gtest/gtest.h"
+#include <fstream>
 #include "../src/H5Writer.hpp"
 using namespace std;
 
@@ -25,4 +26,290 @@ TEST(H5Writer, DummyH5Writer)
     vector<size_t> shape = {1};
 
     EXPECT_NO_THROW(dummy_writer.write_data("does not matter", 0, buffer.get(), shape, 0, "nop", "nop"));
-}
\ No newline at end of file
+}
+TEST(H5Writer, frames_per_chunk)
+{
+    vector<size_t> frame_shape = {2, 2};
+    size_t frame_bytes_size = 4 * sizeof(uint32_t);
+
+    {
+        H5Writer writer("ignore_frames_per_chunk.h5", 0, 10, 10, 4);
+
+        // Out of order within a chunk, a gap (frame 7), and a late frame (6) for an already written chunk.
+        vector<size_t> frame_indexes = {0, 1, 3, 2, 5, 4, 8, 6, 9};
+
+        for (auto frame_index : frame_indexes) {
+            uint32_t frame_data[4];
+            for (uint32_t value=0; value<4; value++) {
+                frame_data[value] = (frame_index * 10) + value + 1;
+            }
+
+            writer.write_data("data", frame_index, reinterpret_cast<char*>(frame_data), frame_shape, 
+                frame_bytes_size, "uint32", "little");
+        }
+    }
+
+    H5::H5File input_file("ignore_frames_per_chunk.h5", H5F_ACC_RDONLY);
+    auto dataset = input_file.openDataSet("data");
+
+    hsize_t chunk_dimensions[3];
+    dataset.getCreatePlist().getChunk(3, chunk_dimensions);
+    ASSERT_EQ(chunk_dimensions[0], 4u);
+
+    hsize_t dataset_dimensions[3];
+    dataset.getSpace().getSimpleExtentDims(dataset_dimensions);
+    ASSERT_EQ(dataset_dimensions[0], 10u);
+
+    uint32_t data[10][2][2];
+    dataset.read(data, H5::PredType::NATIVE_UINT32);
+
+    for (size_t frame_index=0; frame_index<10; frame_index++) {
+        for (uint32_t value=0; value<4; value++) {
+            uint32_t expected_value = frame_index == 7 ? 0 : (frame_index * 10) + value + 1;
+            ASSERT_EQ(data[frame_index][value / 2][value % 2], expected_value) << "frame_index " << frame_index;
+        }
+    }
+}
+
+TEST(H5Writer, async_file_rollover)
+{
+    vector<size_t> frame_shape = {2};
+    size_t frame_bytes_size = 2 * sizeof(uint32_t);
+    size_t n_frames = 12;
+
+    remove("ignore_rollover_4.h5");
+
+    {
+        H5Writer writer("ignore_rollover_%d.h5", 5, 5, 5);
+        writer.set_async_file_rollover(true);
+
+        // Runs for each file, the last one included.
+        writer.set_file_finalizer([](H5::H5File& file){ 
+            H5::Group(file.createGroup("finalized"));
+        });
+
+        for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+            uint32_t frame_data[2] = {static_cast<uint32_t>(frame_index), static_cast<uint32_t>(frame_index * 10)};
+
+            writer.write_data("data", frame_index, reinterpret_cast<char*>(frame_data), frame_shape, 
+                frame_bytes_size, "uint32", "little");
+        }
+
+        writer.close_file();
+    }
+
+    vector<size_t> expected_n_frames = {5, 5, 2};
+
+    for (size_t file_index=0; file_index<expected_n_frames.size(); file_index++) {
+        string filename = "ignore_rollover_" + to_string(file_index + 1) + ".h5";
+        H5::H5File input_file(filename.c_str(), H5F_ACC_RDONLY);
+
+        ASSERT_TRUE(input_file.exists("finalized")) << filename;
+
+        auto dataset = input_file.openDataSet("data");
+
+        hsize_t dataset_dimensions[2];
+        dataset.getSpace().getSimpleExtentDims(dataset_dimensions);
+        ASSERT_EQ(dataset_dimensions[0], expected_n_frames[file_index]) << filename;
+
+        uint32_t data[5][2];
+        dataset.read(data, H5::PredType::NATIVE_UINT32);
+
+        for (size_t frame_in_file=0; frame_in_file<expected_n_frames[file_index]; frame_in_file++) {
+            size_t frame_index = (file_index * 5) + frame_in_file;
+            ASSERT_EQ(data[frame_in_file][0], frame_index);
+            ASSERT_EQ(data[frame_in_file][1], frame_index * 10);
+        }
+    }
+
+    // The file prepared for frames 15-19 is removed.
+    ifstream unused_file("ignore_rollover_4.h5");
+    ASSERT_FALSE(unused_file.good());
+}
+
+TEST(H5Writer, frame_for_past_file)
+{
+    vector<size_t> frame_shape = {2};
+    size_t frame_bytes_size = 2 * sizeof(uint32_t);
+
+    {
+        H5Writer writer("ignore_past_file_%d.h5", 5, 5, 5);
+
+        for (size_t frame_index=0; frame_index<7; frame_index++) {
+            uint32_t frame_data[2] = {static_cast<uint32_t>(frame_index), 0};
+
+            writer.write_data("data", frame_index, reinterpret_cast<char*>(frame_data), frame_shape, 
+                frame_bytes_size, "uint32", "little");
+        }
+
+        // Frame 4 arrives after frame 5 started the second file.
+        ASSERT_TRUE(writer.is_data_for_past_file(4));
+        ASSERT_FALSE(writer.is_data_for_past_file(5));
+        ASSERT_FALSE(writer.is_data_for_past_file(10));
+
+        uint32_t late_frame_data[2] = {4, 0};
+        EXPECT_THROW(writer.write_data("data", 4, reinterpret_cast<char*>(late_frame_data), frame_shape, 
+            frame_bytes_size, "uint32", "little"), runtime_error);
+
+        // The current file is still written.
+        uint32_t frame_data[2] = {7, 0};
+        writer.write_data("data", 7, reinterpret_cast<char*>(frame_data), frame_shape, 
+            frame_bytes_size, "uint32", "little");
+
+        writer.close_file();
+    }
+
+    vector<size_t> expected_n_frames = {5, 3};
+
+    for (size_t file_index=0; file_index<expected_n_frames.size(); file_index++) {
+        string filename = "ignore_past_file_" + to_string(file_index + 1) + ".h5";
+        H5::H5File input_file(filename.c_str(), H5F_ACC_RDONLY);
+
+        hsize_t dataset_dimensions[2];
+        input_file.openDataSet("data").getSpace().getSimpleExtentDims(dataset_dimensions);
+        ASSERT_EQ(dataset_dimensions[0], expected_n_frames[file_index]) << filename;
+    }
+}
+
+TEST(H5Writer, master_file)
+{
+    vector<size_t> frame_shape = {2};
+    size_t frame_bytes_size = 2 * sizeof(uint32_t);
+    size_t n_frames = 10;
+
+    auto read_master_file = [](vector<uint32_t>& data) {
+        H5::H5File master_file("ignore_master_master.h5", H5F_ACC_RDONLY);
+        auto dataset = master_file.openDataSet("entry/data");
+
+        hsize_t dataset_dimensions[2];
+        dataset.getSpace().getSimpleExtentDims(dataset_dimensions);
+
+        data.resize(dataset_dimensions[0] * 2);
+        dataset.read(data.data(), H5::PredType::NATIVE_UINT32);
+    };
+
+    {
+        H5Writer writer("ignore_master_%d.h5", 4, 4, 4);
+        writer.set_write_master_file(true);
+
+        // Like the file format, moves the dataset - also in the master file.
+        writer.set_file_finalizer([](H5::H5File& file){ 
+            H5::Group(file.createGroup("entry"));
+            file.move("data", "entry/data");
+        });
+
+        for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+            uint32_t frame_data[2] = {static_cast<uint32_t>(frame_index), static_cast<uint32_t>(frame_index * 10)};
+
+            writer.write_data("data", frame_index, reinterpret_cast<char*>(frame_data), frame_shape, 
+                frame_bytes_size, "uint32", "little");
+
+            // The first file is finalized synchronously when the first frame of the second file arrives.
+            if (frame_index == 4) {
+                vector<uint32_t> data;
+                read_master_file(data);
+
+                ASSERT_EQ(data.size(), 4u * 2);
+                ASSERT_EQ(data[3 * 2], 3u);
+            }
+        }
+    }
+
+    vector<uint32_t> data;
+    read_master_file(data);
+
+    ASSERT_EQ(data.size(), n_frames * 2);
+
+    for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+        ASSERT_EQ(data[frame_index * 2], frame_index);
+        ASSERT_EQ(data[(frame_index * 2) + 1], frame_index * 10);
+    }
+}
+
+TEST(H5Writer, fill_value)
+{
+    vector<size_t> frame_shape = {2};
+
+    {
+        H5Writer writer("ignore_fill_value.h5", 0, 16, 16, 4);
+        writer.set_dataset_fill_value("data", -1);
+
+        // Frame 3 is missing in a flushed chunk, frames 5-7 in the last chunk buffer, chunk 8-11 is never written.
+        for (size_t frame_index : {0, 1, 2, 4, 13}) {
+            int32_t frame_data[2] = {int32_t(frame_index), int32_t(frame_index)};
+
+            writer.write_data("data", frame_index, reinterpret_cast<char*>(frame_data), frame_shape, 
+                sizeof(frame_data), "int32", "little");
+        }
+    }
+
+    H5::H5File input_file("ignore_fill_value.h5", H5F_ACC_RDONLY);
+    auto dataset = input_file.openDataSet("data");
+
+    hsize_t dataset_dimensions[2];
+    dataset.getSpace().getSimpleExtentDims(dataset_dimensions);
+    ASSERT_EQ(dataset_dimensions[0], 14u);
+
+    int32_t data[14][2];
+    dataset.read(data, H5::PredType::NATIVE_INT32);
+
+    for (int32_t frame_index=0; frame_index<14; frame_index++) {
+        bool is_written = frame_index <= 2 || frame_index == 4 || frame_index == 13;
+        int32_t expected_value = is_written ? frame_index : -1;
+
+        EXPECT_EQ(data[frame_index][0], expected_value) << "frame_index " << frame_index;
+        EXPECT_EQ(data[frame_index][1], expected_value) << "frame_index " << frame_index;
+    }
+}
+
+TEST(H5Writer, io_profile)
+{
+    vector<size_t> frame_shape = {1024};
+
+    auto write_file = [&](const H5WriterIoProfile& io_profile) {
+        H5Writer writer("ignore_io_profile.h5", 0, 16, 16);
+        writer.set_io_profile(io_profile);
+
+        for (size_t frame_index=0; frame_index<16; frame_index++) {
+            vector<uint32_t> frame_data(1024, frame_index);
+
+            writer.write_data("data", frame_index, reinterpret_cast<char*>(frame_data.data()), frame_shape, 
+                frame_data.size() * sizeof(uint32_t), "uint32", "little");
+        }
+    };
+
+    H5WriterIoProfile io_profile;
+    io_profile.alignment = 64 * 1024;
+    io_profile.alignment_threshold = 4 * 1024;
+    io_profile.meta_block_size = 64 * 1024;
+    io_profile.latest_format = true;
+    io_profile.metadata_cache_size = 8 * 1024 * 1024;
+
+    write_file(io_profile);
+
+    {
+        H5::H5File input_file("ignore_io_profile.h5", H5F_ACC_RDONLY);
+        auto dataset = input_file.openDataSet("data");
+
+        // Each 4KB frame chunk starts on the alignment.
+        for (hsize_t chunk_index=0; chunk_index<16; chunk_index++) {
+            hsize_t chunk_offset[2] = {chunk_index, 0};
+            haddr_t chunk_address;
+
+            ASSERT_GE(H5Dget_chunk_info_by_coord(dataset.getId(), chunk_offset, NULL, &chunk_address, NULL), 0);
+            EXPECT_EQ(chunk_address % io_profile.alignment, 0u) << "chunk_index " << chunk_index;
+        }
+    }
+
+    // Paged aggregation - the small chunks share pages.
+    io_profile.page_size = 64 * 1024;
+    io_profile.page_buffer_size = 1024 * 1024;
+
+    write_file(io_profile);
+
+    H5::H5File input_file("ignore_io_profile.h5", H5F_ACC_RDONLY);
+
+    uint32_t data[16][1024];
+    input_file.openDataSet("data").read(data, H5::PredType::NATIVE_UINT32);
+    EXPECT_EQ(data[15][1023], 15u);
+}
@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+#include <thread>
+
+#include "../src/LatencyMetrics.hpp"
+
+using namespace std;
+
+TEST(LatencyHistogram, percentiles)
+{
+    LatencyHistogram histogram;
+
+    EXPECT_EQ(histogram.get_summary().count, 0u);
+
+    // 1us to 1000us.
+    vector<thread> threads;
+    for (uint64_t thread_index=0; thread_index<4; thread_index++) {
+        threads.emplace_back([&histogram, thread_index](){
+            for (uint64_t value=thread_index+1; value<=1000; value+=4) {
+                histogram.record(value * 1000);
+            }
+        });
+    }
+
+    for (auto& recording_thread : threads) {
+        recording_thread.join();
+    }
+
+    auto summary = histogram.get_summary();
+    EXPECT_EQ(summary.count, 1000u);
+    EXPECT_EQ(summary.max, 1000000u);
+
+    // Within the bucket precision of 1/16.
+    EXPECT_NEAR(summary.p50, 500000.0, 500000.0 / 16);
+    EXPECT_NEAR(summary.p99, 990000.0, 990000.0 / 16);
+    EXPECT_NEAR(summary.p999, 999000.0, 999000.0 / 16);
+    EXPECT_GE(summary.p50, 500000u);
+
+    // Small values are exact.
+    histogram.reset();
+    histogram.record(3);
+    EXPECT_EQ(histogram.get_summary().p50, 3u);
+}
+
+TEST(LatencyMetrics, stages)
+{
+    LatencyMetrics::reset();
+
+    {
+        LatencyTimer latency_timer(LATENCY_ROLLOVER);
+        this_thread::sleep_for(chrono::milliseconds(2));
+    }
+
+    auto summary = LatencyMetrics::get_summary(LATENCY_ROLLOVER);
+    EXPECT_EQ(summary.count, 1u);
+    EXPECT_GE(summary.max, 2000000u);
+
+    EXPECT_EQ(LatencyMetrics::get_stage_name(LATENCY_RING_BUFFER_WAIT), "ring_buffer_wait");
+    EXPECT_THROW(LatencyMetrics::get_stage_name(LATENCY_N_STAGES), runtime_error);
+}
@@ -0,0 +1,467 @@
+#include "gtest/gtest.h"
+#include <thread>
+#include <cstring>
+
+#include "../src/RingBuffer.hpp"
+#include "../src/SpscRingBuffer.hpp"
+#include "../src/MpscRingBuffer.hpp"
+
+using namespace std;
+
+TEST(RingBuffer, write_read_release)
+{
+    RingBuffer ring_buffer(3);
+
+    EXPECT_TRUE(ring_buffer.is_empty());
+
+    char frame_data[] = {1, 2, 3, 4};
+
+    auto frame_metadata = make_shared<FrameMetadata>();
+    frame_metadata->frame_index = 12;
+    frame_metadata->frame_bytes_size = sizeof(frame_data);
+
+    ring_buffer.write(frame_metadata, frame_data);
+
+    EXPECT_FALSE(ring_buffer.is_empty());
+
+    auto received_data = ring_buffer.read();
+    ASSERT_TRUE(received_data.first != NULL);
+    EXPECT_EQ(received_data.first->frame_index, 12u);
+    EXPECT_EQ(memcmp(received_data.second, frame_data, sizeof(frame_data)), 0);
+
+    // The frame data was copied into the ring buffer.
+    EXPECT_NE(received_data.second, frame_data);
+
+    // Nothing else to read.
+    EXPECT_TRUE(ring_buffer.read().first == NULL);
+
+    ring_buffer.release(received_data.first->buffer_slot_index);
+    EXPECT_TRUE(ring_buffer.is_empty());
+
+    EXPECT_THROW(ring_buffer.release(received_data.first->buffer_slot_index), runtime_error);
+    EXPECT_THROW(ring_buffer.release(3), runtime_error);
+}
+
+TEST(RingBuffer, full_buffer)
+{
+    RingBuffer ring_buffer(2);
+
+    char frame_data[] = {1, 2, 3, 4};
+
+    for (uint64_t frame_index=0; frame_index<2; frame_index++) {
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = frame_index;
+        frame_metadata->frame_bytes_size = sizeof(frame_data);
+
+        ring_buffer.write(frame_metadata, frame_data);
+    }
+
+    auto frame_metadata = make_shared<FrameMetadata>();
+    frame_metadata->frame_index = 2;
+    frame_metadata->frame_bytes_size = sizeof(frame_data);
+
+    EXPECT_THROW(ring_buffer.write(frame_metadata, frame_data), runtime_error);
+}
+
+TEST(RingBuffer, overflow_policies)
+{
+    char frame_data[] = {1, 2, 3, 4};
+
+    auto get_frame_metadata = [&](uint64_t frame_index){
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = frame_index;
+        frame_metadata->frame_bytes_size = sizeof(frame_data);
+        return frame_metadata;
+    };
+
+    // The frame written to a full buffer is discarded.
+    SpscRingBuffer drop_newest_buffer(2);
+    drop_newest_buffer.set_overflow_policy(RING_BUFFER_OVERFLOW_DROP_NEWEST);
+
+    EXPECT_TRUE(drop_newest_buffer.write(get_frame_metadata(0), frame_data));
+    EXPECT_TRUE(drop_newest_buffer.write(get_frame_metadata(1), frame_data));
+    EXPECT_FALSE(drop_newest_buffer.write(get_frame_metadata(2), frame_data));
+    EXPECT_EQ(drop_newest_buffer.get_overflow_statistics().n_dropped_newest_frames, 1u);
+    EXPECT_EQ(drop_newest_buffer.read().first->frame_index, 0u);
+
+    // The writer discards the oldest unread frame itself.
+    RingBuffer drop_oldest_buffer(2);
+    drop_oldest_buffer.set_overflow_policy(RING_BUFFER_OVERFLOW_DROP_OLDEST);
+
+    vector<uint64_t> dropped_frames;
+    drop_oldest_buffer.set_dropped_frame_callback([&](uint64_t frame_index){ dropped_frames.push_back(frame_index); });
+
+    for (uint64_t frame_index : {0, 1, 2}) {
+        drop_oldest_buffer.write(get_frame_metadata(frame_index), frame_data);
+    }
+
+    EXPECT_EQ(dropped_frames, vector<uint64_t>({0}));
+    EXPECT_EQ(drop_oldest_buffer.get_overflow_statistics().n_blocked_writes, 0u);
+
+    for (uint64_t frame_index : {1, 2}) {
+        auto received_data = drop_oldest_buffer.read();
+        EXPECT_EQ(received_data.first->frame_index, frame_index);
+        drop_oldest_buffer.release(received_data.first->buffer_slot_index);
+    }
+
+    // The slot the writer needs is held by the reader - one frame is dropped, then the writer waits for the slot.
+    SpscRingBuffer drop_oldest_held_buffer(2);
+    drop_oldest_held_buffer.set_overflow_policy(RING_BUFFER_OVERFLOW_DROP_OLDEST);
+
+    dropped_frames.clear();
+    drop_oldest_held_buffer.set_dropped_frame_callback([&](uint64_t frame_index){ dropped_frames.push_back(frame_index); });
+
+    drop_oldest_held_buffer.write(get_frame_metadata(0), frame_data);
+    drop_oldest_held_buffer.write(get_frame_metadata(1), frame_data);
+
+    auto received_data = drop_oldest_held_buffer.read();
+    thread drop_oldest_writer([&](){ drop_oldest_held_buffer.write(get_frame_metadata(2), frame_data); });
+
+    while (drop_oldest_held_buffer.get_overflow_statistics().n_blocked_writes == 0) {
+        this_thread::yield();
+    }
+
+    drop_oldest_held_buffer.release(received_data.first->buffer_slot_index);
+    drop_oldest_writer.join();
+
+    EXPECT_EQ(dropped_frames, vector<uint64_t>({1}));
+    EXPECT_EQ(drop_oldest_held_buffer.get_overflow_statistics().n_dropped_oldest_frames, 1u);
+
+    received_data = drop_oldest_held_buffer.read();
+    EXPECT_EQ(received_data.first->frame_index, 2u);
+    drop_oldest_held_buffer.release(received_data.first->buffer_slot_index);
+
+    // The writer waits until the reader releases a slot.
+    MpscRingBuffer block_buffer(2);
+    block_buffer.set_overflow_policy(RING_BUFFER_OVERFLOW_BLOCK);
+
+    block_buffer.write(get_frame_metadata(0), frame_data);
+    block_buffer.write(get_frame_metadata(1), frame_data);
+
+    thread block_writer([&](){ block_buffer.write(get_frame_metadata(2), frame_data); });
+
+    while (block_buffer.get_overflow_statistics().n_blocked_writes == 0) {
+        this_thread::yield();
+    }
+
+    received_data = block_buffer.read();
+    block_buffer.release(received_data.first->buffer_slot_index);
+    block_writer.join();
+
+    for (uint64_t frame_index : {1, 2}) {
+        received_data = block_buffer.read();
+        EXPECT_EQ(received_data.first->frame_index, frame_index);
+        block_buffer.release(received_data.first->buffer_slot_index);
+    }
+}
+
+TEST(RingBuffer, spill_buffer)
+{
+    SpscRingBuffer ring_buffer(2);
+    ring_buffer.set_spill_buffer(unique_ptr<SpillBuffer>(new SpillBuffer("ignore_spill_buffer.bin", 3 * 4096, 2)), 1);
+
+    char frame_data[100];
+
+    // The first frame goes to the slots, the others to the spill file - it fits 3 of them.
+    for (uint64_t frame_index=0; frame_index<5; frame_index++) {
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = frame_index;
+        frame_metadata->frame_bytes_size = sizeof(frame_data);
+
+        memset(frame_data, frame_index, sizeof(frame_data));
+        ring_buffer.write(frame_metadata, frame_data);
+    }
+
+    auto spill_statistics = ring_buffer.get_spill_statistics();
+    EXPECT_EQ(spill_statistics.n_slots, 3u);
+    EXPECT_EQ(spill_statistics.n_spilled_frames, 3u);
+    EXPECT_EQ(ring_buffer.get_n_used_slots(), 2u);
+
+    // The spill file was full for frame 4, it is read before the spilled frames.
+    vector<uint64_t> frames_order;
+
+    while (!ring_buffer.is_empty()) {
+        auto received_data = ring_buffer.read();
+
+        EXPECT_EQ(received_data.second[99], static_cast<char>(received_data.first->frame_index));
+        frames_order.push_back(received_data.first->frame_index);
+
+        ring_buffer.release(received_data.first->buffer_slot_index);
+    }
+
+    EXPECT_EQ(frames_order, vector<uint64_t>({0, 4, 1, 2, 3}));
+    EXPECT_EQ(ring_buffer.get_spill_statistics().max_used_slots, 3u);
+}
+
+TEST(RingBuffer, zero_copy_write)
+{
+    RingBuffer ring_buffer(2);
+
+    bool data_freed = false;
+    char* frame_data = new char[4]();
+
+    {
+        shared_ptr<char> owned_data(frame_data, [&data_freed](char* data){ 
+            delete[] data; 
+            data_freed = true; 
+        });
+
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = 0;
+        frame_metadata->frame_bytes_size = 4;
+
+        ring_buffer.write(frame_metadata, owned_data);
+    }
+
+    // The ring buffer slot keeps the data alive.
+    EXPECT_FALSE(data_freed);
+
+    auto received_data = ring_buffer.read();
+    ASSERT_TRUE(received_data.first != NULL);
+
+    // No copy was made.
+    EXPECT_EQ(received_data.second, frame_data);
+
+    ring_buffer.release(received_data.first->buffer_slot_index);
+
+    EXPECT_TRUE(data_freed);
+    EXPECT_TRUE(ring_buffer.is_empty());
+}
+
+TEST(SpscRingBuffer, write_read_release)
+{
+    SpscRingBuffer ring_buffer(2);
+
+    EXPECT_TRUE(ring_buffer.is_empty());
+    EXPECT_TRUE(ring_buffer.read().first == NULL);
+
+    char frame_data[] = {1, 2, 3, 4};
+
+    for (uint64_t frame_index=0; frame_index<2; frame_index++) {
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = frame_index;
+        frame_metadata->frame_bytes_size = sizeof(frame_data);
+
+        ring_buffer.write(frame_metadata, frame_data);
+    }
+
+    auto frame_metadata = make_shared<FrameMetadata>();
+    frame_metadata->frame_index = 2;
+    frame_metadata->frame_bytes_size = sizeof(frame_data);
+
+    EXPECT_THROW(ring_buffer.write(frame_metadata, frame_data), runtime_error);
+
+    auto first_frame = ring_buffer.read();
+    auto second_frame = ring_buffer.read();
+    ASSERT_TRUE(first_frame.first != NULL);
+    ASSERT_TRUE(second_frame.first != NULL);
+    EXPECT_EQ(first_frame.first->frame_index, 0u);
+    EXPECT_EQ(second_frame.first->frame_index, 1u);
+    EXPECT_EQ(memcmp(second_frame.second, frame_data, sizeof(frame_data)), 0);
+
+    // Slots can be released out of order.
+    ring_buffer.release(second_frame.first->buffer_slot_index);
+    EXPECT_FALSE(ring_buffer.is_empty());
+    ring_buffer.release(first_frame.first->buffer_slot_index);
+    EXPECT_TRUE(ring_buffer.is_empty());
+
+    EXPECT_THROW(ring_buffer.release(first_frame.first->buffer_slot_index), runtime_error);
+
+    EXPECT_NO_THROW(ring_buffer.write(frame_metadata, frame_data));
+}
+
+TEST(SpscRingBuffer, producer_consumer)
+{
+    size_t n_slots = 4;
+    uint64_t n_frames = 10000;
+    SpscRingBuffer ring_buffer(n_slots);
+
+    atomic<uint64_t> n_released_frames(0);
+
+    thread producer([&](){
+        for (uint64_t frame_index=0; frame_index<n_frames; frame_index++) {
+            while (frame_index - n_released_frames.load() >= n_slots) {
+                this_thread::yield();
+            }
+
+            auto frame_metadata = make_shared<FrameMetadata>();
+            frame_metadata->frame_index = frame_index;
+            frame_metadata->frame_bytes_size = sizeof(frame_index);
+
+            ring_buffer.write(frame_metadata, reinterpret_cast<char*>(&frame_index));
+        }
+    });
+
+    for (uint64_t frame_index=0; frame_index<n_frames;) {
+        auto received_data = ring_buffer.read();
+
+        if (!received_data.first) {
+            this_thread::yield();
+            continue;
+        }
+
+        ASSERT_EQ(received_data.first->frame_index, frame_index);
+        ASSERT_EQ(*reinterpret_cast<uint64_t*>(received_data.second), frame_index);
+
+        ring_buffer.release(received_data.first->buffer_slot_index);
+        n_released_frames++;
+        frame_index++;
+    }
+
+    producer.join();
+
+    EXPECT_TRUE(ring_buffer.is_empty());
+}
+
+TEST(RingBuffer, read_wait)
+{
+    SpscRingBuffer ring_buffer(2);
+
+    // Nothing to read - wait for the timeout.
+    auto start_time = chrono::steady_clock::now();
+    EXPECT_TRUE(ring_buffer.read_wait(20).first == NULL);
+    EXPECT_GE(chrono::steady_clock::now() - start_time, chrono::milliseconds(20));
+
+    uint64_t frame_index = 5;
+
+    thread producer([&](){
+        this_thread::sleep_for(chrono::milliseconds(10));
+
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = frame_index;
+        frame_metadata->frame_bytes_size = sizeof(frame_index);
+
+        ring_buffer.write(frame_metadata, reinterpret_cast<char*>(&frame_index));
+    });
+
+    // The writer wakes us up long before the timeout.
+    start_time = chrono::steady_clock::now();
+    auto received_data = ring_buffer.read_wait(10000);
+    EXPECT_LT(chrono::steady_clock::now() - start_time, chrono::milliseconds(5000));
+
+    producer.join();
+
+    ASSERT_TRUE(received_data.first != NULL);
+    EXPECT_EQ(received_data.first->frame_index, frame_index);
+    ring_buffer.release(received_data.first->buffer_slot_index);
+}
+
+TEST(RingBuffer, shutdown)
+{
+    RingBuffer ring_buffer(2);
+
+    thread stopper([&](){
+        this_thread::sleep_for(chrono::milliseconds(10));
+        ring_buffer.shutdown();
+    });
+
+    auto start_time = chrono::steady_clock::now();
+    EXPECT_TRUE(ring_buffer.read_wait(10000).first == NULL);
+    EXPECT_LT(chrono::steady_clock::now() - start_time, chrono::milliseconds(5000));
+
+    stopper.join();
+
+    // After the shutdown, read_wait does not block anymore.
+    start_time = chrono::steady_clock::now();
+    EXPECT_TRUE(ring_buffer.read_wait(10000).first == NULL);
+    EXPECT_LT(chrono::steady_clock::now() - start_time, chrono::milliseconds(5000));
+}
+
+TEST(MpscRingBuffer, producers_consumer)
+{
+    size_t n_slots = 8;
+    uint64_t n_producers = 4;
+    uint64_t n_frames_per_producer = 5000;
+    MpscRingBuffer ring_buffer(n_slots);
+
+    // The ring buffer throws when full - keep at most n_slots frames in flight.
+    atomic<size_t> n_frames_in_flight(0);
+    vector<thread> producers;
+
+    for (uint64_t producer_index=0; producer_index<n_producers; producer_index++) {
+        producers.emplace_back([&, producer_index](){
+            for (uint64_t frame=0; frame<n_frames_per_producer; frame++) {
+                size_t in_flight = n_frames_in_flight.load();
+                while (in_flight >= n_slots || !n_frames_in_flight.compare_exchange_weak(in_flight, in_flight + 1)) {
+                    this_thread::yield();
+                    in_flight = n_frames_in_flight.load();
+                }
+
+                uint64_t frame_index = (frame * n_producers) + producer_index;
+
+                auto frame_metadata = make_shared<FrameMetadata>();
+                frame_metadata->frame_index = frame_index;
+                frame_metadata->frame_bytes_size = sizeof(frame_index);
+
+                ring_buffer.write(frame_metadata, reinterpret_cast<char*>(&frame_index));
+            }
+        });
+    }
+
+    // Each producer's frames are read in its write order.
+    vector<uint64_t> next_frame_index(n_producers);
+    for (uint64_t producer_index=0; producer_index<n_producers; producer_index++) {
+        next_frame_index[producer_index] = producer_index;
+    }
+
+    for (uint64_t n_read_frames=0; n_read_frames<n_producers*n_frames_per_producer;) {
+        auto received_data = ring_buffer.read();
+
+        if (!received_data.first) {
+            this_thread::yield();
+            continue;
+        }
+
+        auto frame_index = received_data.first->frame_index;
+        ASSERT_EQ(*reinterpret_cast<uint64_t*>(received_data.second), frame_index);
+        ASSERT_EQ(frame_index, next_frame_index[frame_index % n_producers]);
+        next_frame_index[frame_index % n_producers] += n_producers;
+
+        ring_buffer.release(received_data.first->buffer_slot_index);
+        n_frames_in_flight--;
+        n_read_frames++;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    EXPECT_TRUE(ring_buffer.is_empty());
+}
+
+TEST(RingBuffer, memory_options)
+{
+    RingBufferMemoryOptions memory_options;
+    // Falls back to normal pages if no hugepages are reserved.
+    memory_options.hugepage_size = RING_BUFFER_HUGEPAGE_2MB;
+    memory_options.lock_memory = true;
+    memory_options.prefault = true;
+    memory_options.numa_node = RING_BUFFER_NUMA_NODE_LOCAL;
+    // The 1000 byte frames are in 4096 byte slots.
+    memory_options.slot_alignment = 4096;
+
+    SpscRingBuffer ring_buffer(10, memory_options);
+
+    char frame_data[1000];
+    for (size_t i=0; i<sizeof(frame_data); i++) {
+        frame_data[i] = i % 128;
+    }
+
+    for (uint64_t frame_index=0; frame_index<25; frame_index++) {
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = frame_index;
+        frame_metadata->frame_bytes_size = sizeof(frame_data);
+
+        ring_buffer.write(frame_metadata, frame_data);
+
+        auto received_data = ring_buffer.read();
+        ASSERT_TRUE(received_data.first != NULL);
+        EXPECT_EQ(received_data.first->frame_index, frame_index);
+        EXPECT_EQ(memcmp(received_data.second, frame_data, sizeof(frame_data)), 0);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(received_data.second) % 4096, 0u);
+
+        ring_buffer.release(received_data.first->buffer_slot_index);
+    }
+
+    EXPECT_EQ(RingBufferMemory::get_network_interface_numa_node("no_such_interface"), -1);
+}
@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+#include "../src/VirtualDataset.hpp"
+#include "../src/H5Writer.hpp"
+
+using namespace std;
+
+TEST(VirtualDataset, get_master_filename)
+{
+    EXPECT_EQ(VirtualDatasetUtils::get_filename("/data/run_%d.h5", 3), "/data/run_3.h5");
+    EXPECT_EQ(VirtualDatasetUtils::get_master_filename("/data/run_%d.h5"), "/data/run_master.h5");
+    EXPECT_THROW(VirtualDatasetUtils::get_master_filename("/data/run.h5"), runtime_error);
+}
+
+TEST(VirtualDataset, striped_files)
+{
+    vector<size_t> frame_shape = {2};
+    size_t frame_bytes_size = 2 * sizeof(uint16_t);
+    size_t n_writers = 3;
+    size_t n_frames = 10;
+
+    vector<VirtualDatasetSource> sources;
+
+    for (size_t stripe_index=0; stripe_index<n_writers; stripe_index++) {
+        auto filename = VirtualDatasetUtils::get_filename("ignore_stripe_%d.h5", stripe_index + 1);
+        H5Writer writer(filename, 0, 4, 4);
+
+        size_t stripe_n_frames = 0;
+        for (size_t frame_index=stripe_index; frame_index<n_frames; frame_index+=n_writers) {
+            uint16_t frame_data[2] = {static_cast<uint16_t>(frame_index), static_cast<uint16_t>(frame_index + 100)};
+
+            writer.write_data("data", frame_index / n_writers, reinterpret_cast<char*>(frame_data), frame_shape, 
+                frame_bytes_size, "uint16", "little");
+
+            stripe_n_frames++;
+        }
+
+        sources.push_back({filename, stripe_n_frames, stripe_index, n_writers});
+    }
+
+    {
+        H5::H5File master_file(VirtualDatasetUtils::get_master_filename("ignore_stripe_%d.h5").c_str(), H5F_ACC_TRUNC);
+        VirtualDatasetUtils::create_virtual_dataset(master_file, {"raw_data", "data", frame_shape, "uint16", "little"}, sources);
+    }
+
+    H5::H5File input_file("ignore_stripe_master.h5", H5F_ACC_RDONLY);
+    auto dataset = input_file.openDataSet("raw_data");
+
+    hsize_t dataset_dimensions[2];
+    dataset.getSpace().getSimpleExtentDims(dataset_dimensions);
+    ASSERT_EQ(dataset_dimensions[0], n_frames);
+
+    uint16_t data[10][2];
+    dataset.read(data, H5::PredType::NATIVE_UINT16);
+
+    for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+        ASSERT_EQ(data[frame_index][0], frame_index);
+        ASSERT_EQ(data[frame_index][1], frame_index + 100);
+    }
+}
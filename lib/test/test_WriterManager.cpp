@@ -0,0 +1,127 @@
+#include "gtest/gtest.h"
+
+#include "../src/WriterManager.hpp"
+#include "../src/RingBuffer.hpp"
+#include "../src/RestApi.hpp"
+
+using namespace std;
+
+TEST(WriterManager, missing_frames)
+{
+    unordered_map<string, DATA_TYPE> parameters_type;
+    WriterManager writer_manager(parameters_type, "ignore_missing_frames.h5");
+
+    for (uint64_t frame_index : {0, 1, 4, 2, 9, 10, 15}) {
+        writer_manager.received_frame(frame_index);
+    }
+
+    // Already missing, or received.
+    writer_manager.lost_frames(3, 4);
+
+    vector<pair<uint64_t, uint64_t>> expected_missing_frames = {{3, 3}, {5, 8}, {11, 14}};
+    EXPECT_EQ(writer_manager.get_missing_frames(), expected_missing_frames);
+    EXPECT_EQ(writer_manager.get_statistics()["n_lost_frames"], 9u);
+
+    // Late frames fill the gaps.
+    writer_manager.received_frame(3);
+    writer_manager.received_frame(6);
+
+    expected_missing_frames = {{5, 5}, {7, 8}, {11, 14}};
+    EXPECT_EQ(writer_manager.get_missing_frames(), expected_missing_frames);
+    EXPECT_EQ(writer_manager.get_statistics()["n_lost_frames"], 7u);
+    EXPECT_EQ(writer_manager.get_statistics()["n_received_frames"], 9u);
+
+    // A large gap is counted in one step - only the frames not received yet.
+    writer_manager.lost_frames(12, 1000000000);
+
+    expected_missing_frames = {{5, 5}, {7, 8}, {11, 14}, {16, 1000000000}};
+    EXPECT_EQ(writer_manager.get_missing_frames(), expected_missing_frames);
+    EXPECT_EQ(writer_manager.get_statistics()["n_lost_frames"], 7u + 1000000000u - 15u);
+}
+
+TEST(WriterManager, dropped_frames)
+{
+    unordered_map<string, DATA_TYPE> parameters_type;
+    WriterManager writer_manager(parameters_type, "ignore_dropped_frames.h5");
+
+    writer_manager.received_frame(0);
+    writer_manager.received_frame(1);
+
+    // Dropped on write, and dropped by the reader before the receiver reported it.
+    writer_manager.dropped_frame(1);
+    writer_manager.dropped_frame(2);
+    writer_manager.received_frame(2);
+    writer_manager.received_frame(3);
+
+    vector<pair<uint64_t, uint64_t>> expected_missing_frames = {{1, 2}};
+    EXPECT_EQ(writer_manager.get_missing_frames(), expected_missing_frames);
+    EXPECT_EQ(writer_manager.get_statistics()["n_received_frames"], 4u);
+
+    // Another receiver moved past frame 5 before it was dropped and reported.
+    writer_manager.received_frame(6);
+    writer_manager.dropped_frame(5);
+    writer_manager.received_frame(5);
+    writer_manager.received_frame(4);
+
+    expected_missing_frames = {{1, 2}, {5, 5}};
+    EXPECT_EQ(writer_manager.get_missing_frames(), expected_missing_frames);
+    EXPECT_EQ(writer_manager.get_statistics()["n_lost_frames"], 3u);
+    EXPECT_EQ(writer_manager.get_statistics()["n_dropped_frames"], 3u);
+}
+
+TEST(WriterManager, status_after_dropped_frame)
+{
+    unordered_map<string, DATA_TYPE> parameters_type;
+    WriterManager writer_manager(parameters_type, "ignore_status_after_dropped_frame.h5");
+
+    writer_manager.received_frame(0);
+    writer_manager.received_frame(1);
+    writer_manager.written_frame(0, 100);
+    writer_manager.stop();
+
+    EXPECT_EQ(writer_manager.get_status(), "writing");
+
+    // The dropped frame will never be written.
+    writer_manager.dropped_frame(1);
+
+    EXPECT_EQ(writer_manager.get_status(), "finished");
+}
+
+TEST(WriterManager, metrics)
+{
+    unordered_map<string, DATA_TYPE> parameters_type;
+    WriterManager writer_manager(parameters_type, "ignore_metrics.h5");
+
+    RingBuffer ring_buffer(10);
+    writer_manager.set_ring_buffers({&ring_buffer});
+
+    char frame_data[16] = {};
+    for (uint64_t frame_index=0; frame_index<3; frame_index++) {
+        auto frame_metadata = make_shared<FrameMetadata>();
+        frame_metadata->frame_index = frame_index;
+        frame_metadata->frame_bytes_size = sizeof(frame_data);
+
+        ring_buffer.write(frame_metadata, frame_data);
+        writer_manager.received_frame(frame_index);
+    }
+
+    auto received_data = ring_buffer.read();
+    ring_buffer.release(received_data.first->buffer_slot_index);
+    writer_manager.written_frame(received_data.first->frame_index, received_data.first->frame_bytes_size);
+    writer_manager.set_file_index(2);
+
+    auto metrics = writer_manager.get_metrics();
+    EXPECT_EQ(metrics["n_written_frames"], 1);
+    EXPECT_EQ(metrics["n_written_bytes"], 16);
+    EXPECT_EQ(metrics["file_index"], 2);
+    EXPECT_EQ(metrics["ring_buffer_slots"], 10);
+    EXPECT_EQ(metrics["ring_buffer_used_slots"], 2);
+    EXPECT_EQ(metrics["ring_buffer_max_used_slots"], 3);
+    // Rates are left to the scraper.
+    EXPECT_EQ(metrics.count("frame_rate"), 0u);
+
+    auto metrics_text = RestApi::get_metrics_text(writer_manager, true);
+    EXPECT_NE(metrics_text.find("# TYPE h5_writer_written_bytes counter\nh5_writer_written_bytes_total 16\n"), string::npos);
+    EXPECT_NE(metrics_text.find("h5_writer_ring_buffer_max_used_slots 3\n"), string::npos);
+    EXPECT_EQ(metrics_text.substr(metrics_text.size() - 6), "# EOF\n");
+}
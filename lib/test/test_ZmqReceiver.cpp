@@ -34,12 +34,6 @@ TEST(ZmqReceiver, get_value_from_json)
 
   uint64_t frame_number = 1234567890;
   json_header.add("frame_number", frame_number);
-  HeaderDataType header_data_type_scalar("uint64");
-  
-  auto scalar_buffer = get_value_from_json(json_header, "frame_number", header_data_type_scalar);
-  auto scalar_value = reinterpret_cast<uint64_t*>(scalar_buffer.get());
-  
-  ASSERT_TRUE(*scalar_value == frame_number);
 
   double modules_number[] = {-345.12, 1234567.43, -2323456.32};
   pt::ptree modulus_number_child;
@@ -52,16 +46,52 @@ TEST(ZmqReceiver, get_value_from_json)
 
   json_header.add_child("modules_number", modulus_number_child);
 
-  HeaderDataType header_data_type_array("float64", 3);
+  HeaderDecodePlan header_decode_plan(shared_ptr<unordered_map<string, HeaderDataType>>(new unordered_map<string, HeaderDataType> {
+      {"frame_number", HeaderDataType("uint64")},
+      {"modules_number", HeaderDataType("float64", 3)}
+  }));
+
+  vector<char> header_values_record(header_decode_plan.get_record_bytes_size());
+
+  const auto& scalar_field = header_decode_plan.get_field("frame_number");
+  get_value_from_json(json_header, scalar_field, header_values_record.data());
+  auto scalar_value = reinterpret_cast<uint64_t*>(header_values_record.data() + scalar_field.offset);
   
-  auto array_buffer = get_value_from_json(json_header, "modules_number", header_data_type_array);
-  auto array_values = reinterpret_cast<double*>(array_buffer.get());
+  ASSERT_TRUE(*scalar_value == frame_number);
+
+  const auto& array_field = header_decode_plan.get_field("modules_number");
+  get_value_from_json(json_header, array_field, header_values_record.data());
+  auto array_values = reinterpret_cast<double*>(header_values_record.data() + array_field.offset);
 
   for (int i=0; i<3; i++) {
     ASSERT_TRUE(array_values[i] == modules_number[i]);
   }
 }
 
+TEST(ZmqReceiver, HeaderDecodePlan)
+{
+  HeaderDecodePlan header_decode_plan(shared_ptr<unordered_map<string, HeaderDataType>>(new unordered_map<string, HeaderDataType> {
+      {"pulse_id", HeaderDataType("uint64")},
+      {"module_number", HeaderDataType("uint16", 3)},
+      {"daq_rec", HeaderDataType("int32")}
+  }));
+
+  ASSERT_EQ(header_decode_plan.get_fields().size(), 3u);
+  ASSERT_EQ(header_decode_plan.get_record_bytes_size(), 4u + 6u + 8u);
+
+  // Fields are laid out in name order.
+  ASSERT_EQ(header_decode_plan.get_field("daq_rec").offset, 0u);
+  ASSERT_EQ(header_decode_plan.get_field("module_number").offset, 4u);
+  ASSERT_EQ(header_decode_plan.get_field("pulse_id").offset, 10u);
+  ASSERT_EQ(header_decode_plan.get_field("pulse_id").type, HEADER_UINT64);
+
+  ASSERT_TRUE(header_decode_plan.find_field("pulse", 5) == NULL);
+  EXPECT_THROW(header_decode_plan.get_field("missing"), runtime_error);
+
+  HeaderDecodePlan empty_plan(NULL);
+  ASSERT_EQ(empty_plan.get_record_bytes_size(), 0u);
+}
+
 TEST(ZmqReceiver, read_json_header)
 {
   int n_modules = 1;
@@ -104,6 +134,7 @@ TEST(ZmqReceiver, read_json_header)
                         "\"htype\":\"array-1.0\"}";
 
   auto metadata = receiver.read_json_header(header_string);
+  auto header_decode_plan = receiver.get_header_decode_plan();
 
   ASSERT_TRUE(metadata->frame_index == 0);
   ASSERT_TRUE(metadata->endianness == "little");
@@ -111,39 +142,112 @@ TEST(ZmqReceiver, read_json_header)
   ASSERT_TRUE(metadata->frame_shape[0] == 512);
   ASSERT_TRUE(metadata->frame_shape[1] == 1024);
 
-  auto pulse_id = reinterpret_cast<uint64_t*>(metadata->header_values.at("pulse_id").get());
+  auto pulse_id = reinterpret_cast<uint64_t*>(metadata->header_values.data() + header_decode_plan->get_field("pulse_id").offset);
   ASSERT_TRUE(pulse_id[0] == 6021771850);
 
-  auto frame = reinterpret_cast<uint64_t*>(metadata->header_values.at("frame").get());
+  auto frame = reinterpret_cast<uint64_t*>(metadata->header_values.data() + header_decode_plan->get_field("frame").offset);
   ASSERT_TRUE(frame[0] == 0);
 
-  auto is_good_frame = reinterpret_cast<uint64_t*>(metadata->header_values.at("is_good_frame").get());
+  auto is_good_frame = reinterpret_cast<uint64_t*>(metadata->header_values.data() + header_decode_plan->get_field("is_good_frame").offset);
   ASSERT_TRUE(is_good_frame[0] == 1);
 
-  auto daq_rec = reinterpret_cast<int64_t*>(metadata->header_values.at("daq_rec").get());
+  auto daq_rec = reinterpret_cast<int64_t*>(metadata->header_values.data() + header_decode_plan->get_field("daq_rec").offset);
   ASSERT_TRUE(daq_rec[0] == -1);
 
-  auto pulse_id_diff = reinterpret_cast<int64_t*>(metadata->header_values.at("pulse_id_diff").get());
+  auto pulse_id_diff = reinterpret_cast<int64_t*>(metadata->header_values.data() + header_decode_plan->get_field("pulse_id_diff").offset);
   ASSERT_TRUE(pulse_id_diff[0] == -1);
 
-  auto framenum_diff = reinterpret_cast<int64_t*>(metadata->header_values.at("framenum_diff").get());
+  auto framenum_diff = reinterpret_cast<int64_t*>(metadata->header_values.data() + header_decode_plan->get_field("framenum_diff").offset);
   ASSERT_TRUE(framenum_diff[0] == -2);
 
-  auto missing_packets_1 = reinterpret_cast<uint64_t*>(metadata->header_values.at("missing_packets_1").get());
+  auto missing_packets_1 = reinterpret_cast<uint64_t*>(metadata->header_values.data() + header_decode_plan->get_field("missing_packets_1").offset);
   ASSERT_TRUE(missing_packets_1[0] == 1);
 
-  auto missing_packets_2 = reinterpret_cast<uint64_t*>(metadata->header_values.at("missing_packets_2").get());
+  auto missing_packets_2 = reinterpret_cast<uint64_t*>(metadata->header_values.data() + header_decode_plan->get_field("missing_packets_2").offset);
   ASSERT_TRUE(missing_packets_2[0] == 2);
 
-  auto daq_recs = reinterpret_cast<uint64_t*>(metadata->header_values.at("daq_recs").get());
+  auto daq_recs = reinterpret_cast<uint64_t*>(metadata->header_values.data() + header_decode_plan->get_field("daq_recs").offset);
   ASSERT_TRUE(daq_recs[0] == 3840);
 
-  auto pulse_ids = reinterpret_cast<uint64_t*>(metadata->header_values.at("pulse_ids").get());
+  auto pulse_ids = reinterpret_cast<uint64_t*>(metadata->header_values.data() + header_decode_plan->get_field("pulse_ids").offset);
   ASSERT_TRUE(pulse_ids[0] == 6021771850);
 
-  auto framenums = reinterpret_cast<uint64_t*>(metadata->header_values.at("framenums").get());
+  auto framenums = reinterpret_cast<uint64_t*>(metadata->header_values.data() + header_decode_plan->get_field("framenums").offset);
   ASSERT_TRUE(framenums[0] == 193);
 
-  auto module_number = reinterpret_cast<uint64_t*>(metadata->header_values.at("module_number").get());
+  auto module_number = reinterpret_cast<uint64_t*>(metadata->header_values.data() + header_decode_plan->get_field("module_number").offset);
   ASSERT_TRUE(module_number[0] == 0);
-}
\ No newline at end of file
+}
+
+TEST(ZmqReceiver, parse_json_header)
+{
+  int n_modules = 2;
+
+  auto header_values = shared_ptr<unordered_map<string, HeaderDataType>>(new unordered_map<string, HeaderDataType> {
+      {"pulse_id", HeaderDataType("uint64")},
+      {"frame", HeaderDataType("uint64")},
+      {"daq_rec", HeaderDataType("int64")},
+      {"temperature", HeaderDataType("float32")},
+      {"framenum_diff", HeaderDataType("int64", n_modules)},
+      {"module_number", HeaderDataType("uint16", n_modules)}
+  });
+
+  ZmqReceiver receiver("something", 1, 1, header_values);
+
+  string header_string = "{ \"frame\" : 12,"
+                         "\"shape\":[ 512, 1024 ],\n"
+                         "\"pulse_id\":6021771850,"
+                         "\"daq_rec\":-1,"
+                         "\"temperature\":-12.5e1,"
+                         "\"ignored_object\":{\"a\":[1, {\"b\":\"}\"}], \"c\":null},"
+                         "\"ignored_string\":\"escaped \\\" quote\","
+                         "\"framenum_diff\":[-2, 3],"
+                         "\"module_number\":[0, 1],"
+                         "\"endianness\":\"big\","
+                         "\"type\":\"uint16\","
+                         "\"htype\":\"array-1.0\"}";
+
+  auto metadata = receiver.parse_json_header(header_string.c_str(), header_string.length());
+  auto reference_metadata = receiver.read_json_header(header_string);
+  auto header_decode_plan = receiver.get_header_decode_plan();
+
+  ASSERT_EQ(metadata->frame_index, 12u);
+  ASSERT_EQ(metadata->endianness, "big");
+  ASSERT_EQ(metadata->type, "uint16");
+  ASSERT_EQ(metadata->frame_shape, reference_metadata->frame_shape);
+
+  ASSERT_EQ(metadata->header_values, reference_metadata->header_values);
+
+  auto temperature = reinterpret_cast<float*>(metadata->header_values.data() + header_decode_plan->get_field("temperature").offset);
+  ASSERT_EQ(temperature[0], -125.0);
+
+  auto framenum_diff = reinterpret_cast<int64_t*>(metadata->header_values.data() + header_decode_plan->get_field("framenum_diff").offset);
+  ASSERT_EQ(framenum_diff[0], -2);
+  ASSERT_EQ(framenum_diff[1], 3);
+}
+
+TEST(ZmqReceiver, parse_json_header_errors)
+{
+  auto header_values = shared_ptr<unordered_map<string, HeaderDataType>>(new unordered_map<string, HeaderDataType> {
+      {"module_number", HeaderDataType("uint64", 2)}
+  });
+
+  ZmqReceiver receiver("something", 1, 1, header_values);
+
+  auto parse = [&receiver](const string& header) {
+    receiver.parse_json_header(header.c_str(), header.length());
+  };
+
+  EXPECT_NO_THROW(parse("{\"frame\":1,\"shape\":[2],\"type\":\"uint8\",\"module_number\":[1,2]}"));
+
+  // Missing header value.
+  EXPECT_THROW(parse("{\"frame\":1,\"shape\":[2],\"type\":\"uint8\"}"), runtime_error);
+  // Missing type.
+  EXPECT_THROW(parse("{\"frame\":1,\"shape\":[2],\"module_number\":[1,2]}"), runtime_error);
+  // Too many values.
+  EXPECT_THROW(parse("{\"frame\":1,\"shape\":[2],\"type\":\"uint8\",\"module_number\":[1,2,3]}"), runtime_error);
+  // Truncated header.
+  EXPECT_THROW(parse("{\"frame\":1,\"shape\":[2],\"type\":\"uint8\",\"module_number\":[1,2]"), runtime_error);
+  EXPECT_THROW(parse("{\"frame\":1,\"shape\":[2],\"type\":\"uint8"), runtime_error);
+  EXPECT_THROW(parse(""), runtime_error);
+}
@@ -3,6 +3,14 @@
 #include "test_H5Writer.cpp"
 #include "test_MetadataBuffer.cpp"
 #include "test_BufferedWriter.cpp"
+#include "test_RingBuffer.cpp"
+#include "test_CompressionPool.cpp"
+#include "test_FrameCompressor.cpp"
+#include "test_VirtualDataset.cpp"
+#include "test_FrameReorderWindow.cpp"
+#include "test_WriterManager.cpp"
+#include "test_LatencyMetrics.cpp"
+#include "test_H5FormatPlan.cpp"
 
 using namespace std;
 
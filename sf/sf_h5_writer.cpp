@@ -6,6 +6,7 @@
 #include "WriterManager.hpp"
 #include "ZmqReceiver.hpp"
 #include "ProcessManager.hpp"
+#include "MpscRingBuffer.hpp"
 
 #include "SfFormat.cpp"
 
@@ -76,9 +77,10 @@ int main (int argc, char *argv[])
 
     WriterManager writer_manager(format.get_input_value_type(), output_file, n_frames);
     ZmqReceiver receiver(connect_address, config::zmq_n_io_threads, config::zmq_receive_timeout, header_values);
-    RingBuffer ring_buffer(config::ring_buffer_n_slots);
+    // Multiple receivers need a multi producer ring buffer.
+    auto ring_buffer = get_ring_buffer(config::ring_buffer_n_slots, config::zmq_n_receivers, RingBufferMemory::get_config_options());
 
-    ProcessManager process_manager(writer_manager, receiver, ring_buffer, format, rest_port, bsread_rest_address, frames_per_file);
+    ProcessManager process_manager(writer_manager, receiver, *ring_buffer, format, rest_port, bsread_rest_address, frames_per_file);
     process_manager.run_writer();
 
     return 0;
@@ -3,6 +3,10 @@
 #include <stdexcept>
 #include <unistd.h>
 #include <string>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdlib>
+#include <sys/resource.h>
 
 #include "H5Writer.hpp"
 
@@ -32,34 +36,110 @@ void write_frame(H5Writer& writer, size_t index, char* buffer, size_t buffer_len
     }
 } 
 
-int main (int argc, char *argv[])
+float read_dataset(H5::H5File& file, const string& dataset_name, hsize_t frames_per_read)
 {
-    if (argc != 6) {
-        cout << endl;
-        cout << "Usage: h5_write_perf [output_file] [n_frames] [n_modules] [frame_rate] [n_metadata]" << endl;
-        cout << "\toutput_file: Name of the output file." << endl;
-        cout << "\tn_frames: Number of images to write." << endl;
-        cout << "\tn_modules: Numbers of 512*1024 modules." << endl;
-        cout << "\tframe_rate: Frame rate in Hz." << endl;
-        cout << "\tn_metadata: Number of metadata datasets to be written." << endl;
-        cout << endl;
+    auto dataset = file.openDataSet(dataset_name);
+    auto file_space = dataset.getSpace();
 
-        exit(-1);
+    int dataset_rank = file_space.getSimpleExtentNdims();
+    hsize_t dataset_dimension[dataset_rank];
+    file_space.getSimpleExtentDims(dataset_dimension);
+
+    hsize_t n_frames = dataset_dimension[0];
+    hsize_t frame_size = dataset.getDataType().getSize();
+    for (int index=1; index<dataset_rank; index++) {
+        frame_size *= dataset_dimension[index];
     }
 
-    string output_file = string(argv[1]);
-    int n_frames =  atoi(argv[2]);
-    int n_modules = atoi(argv[3]);
-    int frame_rate = atoi(argv[4]);
-    int n_metadata = atoi(argv[5]);
+    char* buffer = new char[frames_per_read * frame_size];
+
+    hsize_t count[dataset_rank];
+    hsize_t offset[dataset_rank];
+    for (int index=0; index<dataset_rank; index++) {
+        count[index] = dataset_dimension[index];
+        offset[index] = 0;
+    }
+
+    auto start_time = steady_clock::now();
+
+    for (hsize_t frame_index=0; frame_index<n_frames; frame_index+=frames_per_read) {
+        count[0] = min(frames_per_read, n_frames - frame_index);
+        offset[0] = frame_index;
+
+        file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+        H5::DataSpace memory_space(dataset_rank, count);
+
+        dataset.read(buffer, dataset.getDataType(), memory_space, file_space);
+    }
+
+    auto read_time = duration<float>(steady_clock::now() - start_time).count();
+
+    delete[] buffer;
+
+    // Throughput in MB/s.
+    return (n_frames * frame_size) / read_time / 1024 / 1024;
+}
+
+// User and system time of the process in seconds.
+double get_cpu_time()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// Profiles swept by "sweep" - 1MB is a typical RAID stripe.
+unordered_map<string, H5WriterIoProfile> get_io_profiles()
+{
+    unordered_map<string, H5WriterIoProfile> io_profiles;
+
+    io_profiles["default"] = H5WriterIoProfile();
+
+    io_profiles["aligned"].alignment = 1024 * 1024;
+    io_profiles["aligned"].alignment_threshold = 64 * 1024;
+
+    io_profiles["meta_block"].meta_block_size = 1024 * 1024;
+
+    io_profiles["paged"].page_size = 1024 * 1024;
+    io_profiles["paged"].page_buffer_size = 16 * 1024 * 1024;
+
+    io_profiles["latest"].latest_format = true;
+
+    io_profiles["metadata_cache"].metadata_cache_size = 64 * 1024 * 1024;
+
+    io_profiles["direct"].direct_io = true;
 
+    auto& all = io_profiles["all"];
+    all.alignment = 1024 * 1024;
+    all.alignment_threshold = 64 * 1024;
+    all.meta_block_size = 1024 * 1024;
+    all.page_size = 1024 * 1024;
+    all.page_buffer_size = 16 * 1024 * 1024;
+    all.latest_format = true;
+    all.metadata_cache_size = 64 * 1024 * 1024;
+
+    return io_profiles;
+}
+
+void run_profile(const string& output_file, const string& io_profile_name, const H5WriterIoProfile& io_profile, 
+    int n_frames, int n_modules, int frame_rate, int n_metadata, hsize_t frames_per_chunk)
+{
     size_t buffer_length = n_modules * 512 * 1024 * sizeof(u_int16_t);
-    char* buffer = new char[buffer_length];
+
+    // Like a ring buffer slot - direct I/O writes aligned buffers without the copy buffer.
+    void* aligned_buffer = NULL;
+    if (posix_memalign(&aligned_buffer, 4096, buffer_length) != 0) {
+        throw bad_alloc();
+    }
+    char* buffer = static_cast<char*>(aligned_buffer);
+    fill(buffer, buffer + buffer_length, 0);
    
-    size_t metadata_buffer_length = 4 * n_modules;
-    char* metadata_buffer = new char[metadata_buffer_length];
+    size_t metadata_buffer_length = sizeof(uint64_t) * n_modules;
+    char* metadata_buffer = new char[metadata_buffer_length]();
 
-    H5Writer writer(output_file, n_frames, n_frames, n_frames);
+    H5Writer writer(output_file, 0, n_frames, n_frames, frames_per_chunk);
+    writer.set_io_profile(io_profile);
 
     // Initialize all datasets;
     write_frame(writer, 0, buffer, buffer_length, metadata_buffer, metadata_buffer_length, n_metadata, n_modules);
@@ -67,6 +147,8 @@ int main (int argc, char *argv[])
     auto total_sleep_time = 0.0;
     auto total_write_time = 0.0;
     auto missed_frames = 0;
+
+    auto start_cpu_time = get_cpu_time();
     
     auto start_time_frame = std::chrono::system_clock::now();
     
@@ -75,7 +157,7 @@ int main (int argc, char *argv[])
         write_frame(writer, index, buffer, buffer_length, metadata_buffer, metadata_buffer_length, n_metadata, n_modules);
 
         auto time_diff = duration<float, milli>(std::chrono::system_clock::now() - start_time_frame).count();
-        auto sleep_time = (1.0/frame_rate*1000) - time_diff;
+        auto sleep_time = frame_rate ? (1.0/frame_rate*1000) - time_diff : 0;
 
         if (sleep_time < 0) {
             cout << "Not in time for frame " << index << endl;
@@ -91,10 +173,76 @@ int main (int argc, char *argv[])
         start_time_frame = std::chrono::system_clock::now();
     }
 
+    auto start_time_close = std::chrono::system_clock::now();
     writer.close_file();
+    auto close_time = duration<float, milli>(std::chrono::system_clock::now() - start_time_close).count();
+    total_write_time += close_time;
+
+    auto cpu_time = get_cpu_time() - start_cpu_time;
 
-    cout << "total sleep: " << total_sleep_time/1000 << " total write: " << total_write_time/1000;
+    free(buffer);
+    delete[] metadata_buffer;
+
+    cout << "io_profile: " << io_profile_name;
+    cout << " total sleep: " << total_sleep_time/1000 << " total write: " << total_write_time/1000;
+    cout << " close: " << close_time/1000;
     cout << " missed frames: " << missed_frames/float(n_frames)*100 << "%" <<endl;
+
+    auto written_bytes = float(n_frames) * (buffer_length + (n_metadata * metadata_buffer_length));
+    cout << "io_profile: " << io_profile_name << " frames_per_chunk: " << frames_per_chunk;
+    cout << " write: " << written_bytes / (total_write_time/1000) / 1024 / 1024 << " MB/s";
+    cout << " cpu: " << cpu_time / (total_write_time/1000) * 100 << "%" << endl;
+
+    // Read back the way an analysis would - 100 images at a time, complete metadata datasets.
+    H5::H5File input_file(output_file, H5F_ACC_RDONLY);
+    cout << "io_profile: " << io_profile_name << " read data: " << read_dataset(input_file, "data", 100) << " MB/s";
+    if (n_metadata > 0) {
+        cout << " read metadata: " << read_dataset(input_file, "0", n_frames) << " MB/s";
+    }
+    cout << endl;
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc < 6 || argc > 8) {
+        cout << endl;
+        cout << "Usage: h5_write_perf [output_file] [n_frames] [n_modules] [frame_rate] [n_metadata] [frames_per_chunk] [io_profile]" << endl;
+        cout << "\toutput_file: Name of the output file." << endl;
+        cout << "\tn_frames: Number of images to write." << endl;
+        cout << "\tn_modules: Numbers of 512*1024 modules." << endl;
+        cout << "\tframe_rate: Frame rate in Hz, 0 to write as fast as possible." << endl;
+        cout << "\tn_metadata: Number of metadata datasets to be written." << endl;
+        cout << "\tframes_per_chunk: Number of frames in each HDF5 chunk (optional, default 1)." << endl;
+        cout << "\tio_profile: default, aligned, meta_block, paged, latest, metadata_cache, all, direct or sweep ";
+        cout << "(all of them, one after the other - optional, default 'default')." << endl;
+        cout << endl;
+
+        exit(-1);
+    }
+
+    string output_file = string(argv[1]);
+    int n_frames =  atoi(argv[2]);
+    int n_modules = atoi(argv[3]);
+    int frame_rate = atoi(argv[4]);
+    int n_metadata = atoi(argv[5]);
+    hsize_t frames_per_chunk = argc >= 7 ? atoi(argv[6]) : 1;
+    string io_profile_name = argc == 8 ? string(argv[7]) : "default";
+
+    auto io_profiles = get_io_profiles();
+
+    if (io_profile_name == "sweep") {
+        for (const auto& name : {"default", "aligned", "meta_block", "paged", "latest", "metadata_cache", "all", "direct"}) {
+            run_profile(output_file, name, io_profiles[name], n_frames, n_modules, frame_rate, n_metadata, frames_per_chunk);
+        }
+
+    } else if (io_profiles.count(io_profile_name)) {
+        run_profile(output_file, io_profile_name, io_profiles[io_profile_name], 
+            n_frames, n_modules, frame_rate, n_metadata, frames_per_chunk);
+
+    } else {
+        cout << "Unknown io_profile " << io_profile_name << endl;
+        exit(-1);
+    }
     
     return 0;
 }
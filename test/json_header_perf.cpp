@@ -0,0 +1,97 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <chrono>
+
+#include "ZmqReceiver.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+string get_sf_header(uint64_t frame_index, int n_modules)
+{
+    auto module_values = [n_modules](int64_t value) {
+        stringstream values;
+        values << "[";
+        for (int module_index=0; module_index<n_modules; module_index++) {
+            values << (module_index ? "," : "") << value;
+        }
+        values << "]";
+
+        return values.str();
+    };
+
+    stringstream header;
+    header << "{\"missing_packets_2\":" << module_values(0) << ","
+           << "\"missing_packets_1\":" << module_values(0) << ","
+           << "\"frame\":" << frame_index << ","
+           << "\"daq_recs\":" << module_values(3840) << ","
+           << "\"module_number\":" << module_values(1) << ","
+           << "\"module_map\":" << module_values(1) << ","
+           << "\"shape\":[" << 512 * n_modules << ",1024],"
+           << "\"pulse_id\":" << 6021771850 + frame_index << ","
+           << "\"framenum_diff\":" << module_values(-2) << ","
+           << "\"pulse_ids\":" << module_values(6021771850 + frame_index) << ","
+           << "\"is_good_frame\":1,"
+           << "\"framenums\":" << module_values(193 + frame_index) << ","
+           << "\"pulse_id_diff\":" << module_values(-1) << ","
+           << "\"daq_rec\":-1,"
+           << "\"type\":\"uint16\","
+           << "\"htype\":\"array-1.0\"}";
+
+    return header.str();
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 3) {
+        cout << endl;
+        cout << "Usage: json_header_perf [n_headers] [n_modules]" << endl;
+        cout << "\tn_headers: Number of SF headers to parse." << endl;
+        cout << "\tn_modules: Numbers of modules in the header arrays." << endl;
+        cout << endl;
+
+        exit(-1);
+    }
+
+    int n_headers = atoi(argv[1]);
+    int n_modules = atoi(argv[2]);
+
+    auto header_values = shared_ptr<unordered_map<string, HeaderDataType>>(new unordered_map<string, HeaderDataType> {
+        {"pulse_id", HeaderDataType("uint64")},
+        {"frame", HeaderDataType("uint64")},
+        {"is_good_frame", HeaderDataType("uint64")},
+        {"daq_rec", HeaderDataType("int64")},
+        {"pulse_id_diff", HeaderDataType("int64", n_modules)},
+        {"framenum_diff", HeaderDataType("int64", n_modules)},
+        {"missing_packets_1", HeaderDataType("uint64", n_modules)},
+        {"missing_packets_2", HeaderDataType("uint64", n_modules)},
+        {"daq_recs", HeaderDataType("uint64", n_modules)},
+        {"pulse_ids", HeaderDataType("uint64", n_modules)},
+        {"framenums", HeaderDataType("uint64", n_modules)},
+        {"module_number", HeaderDataType("uint64", n_modules)},
+        {"module_map", HeaderDataType("int16", n_modules)},
+    });
+
+    ZmqReceiver receiver("tcp://127.0.0.1:40000", 1, 1, header_values);
+
+    auto header = get_sf_header(1234, n_modules);
+    cout << "Header size: " << header.length() << " bytes" << endl;
+
+    auto start_time = steady_clock::now();
+    for (int index=0; index<n_headers; index++) {
+        receiver.read_json_header(header);
+    }
+    auto ptree_time = duration<float, micro>(steady_clock::now() - start_time).count() / n_headers;
+
+    start_time = steady_clock::now();
+    for (int index=0; index<n_headers; index++) {
+        receiver.parse_json_header(header.c_str(), header.length());
+    }
+    auto parser_time = duration<float, micro>(steady_clock::now() - start_time).count() / n_headers;
+
+    cout << "read_json_header (ptree): " << ptree_time << " us/header" << endl;
+    cout << "parse_json_header: " << parser_time << " us/header" << endl;
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <chrono>
+
+#include "RingBuffer.hpp"
+#include "SpscRingBuffer.hpp"
+#include "MpscRingBuffer.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+float measure_ring_buffer(RingBuffer& ring_buffer, size_t n_frames, size_t frame_size, size_t n_slots)
+{
+    char* frame_data = new char[frame_size]();
+    
+    // The ring buffer throws when full - keep the producer within n_slots of the consumer.
+    atomic<size_t> n_released_frames(0);
+
+    auto start_time = steady_clock::now();
+
+    thread producer([&](){
+        for (size_t frame_index=0; frame_index<n_frames; frame_index++) {
+            
+            while (frame_index - n_released_frames.load() >= n_slots) {
+                this_thread::yield();
+            }
+
+            auto frame_metadata = make_shared<FrameMetadata>();
+            frame_metadata->frame_index = frame_index;
+            frame_metadata->frame_bytes_size = frame_size;
+
+            ring_buffer.write(frame_metadata, frame_data);
+        }
+    });
+
+    size_t n_read_frames = 0;
+    while (n_read_frames < n_frames) {
+        auto received_data = ring_buffer.read();
+
+        if (!received_data.first) {
+            this_thread::yield();
+            continue;
+        }
+
+        if (received_data.first->frame_index != n_read_frames) {
+            cout << "Frame order violated at frame " << n_read_frames << endl;
+        }
+
+        ring_buffer.release(received_data.first->buffer_slot_index);
+        n_released_frames++;
+        n_read_frames++;
+    }
+
+    producer.join();
+
+    auto total_time = duration<float, micro>(steady_clock::now() - start_time).count();
+
+    delete[] frame_data;
+
+    // Time per frame in ns.
+    return total_time * 1000 / n_frames;
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 4) {
+        cout << endl;
+        cout << "Usage: ring_buffer_perf [n_frames] [frame_size] [n_slots]" << endl;
+        cout << "\tn_frames: Number of frames to pass through the ring buffer." << endl;
+        cout << "\tframe_size: Size of each frame in bytes." << endl;
+        cout << "\tn_slots: Number of ring buffer slots." << endl;
+        cout << endl;
+
+        exit(-1);
+    }
+
+    size_t n_frames = stoul(argv[1]);
+    size_t frame_size = stoul(argv[2]);
+    size_t n_slots = stoul(argv[3]);
+
+    RingBuffer ring_buffer(n_slots);
+    auto mutex_time = measure_ring_buffer(ring_buffer, n_frames, frame_size, n_slots);
+
+    SpscRingBuffer spsc_ring_buffer(n_slots);
+    auto spsc_time = measure_ring_buffer(spsc_ring_buffer, n_frames, frame_size, n_slots);
+
+    MpscRingBuffer mpsc_ring_buffer(n_slots);
+    auto mpsc_time = measure_ring_buffer(mpsc_ring_buffer, n_frames, frame_size, n_slots);
+
+    cout << "RingBuffer: " << mutex_time << " ns/frame" << endl;
+    cout << "SpscRingBuffer: " << spsc_time << " ns/frame" << endl;
+    cout << "MpscRingBuffer: " << mpsc_time << " ns/frame" << endl;
+
+    return 0;
+}
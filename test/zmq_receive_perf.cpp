@@ -0,0 +1,157 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <zmq.hpp>
+
+#include "ZmqReceiver.hpp"
+#include "MpscRingBuffer.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+string get_header(uint64_t frame_index, size_t frame_size)
+{
+    stringstream header;
+    header << "{\"frame\":" << frame_index << ","
+           << "\"pulse_id\":" << 6021771850 + frame_index << ","
+           << "\"shape\":[" << frame_size / 2 << "],"
+           << "\"type\":\"uint16\","
+           << "\"htype\":\"array-1.0\"}";
+
+    return header.str();
+}
+
+// Local PUSH generator - one socket per receiver, frame i is sent by generator (i % n_generators).
+void generate_frames(const string& bind_address, size_t generator_index, size_t n_generators,
+    uint64_t n_frames, size_t frame_size, atomic<bool>& start_flag)
+{
+    zmq::context_t context(1);
+    zmq::socket_t sender(context, ZMQ_PUSH);
+    sender.bind(bind_address);
+
+    vector<char> frame_data(frame_size, 1);
+
+    while (!start_flag.load()) {
+        this_thread::yield();
+    }
+
+    for (uint64_t frame_index=generator_index; frame_index<n_frames; frame_index+=n_generators) {
+        auto header = get_header(frame_index, frame_size);
+
+        sender.send(header.c_str(), header.length(), ZMQ_SNDMORE);
+        sender.send(frame_data.data(), frame_data.size());
+    }
+
+    // The context waits for the queued frames to be sent before it is destroyed.
+}
+
+float measure_receivers(ZmqReceiver& first_receiver, size_t n_receivers, uint64_t n_frames, size_t frame_size,
+    size_t n_slots, uint16_t base_port)
+{
+    auto ring_buffer = get_ring_buffer(n_slots, n_receivers);
+
+    atomic<bool> start_flag(false);
+    atomic<uint64_t> n_received_frames(0);
+
+    vector<thread> generators;
+    vector<unique_ptr<ZmqReceiver>> receivers;
+    vector<thread> receiver_threads;
+
+    for (size_t receiver_index=0; receiver_index<n_receivers; receiver_index++) {
+        auto address = "tcp://127.0.0.1:" + to_string(base_port + receiver_index);
+
+        generators.emplace_back(generate_frames, address, receiver_index, n_receivers, n_frames, frame_size, ref(start_flag));
+
+        // The receivers share the header decode plan of the first one.
+        receivers.push_back(first_receiver.get_receiver(address));
+    }
+
+    for (auto& receiver : receivers) {
+        ZmqReceiver* stream_receiver = receiver.get();
+
+        receiver_threads.emplace_back([&, stream_receiver](){
+            stream_receiver->connect();
+
+            while (n_received_frames.load() < n_frames) {
+                auto frame = stream_receiver->receive_zero_copy();
+
+                if (!frame.first) {
+                    continue;
+                }
+
+                ring_buffer->write(frame.first, frame.second);
+                n_received_frames++;
+            }
+        });
+    }
+
+    this_thread::sleep_for(milliseconds(500));
+
+    auto start_time = steady_clock::now();
+    start_flag = true;
+
+    for (uint64_t n_read_frames=0; n_read_frames<n_frames;) {
+        auto received_data = ring_buffer->read_wait(100);
+
+        if (!received_data.first) {
+            continue;
+        }
+
+        ring_buffer->release(received_data.first->buffer_slot_index);
+        n_read_frames++;
+    }
+
+    auto total_time = duration<float>(steady_clock::now() - start_time).count();
+
+    for (auto& receiver_thread : receiver_threads) {
+        receiver_thread.join();
+    }
+
+    for (auto& generator : generators) {
+        generator.join();
+    }
+
+    // Received GB/s.
+    return (n_frames * frame_size) / total_time / 1e9;
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 4) {
+        cout << endl;
+        cout << "Usage: zmq_receive_perf [n_frames] [frame_size] [max_n_receivers]" << endl;
+        cout << "\tn_frames: Number of frames to send for each measurement." << endl;
+        cout << "\tframe_size: Size of each frame in bytes." << endl;
+        cout << "\tmax_n_receivers: Measure with 1 to max_n_receivers receiver threads, each with its own PUSH sender." << endl;
+        cout << endl;
+
+        exit(-1);
+    }
+
+    uint64_t n_frames = stoull(argv[1]);
+    size_t frame_size = stoul(argv[2]);
+    size_t max_n_receivers = stoul(argv[3]);
+
+    auto header_values = shared_ptr<unordered_map<string, HeaderDataType>>(new unordered_map<string, HeaderDataType> {
+        {"pulse_id", HeaderDataType("uint64")},
+        {"frame", HeaderDataType("uint64")},
+    });
+
+    ZmqReceiver first_receiver("", 1, 100, header_values);
+
+    for (size_t n_receivers=1; n_receivers<=max_n_receivers; n_receivers++) {
+        // New ports for each measurement - no waiting for the previous sockets to be released.
+        uint16_t base_port = 40100 + (n_receivers * 100);
+
+        auto throughput = measure_receivers(first_receiver, n_receivers, n_frames, frame_size, 1000, base_port);
+
+        cout << n_receivers << " receivers: " << throughput << " GB/s" << endl;
+    }
+
+    return 0;
+}